@@ -19,6 +19,7 @@
 #include "microej.h"
 #include "posix_time.h"
 #include "LLMJVM_impl.h"
+#include "microej_async_worker.h"
 #include <errno.h>
 
 #ifdef __cplusplus
@@ -38,7 +39,11 @@ extern "C"
 
 	void board_timerhook()
 	{
+#ifdef MICROEJ_ASYNC_WORKER_COMPLETION_RING_SIZE
+		if (vm_is_running && (nextWakeUpTicks <= clock_systimer() || MICROEJ_ASYNC_WORKER_completions_due()))
+#else
 		if (vm_is_running && nextWakeUpTicks <= clock_systimer())
+#endif
 		{
 			LLMJVM_schedule();
 		}
@@ -87,6 +92,10 @@ extern "C"
 	// Suspends the VM task if the pending flag is not set
 	int32_t LLMJVM_IMPL_idleVM()
 	{
+		// Resume the threads of the async jobs done meanwhile rather than sleeping until the wakeup they requested. The
+		// async jobs done from now on wake the VM task up.
+		MICROEJ_ASYNC_WORKER_set_vm_idle(true);
+		MICROEJ_ASYNC_WORKER_drain_completions();
 		while (sem_wait(&mutex) != 0)
 		{
 			if (errno == EINTR)
@@ -94,6 +103,7 @@ extern "C"
 				errno = 0;
 			}
 		}
+		MICROEJ_ASYNC_WORKER_set_vm_idle(false);
 		return LLMJVM_OK;
 	}
 
@@ -118,6 +128,8 @@ extern "C"
 	// Clear the pending wake up flag
 	int32_t LLMJVM_IMPL_ackWakeup()
 	{
+		// Resume in one batch the threads of the async jobs done since the last wakeup
+		MICROEJ_ASYNC_WORKER_drain_completions();
 		return LLMJVM_OK;
 	}
 
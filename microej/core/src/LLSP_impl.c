@@ -11,11 +11,38 @@ extern "C"
 {
 #endif
 #include <semaphore.h>
+#include <pthread.h>
 #include <assert.h>
 #include "LLSP_impl.h"
+#include "osal.h"
 
-    static sem_t rw_access_mutex;
+#ifndef LLSP_IMPL_LOCK_COUNT
+// Number of reader-writer locks shared by the blocks. Blocks mapped on different locks never contend.
+#define LLSP_IMPL_LOCK_COUNT (8)
+#endif
+
+    static OSAL_rwlock_storage_declare(block_locks_storage[LLSP_IMPL_LOCK_COUNT]);
+    static OSAL_rwlock_handle_t block_locks[LLSP_IMPL_LOCK_COUNT];
+    static pthread_once_t initialize_once = PTHREAD_ONCE_INIT;
     static sem_t task_mutex;
+
+    static void LLSP_IMPL_initialize_once(void)
+    {
+        for (int32_t i = 0; i < LLSP_IMPL_LOCK_COUNT; i++)
+        {
+            OSAL_status_t status = OSAL_rwlock_create_static((uint8_t *)"shielded plug", &block_locks_storage[i], &block_locks[i]);
+            assert(status == OSAL_OK);
+        }
+        int result = sem_init(&task_mutex, 0, 0); // initialize semaphore, LLSP_IMPL_wait() blocks until LLSP_IMPL_wakeup()
+        assert(result == 0);
+    }
+
+    // Lock protecting the given block: a (databaseID, blockID) pair is always mapped on the same lock.
+    static OSAL_rwlock_handle_t *LLSP_IMPL_block_lock(int32_t databaseID, int32_t blockID)
+    {
+        uint32_t hash = ((uint32_t)databaseID * 31u) + (uint32_t)blockID;
+        return &block_locks[hash % LLSP_IMPL_LOCK_COUNT];
+    }
     /**
  * Initialize Shielded Plug synchronization data.
  * This function may be called several times. It is not called from a thread safe context so several threads
@@ -24,11 +51,7 @@ extern "C"
  */
     void LLSP_IMPL_initialize(void)
     {
-        int result = sem_init(&rw_access_mutex, 0, 1); // initialize semaphore
-        assert(result == 0);
-        result = sem_init(&rw_access_mutex, 0, 1); // initialize semaphore
-        assert(result == 0);
-        return LLSP_OK;
+        pthread_once(&initialize_once, LLSP_IMPL_initialize_once);
     }
 
     /**
@@ -37,7 +60,7 @@ extern "C"
  */
     void LLSP_IMPL_syncWriteBlockEnter(int32_t databaseID, int32_t blockID)
     {
-        sem_wait(&rw_access_mutex);
+        OSAL_rwlock_write_take(LLSP_IMPL_block_lock(databaseID, blockID), OSAL_INFINITE_TIME);
     }
 
     /**
@@ -46,12 +69,7 @@ extern "C"
  */
     void LLSP_IMPL_syncWriteBlockExit(int32_t databaseID, int32_t blockID)
     {
-        int value;
-        sem_getvalue(&rw_access_mutex, &value);
-        if (value <= 0)
-        {
-            sem_post(&rw_access_mutex);
-        }
+        OSAL_rwlock_give(LLSP_IMPL_block_lock(databaseID, blockID));
     }
 
     /**
@@ -60,7 +78,7 @@ extern "C"
  */
     void LLSP_IMPL_syncReadBlockEnter(int32_t databaseID, int32_t blockID)
     {
-        sem_wait(&rw_access_mutex);
+        OSAL_rwlock_read_take(LLSP_IMPL_block_lock(databaseID, blockID), OSAL_INFINITE_TIME);
     }
 
     /**
@@ -69,12 +87,7 @@ extern "C"
  */
     void LLSP_IMPL_syncReadBlockExit(int32_t databaseID, int32_t blockID)
     {
-        int value;
-        sem_getvalue(&rw_access_mutex, &value);
-        if (value <= 0)
-        {
-            sem_post(&rw_access_mutex);
-        }
+        OSAL_rwlock_give(LLSP_IMPL_block_lock(databaseID, blockID));
     }
 
     /**
@@ -24,10 +24,25 @@ extern "C"
 #endif
 
 // TODO move in conf file
-#define FS_WORKER_JOB_COUNT (4)
+#define FS_WORKER_JOB_COUNT (8)
+// Number of job params of each size: operations on an open file or directory, path operations, I/O and rename
+#define FS_ID_PARAMS_COUNT (8)
+#define FS_PATH_PARAMS_COUNT (4)
+#define FS_LARGE_PARAMS_COUNT (2)
 #define FS_WAITING_LIST_SIZE (16)
 #define FS_WORKER_STACK_SIZE (512)
 #define FS_WORKER_PRIORITY (100)
+// Operations on different files run in parallel, operations on the same file or directory keep their order
+#define FS_WORKER_THREAD_COUNT (2)
+// Define FS_WRITE_BEHIND to return from the file writes of at most FS_IO_BUFFER_SIZE bytes before they are done:
+// a write error is then thrown by the next operation on the file or by its closing, and the path operations that modify
+// the file system (file open, create, delete, rename, make directory, set_*) wait for the pending write-behind writes
+// Maximum number of files with a pending write-behind error, one more error is thrown by the next operation on any file
+#define FS_LATCHED_ERROR_COUNT (4)
+// Define FS_JOB_TIMEOUT_MS to throw an IOException when an operation is not done within this delay (in milliseconds)
+// Define FS_THREAD_JOB_QUOTA to limit the number of FS jobs held by a Java thread, e.g. by its write-behind writes
+// (the threads waiting for a free job are resumed by priority only if MICROEJ_ASYNC_WORKER_JAVA_THREAD_PRIORITY() is defined)
+// Define FS_WORKER_CPU_AFFINITY to a CPU mask to pin the FS worker tasks (SMP only), e.g. away from the VM CPU
 #define FS_PATH_LENGTH (64)
 #define FS_IO_BUFFER_SIZE (128)
 
@@ -35,6 +50,13 @@ extern "C"
 	int32_t LLFS_set_path_param(uint8_t *path, uint8_t *path_param);
 	extern MICROEJ_ASYNC_WORKER_handle_t fs_worker;
 
+#ifdef FS_WRITE_BEHIND
+// The path operations are not keyed: those that modify the file system wait for the write-behind writes issued before them
+#define FS_WAIT_WRITE_BEHIND(_retry_function) MICROEJ_ASYNC_WORKER_wait_detached_jobs(&fs_worker, (SNI_callback)(_retry_function))
+#else
+#define FS_WAIT_WRITE_BEHIND(_retry_function) (MICROEJ_ASYNC_WORKER_OK)
+#endif
+
 	//TODO add comment on structure constraints
 
 	typedef struct
@@ -166,6 +188,43 @@ extern "C"
 		char *error_message;
 	} FS_available_t;
 
+	// Parameters of the combined calls, executed with MICROEJ_ASYNC_WORKER_async_exec_chain()
+	typedef struct
+	{
+		uint8_t path[FS_PATH_LENGTH];
+		uint8_t mode;
+		int32_t file_id;
+		uint8_t *data;
+		int32_t length;
+		int32_t result;
+		int32_t error_code;
+		char *error_message;
+		uint8_t buffer[FS_IO_BUFFER_SIZE];
+	} FS_file_transfer_t;
+
+	// Params of the operations on an open file or directory, see FS_ID_PARAMS_COUNT
+	typedef union {
+		FS_directory_operation_t directory_operation;
+		FS_close_directory_t close_directory;
+		FS_close_t close;
+		FS_skip_t skip;
+		FS_available_t available;
+	} FS_id_param_t;
+
+	// Params of the operations on a path, see FS_PATH_PARAMS_COUNT
+	typedef union {
+		FS_path_operation_t path_operation;
+		FS_path64_operation_t path64_operation;
+		FS_get_last_modified_t get_last_modified;
+		FS_create_t create;
+		FS_read_directory_t read_directory;
+		FS_set_last_modified_t set_last_modified;
+		FS_is_accessible_t is_accessible;
+		FS_set_permission_t set_permission;
+		FS_get_space_size get_space_size;
+		FS_open_t open;
+	} FS_path_param_t;
+
 	typedef union {
 		FS_path_operation_t path_operation;
 		FS_path64_operation_t path64_operation;
@@ -183,8 +242,46 @@ extern "C"
 		FS_close_t close;
 		FS_skip_t skip;
 		FS_available_t available;
+		FS_file_transfer_t file_transfer;
+		FS_get_space_size get_space_size;
 	} FS_worker_param_t;
 
+	/**
+	 * @brief Reads a whole file with a single round trip to the FS worker: open, read and close.
+	 *
+	 * Not part of the LLFS API: to be called from an application native. Suits small files, at most
+	 * FS_IO_BUFFER_SIZE bytes are read when the array is not immortal.
+	 *
+	 * @return the number of bytes read, LLFS_EOF if the file is empty. Throws an IOException on error.
+	 */
+	int32_t LLFS_File_IMPL_read_file(uint8_t *path, uint8_t *data, int32_t offset, int32_t length);
+
+	/**
+	 * @brief Writes a whole file with a single round trip to the FS worker: open with the given mode, write and close.
+	 *
+	 * Not part of the LLFS API: to be called from an application native. Suits small files, at most
+	 * FS_IO_BUFFER_SIZE bytes are written when the array is not immortal.
+	 *
+	 * @return the number of bytes written. Throws an IOException on error.
+	 */
+	int32_t LLFS_File_IMPL_write_file(uint8_t *path, uint8_t mode, uint8_t *data, int32_t offset, int32_t length);
+
+// SNI native of the application: static native int getWorkerStats(int[] stats) of the class ej.fs.FsWorkerNative
+#define LLFS_IMPL_get_worker_stats Java_ej_fs_FsWorkerNative_getWorkerStats
+
+	/**
+	 * @brief Copies the telemetry of the FS worker in an int array, see MICROEJ_ASYNC_WORKER_stats_to_array() for the layout.
+	 *
+	 * Not part of the LLFS API: SNI native of the application class ej.fs.FsWorkerNative. The telemetry is recorded
+	 * when CONFIG_MICROEJ_ASYNC_WORKER_TELEMETRY is enabled.
+	 *
+	 * @param[out] stats the Java int array.
+	 *
+	 * @return the number of values written. Throws an IOException if the array is too small or if the telemetry is
+	 * not recorded.
+	 */
+	int32_t LLFS_IMPL_get_worker_stats(int32_t *stats);
+
 void LLFS_IMPL_get_last_modified_action(MICROEJ_ASYNC_WORKER_job_t *job);
 void LLFS_IMPL_set_read_only_action(MICROEJ_ASYNC_WORKER_job_t *job);
 void LLFS_IMPL_create_action(MICROEJ_ASYNC_WORKER_job_t *job);
@@ -206,11 +303,17 @@ void LLFS_IMPL_set_permission_action(MICROEJ_ASYNC_WORKER_job_t *job);
 
 void LLFS_File_IMPL_open_action(MICROEJ_ASYNC_WORKER_job_t *job);
 void LLFS_File_IMPL_write_action(MICROEJ_ASYNC_WORKER_job_t *job);
+void LLFS_File_IMPL_write_behind_action(MICROEJ_ASYNC_WORKER_job_t *job);
 void LLFS_File_IMPL_read_action(MICROEJ_ASYNC_WORKER_job_t *job);
 void LLFS_File_IMPL_close_action(MICROEJ_ASYNC_WORKER_job_t *job);
 void LLFS_File_IMPL_skip_action(MICROEJ_ASYNC_WORKER_job_t *job);
 void LLFS_File_IMPL_available_action(MICROEJ_ASYNC_WORKER_job_t *job);
 
+void LLFS_File_IMPL_transfer_open_action(MICROEJ_ASYNC_WORKER_job_t *job);
+void LLFS_File_IMPL_transfer_read_action(MICROEJ_ASYNC_WORKER_job_t *job);
+void LLFS_File_IMPL_transfer_write_action(MICROEJ_ASYNC_WORKER_job_t *job);
+void LLFS_File_IMPL_transfer_close_action(MICROEJ_ASYNC_WORKER_job_t *job);
+
 #ifdef __cplusplus
 }
 #endif
@@ -38,10 +38,22 @@ extern "C"
 	static void LLFS_File_IMPL_close_on_done(int32_t file_id);
 	static int64_t LLFS_File_IMPL_skip_on_done(int32_t file_id, int64_t n);
 	static int32_t LLFS_File_IMPL_available_on_done(int32_t file_id);
+	static int32_t LLFS_File_IMPL_read_file_on_done(uint8_t *path, uint8_t *data, int32_t offset, int32_t length);
+	static int32_t LLFS_File_IMPL_write_file_on_done(uint8_t *path, uint8_t mode, uint8_t *data, int32_t offset, int32_t length);
+
+	// Actions of the combined calls: an action that fails closes the file and stops the chain
+	static const MICROEJ_ASYNC_WORKER_action_t LLFS_File_IMPL_read_file_chain[] = {LLFS_File_IMPL_transfer_open_action, LLFS_File_IMPL_transfer_read_action, LLFS_File_IMPL_transfer_close_action};
+	static const MICROEJ_ASYNC_WORKER_action_t LLFS_File_IMPL_write_file_chain[] = {LLFS_File_IMPL_transfer_open_action, LLFS_File_IMPL_transfer_write_action, LLFS_File_IMPL_transfer_close_action};
 
 	int32_t LLFS_File_IMPL_open(uint8_t *path, uint8_t mode)
 	{
-		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_allocate_job(&fs_worker, (SNI_callback *)LLFS_File_IMPL_open);
+		if (FS_WAIT_WRITE_BEHIND(LLFS_File_IMPL_open) != MICROEJ_ASYNC_WORKER_OK)
+		{
+			// Waiting for the write-behind writes, or an exception is pending
+			return LLFS_NOK;
+		}
+
+		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_allocate_job_sized(&fs_worker, (SNI_callback *)LLFS_File_IMPL_open, sizeof(FS_open_t));
 
 		if (job == NULL)
 		{
@@ -59,6 +71,8 @@ extern "C"
 		else
 		{
 			params->mode = mode;
+			// An open that times out would leak the file descriptor
+			MICROEJ_ASYNC_WORKER_set_job_timeout(job, 0);
 
 			MICROEJ_ASYNC_WORKER_status_t status = MICROEJ_ASYNC_WORKER_async_exec(&fs_worker, job, LLFS_File_IMPL_open_action, (SNI_callback *)LLFS_File_IMPL_open_on_done);
 			if (status == MICROEJ_ASYNC_WORKER_OK)
@@ -76,6 +90,11 @@ extern "C"
 	static int32_t LLFS_File_IMPL_open_on_done(uint8_t *path, uint8_t mode)
 	{
 		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_get_job_done();
+		if (job == NULL)
+		{
+			// Timed out (an exception is pending) or waiting again
+			return LLFS_NOK;
+		}
 		FS_open_t *params = (FS_open_t *)job->params;
 
 		int32_t result = params->result;
@@ -92,7 +111,7 @@ extern "C"
 	static int32_t LLFS_async_exec_write_read_job(int32_t file_id, uint8_t *data, int32_t offset, int32_t length, bool exec_write, SNI_callback *retry_function, MICROEJ_ASYNC_WORKER_action_t action, SNI_callback *on_done)
 	{
 
-		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_allocate_job(&fs_worker, retry_function);
+		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_allocate_job_sized(&fs_worker, retry_function, sizeof(FS_write_read_t));
 		if (job == NULL)
 		{
 			// No job available, either:
@@ -114,7 +133,7 @@ extern "C"
 		{
 			params->file_id = file_id;
 
-			MICROEJ_ASYNC_WORKER_status_t status = MICROEJ_ASYNC_WORKER_async_exec(&fs_worker, job, action, on_done);
+			MICROEJ_ASYNC_WORKER_status_t status = MICROEJ_ASYNC_WORKER_async_exec_with_key(&fs_worker, job, action, on_done, file_id);
 			if (status == MICROEJ_ASYNC_WORKER_OK)
 			{
 				// Wait for the action to be done
@@ -127,14 +146,57 @@ extern "C"
 		return LLFS_NOK;
 	}
 
+#ifdef FS_WRITE_BEHIND
+	static int32_t LLFS_async_exec_write_behind_job(int32_t file_id, uint8_t *data, int32_t length, SNI_callback *retry_function)
+	{
+		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_allocate_job_sized(&fs_worker, retry_function, sizeof(FS_write_read_t));
+		if (job == NULL)
+		{
+			// No job available, either:
+			// - wait for a job to be available and this function to be executed again,
+			// - or an exception is pending
+			return LLFS_NOK; // Unused value
+		}
+
+		// The Java thread continues: copy the data now
+		FS_write_read_t *params = (FS_write_read_t *)job->params;
+		memcpy(params->buffer, data, length);
+		params->file_id = file_id;
+		params->data = (uint8_t *)&params->buffer;
+		params->length = length;
+
+		MICROEJ_ASYNC_WORKER_status_t status = MICROEJ_ASYNC_WORKER_async_exec_detached_with_key(&fs_worker, job, LLFS_File_IMPL_write_behind_action, file_id);
+		if (status == MICROEJ_ASYNC_WORKER_OK)
+		{
+			// The worker frees the job
+			return length;
+		} // else an error occurred and MICROEJ_ASYNC_WORKER_async_exec_detached_with_key has thrown a SNI exception
+
+		// Error
+		MICROEJ_ASYNC_WORKER_free_job(&fs_worker, job);
+		return LLFS_NOK;
+	}
+#endif
+
 	int32_t LLFS_File_IMPL_write(int32_t file_id, uint8_t *data, int32_t offset, int32_t length)
 	{
+#ifdef FS_WRITE_BEHIND
+		if (length <= FS_IO_BUFFER_SIZE)
+		{
+			return LLFS_async_exec_write_behind_job(file_id, data + offset, length, (SNI_callback *)LLFS_File_IMPL_write);
+		}
+#endif
 		return LLFS_async_exec_write_read_job(file_id, data, offset, length, true, (SNI_callback *)LLFS_File_IMPL_write, LLFS_File_IMPL_write_action, (SNI_callback *)LLFS_File_IMPL_write_on_done);
 	}
 
 	int32_t LLFS_File_IMPL_write_on_done(int32_t file_id, uint8_t *data, int32_t offset, int32_t length)
 	{
 		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_get_job_done();
+		if (job == NULL)
+		{
+			// Timed out (an exception is pending) or waiting again
+			return LLFS_NOK;
+		}
 		FS_write_read_t *params = (FS_write_read_t *)job->params;
 
 		int32_t result = params->result;
@@ -156,6 +218,11 @@ extern "C"
 	static int32_t LLFS_File_IMPL_read_on_done(int32_t file_id, uint8_t *data, int32_t offset, int32_t length)
 	{
 		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_get_job_done();
+		if (job == NULL)
+		{
+			// Timed out (an exception is pending) or waiting again
+			return LLFS_NOK;
+		}
 		FS_write_read_t *params = (FS_write_read_t *)job->params;
 
 		int32_t result = params->result;
@@ -179,7 +246,7 @@ extern "C"
 
 	static int32_t LLFS_async_exec_write_read_byte_job(int32_t file_id, int32_t data, bool exec_write, SNI_callback *retry_function, MICROEJ_ASYNC_WORKER_action_t action, SNI_callback *on_done)
 	{
-		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_allocate_job(&fs_worker, retry_function);
+		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_allocate_job_sized(&fs_worker, retry_function, sizeof(FS_write_read_t));
 		if (job == NULL)
 		{
 			// No job available, either:
@@ -198,7 +265,7 @@ extern "C"
 			params->buffer[0] = (uint8_t)data;
 		}
 
-		MICROEJ_ASYNC_WORKER_status_t status = MICROEJ_ASYNC_WORKER_async_exec(&fs_worker, job, action, on_done);
+		MICROEJ_ASYNC_WORKER_status_t status = MICROEJ_ASYNC_WORKER_async_exec_with_key(&fs_worker, job, action, on_done, file_id);
 		if (status == MICROEJ_ASYNC_WORKER_OK)
 		{
 			// Wait for the action to be done
@@ -212,12 +279,22 @@ extern "C"
 
 	void LLFS_File_IMPL_write_byte(int32_t file_id, int32_t data)
 	{
+#ifdef FS_WRITE_BEHIND
+		uint8_t byte = (uint8_t)data;
+		LLFS_async_exec_write_behind_job(file_id, &byte, sizeof(byte), (SNI_callback *)LLFS_File_IMPL_write_byte);
+#else
 		LLFS_async_exec_write_read_byte_job(file_id, data, true, (SNI_callback *)LLFS_File_IMPL_write_byte, LLFS_File_IMPL_write_action, (SNI_callback *)LLFS_File_IMPL_write_byte_on_done);
+#endif
 	}
 
 	static void LLFS_File_IMPL_write_byte_on_done(int32_t file_id, int32_t data)
 	{
 		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_get_job_done();
+		if (job == NULL)
+		{
+			// Timed out (an exception is pending) or waiting again
+			return;
+		}
 		FS_write_read_t *params = (FS_write_read_t *)job->params;
 
 		int32_t result = params->result;
@@ -237,6 +314,11 @@ extern "C"
 	int32_t LLFS_File_IMPL_read_byte_on_done(int32_t file_id)
 	{
 		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_get_job_done();
+		if (job == NULL)
+		{
+			// Timed out (an exception is pending) or waiting again
+			return LLFS_NOK;
+		}
 		FS_write_read_t *params = (FS_write_read_t *)job->params;
 
 		int32_t result = params->result;
@@ -258,7 +340,7 @@ extern "C"
 
 	void LLFS_File_IMPL_close(int32_t file_id)
 	{
-		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_allocate_job(&fs_worker, (SNI_callback *)LLFS_File_IMPL_close);
+		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_allocate_job_sized(&fs_worker, (SNI_callback *)LLFS_File_IMPL_close, sizeof(FS_close_t));
 		if (job == NULL)
 		{
 			// No job available, either:
@@ -269,8 +351,10 @@ extern "C"
 
 		FS_close_t *params = (FS_close_t *)job->params;
 		params->file_id = file_id;
+		// A close that times out would leak the file descriptor
+		MICROEJ_ASYNC_WORKER_set_job_timeout(job, 0);
 
-		MICROEJ_ASYNC_WORKER_status_t status = MICROEJ_ASYNC_WORKER_async_exec(&fs_worker, job, LLFS_File_IMPL_close_action, (SNI_callback *)LLFS_File_IMPL_close_on_done);
+		MICROEJ_ASYNC_WORKER_status_t status = MICROEJ_ASYNC_WORKER_async_exec_with_key(&fs_worker, job, LLFS_File_IMPL_close_action, (SNI_callback *)LLFS_File_IMPL_close_on_done, file_id);
 		if (status == MICROEJ_ASYNC_WORKER_OK)
 		{
 			// Wait for the action to be done
@@ -303,7 +387,7 @@ extern "C"
 
 	int64_t LLFS_File_IMPL_skip(int32_t file_id, int64_t n)
 	{
-		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_allocate_job(&fs_worker, (SNI_callback *)LLFS_File_IMPL_skip);
+		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_allocate_job_sized(&fs_worker, (SNI_callback *)LLFS_File_IMPL_skip, sizeof(FS_skip_t));
 		if (job == NULL)
 		{
 			// No job available, either:
@@ -316,7 +400,7 @@ extern "C"
 		params->file_id = file_id;
 		params->n = n;
 
-		MICROEJ_ASYNC_WORKER_status_t status = MICROEJ_ASYNC_WORKER_async_exec(&fs_worker, job, LLFS_File_IMPL_skip_action, (SNI_callback *)LLFS_File_IMPL_skip_on_done);
+		MICROEJ_ASYNC_WORKER_status_t status = MICROEJ_ASYNC_WORKER_async_exec_with_key(&fs_worker, job, LLFS_File_IMPL_skip_action, (SNI_callback *)LLFS_File_IMPL_skip_on_done, file_id);
 		if (status == MICROEJ_ASYNC_WORKER_OK)
 		{
 			// Wait for the action to be done
@@ -330,6 +414,11 @@ extern "C"
 	static int64_t LLFS_File_IMPL_skip_on_done(int32_t file_id, int64_t n)
 	{
 		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_get_job_done();
+		if (job == NULL)
+		{
+			// Timed out (an exception is pending) or waiting again
+			return LLFS_NOK;
+		}
 		FS_skip_t *params = (FS_skip_t *)job->params;
 
 		int64_t skipped_count;
@@ -351,7 +440,7 @@ extern "C"
 
 	int32_t LLFS_File_IMPL_available(int32_t file_id)
 	{
-		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_allocate_job(&fs_worker, (SNI_callback *)LLFS_File_IMPL_available);
+		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_allocate_job_sized(&fs_worker, (SNI_callback *)LLFS_File_IMPL_available, sizeof(FS_available_t));
 		if (job == NULL)
 		{
 			// No job available, either:
@@ -363,7 +452,7 @@ extern "C"
 		FS_available_t *params = (FS_available_t *)job->params;
 		params->file_id = file_id;
 
-		MICROEJ_ASYNC_WORKER_status_t status = MICROEJ_ASYNC_WORKER_async_exec(&fs_worker, job, LLFS_File_IMPL_available_action, (SNI_callback *)LLFS_File_IMPL_available_on_done);
+		MICROEJ_ASYNC_WORKER_status_t status = MICROEJ_ASYNC_WORKER_async_exec_with_key(&fs_worker, job, LLFS_File_IMPL_available_action, (SNI_callback *)LLFS_File_IMPL_available_on_done, file_id);
 		if (status == MICROEJ_ASYNC_WORKER_OK)
 		{
 			// Wait for the action to be done
@@ -377,6 +466,11 @@ extern "C"
 	static int32_t LLFS_File_IMPL_available_on_done(int32_t file_id)
 	{
 		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_get_job_done();
+		if (job == NULL)
+		{
+			// Timed out (an exception is pending) or waiting again
+			return LLFS_NOK;
+		}
 		FS_available_t *params = (FS_available_t *)job->params;
 
 		int32_t result = params->result;
@@ -391,6 +485,113 @@ extern "C"
 		return result;
 	}
 
+	static int32_t LLFS_async_exec_file_transfer_job(uint8_t *path, uint8_t mode, uint8_t *data, int32_t offset, int32_t length, SNI_callback *retry_function, const MICROEJ_ASYNC_WORKER_action_t *chain, int32_t chain_length, SNI_callback *on_done)
+	{
+		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_allocate_job_sized(&fs_worker, retry_function, sizeof(FS_file_transfer_t));
+		if (job == NULL)
+		{
+			// No job available, either:
+			// - wait for a job to be available and this function to be executed again,
+			// - or an exception is pending
+			return LLFS_NOK; // Unused value
+		}
+
+		FS_file_transfer_t *params = (FS_file_transfer_t *)job->params;
+		if (LLFS_set_path_param(path, (uint8_t *)&params->path) != LLFS_OK)
+		{
+			SNI_throwNativeIOException(LLFS_NOK, "Path name too long");
+		}
+		else
+		{
+			bool do_copy = (mode != LLFS_FILE_MODE_READ);
+			int32_t result = SNI_getArrayElements(data, offset, length, (uint8_t *)&params->buffer, sizeof(params->buffer), &params->data, &params->length, do_copy);
+			if (result != SNI_OK)
+			{
+				SNI_throwNativeIOException(result, "SNI_getArrayElements: Internal error");
+			}
+			else
+			{
+				params->mode = mode;
+
+				MICROEJ_ASYNC_WORKER_status_t status = MICROEJ_ASYNC_WORKER_async_exec_chain(&fs_worker, job, chain, chain_length, on_done);
+				if (status == MICROEJ_ASYNC_WORKER_OK)
+				{
+					// Wait for the actions to be done
+					return LLFS_OK; //returned value not used
+				}					// else an error occurred and MICROEJ_ASYNC_WORKER_async_exec_chain has thrown a SNI exception
+			}
+		}
+
+		// Error
+		MICROEJ_ASYNC_WORKER_free_job(&fs_worker, job);
+		return LLFS_NOK;
+	}
+
+	int32_t LLFS_File_IMPL_read_file(uint8_t *path, uint8_t *data, int32_t offset, int32_t length)
+	{
+		return LLFS_async_exec_file_transfer_job(path, LLFS_FILE_MODE_READ, data, offset, length, (SNI_callback *)LLFS_File_IMPL_read_file, LLFS_File_IMPL_read_file_chain, sizeof(LLFS_File_IMPL_read_file_chain) / sizeof(LLFS_File_IMPL_read_file_chain[0]), (SNI_callback *)LLFS_File_IMPL_read_file_on_done);
+	}
+
+	static int32_t LLFS_File_IMPL_read_file_on_done(uint8_t *path, uint8_t *data, int32_t offset, int32_t length)
+	{
+		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_get_job_done();
+		if (job == NULL)
+		{
+			// Timed out (an exception is pending) or waiting again
+			return LLFS_NOK;
+		}
+		FS_file_transfer_t *params = (FS_file_transfer_t *)job->params;
+
+		int32_t result = params->result;
+		if (result == LLFS_NOK)
+		{
+			// Exception
+			SNI_throwNativeIOException(params->error_code, params->error_message);
+		}
+		else if (result != LLFS_EOF)
+		{
+			int32_t release_result = SNI_releaseArrayElements(data, offset, length, params->data, result);
+			if (release_result != SNI_OK)
+			{
+				SNI_throwNativeIOException(release_result, "SNI_releaseArrayElements: Internal error");
+			}
+		}
+		MICROEJ_ASYNC_WORKER_free_job(&fs_worker, job);
+
+		return result;
+	}
+
+	int32_t LLFS_File_IMPL_write_file(uint8_t *path, uint8_t mode, uint8_t *data, int32_t offset, int32_t length)
+	{
+		if (mode == LLFS_FILE_MODE_READ)
+		{
+			SNI_throwNativeIOException(mode, "Invalid mode");
+			return LLFS_NOK;
+		}
+		return LLFS_async_exec_file_transfer_job(path, mode, data, offset, length, (SNI_callback *)LLFS_File_IMPL_write_file, LLFS_File_IMPL_write_file_chain, sizeof(LLFS_File_IMPL_write_file_chain) / sizeof(LLFS_File_IMPL_write_file_chain[0]), (SNI_callback *)LLFS_File_IMPL_write_file_on_done);
+	}
+
+	static int32_t LLFS_File_IMPL_write_file_on_done(uint8_t *path, uint8_t mode, uint8_t *data, int32_t offset, int32_t length)
+	{
+		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_get_job_done();
+		if (job == NULL)
+		{
+			// Timed out (an exception is pending) or waiting again
+			return LLFS_NOK;
+		}
+		FS_file_transfer_t *params = (FS_file_transfer_t *)job->params;
+
+		int32_t result = params->result;
+		if (result == LLFS_NOK)
+		{
+			// Exception
+			SNI_throwNativeIOException(params->error_code, params->error_message);
+		}
+		MICROEJ_ASYNC_WORKER_free_job(&fs_worker, job);
+
+		return result;
+	}
+
 #ifdef __cplusplus
 }
 #endif
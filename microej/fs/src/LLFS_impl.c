@@ -19,6 +19,7 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <string.h>
+#include <stdio.h>
 #include "LLFS_impl.h"
 #include "sni.h"
 #include "microej_async_worker.h"
@@ -31,9 +32,30 @@ extern "C"
 
 	//TODO: init errorcode and error message in caller
 
-	MICROEJ_ASYNC_WORKER_worker_declare(fs_worker, FS_WORKER_JOB_COUNT, FS_worker_param_t, FS_WAITING_LIST_SIZE);
+	// The operations on an open file or directory take small params, the path operations take a path and only the
+	// I/O and rename operations take the largest params
+	MICROEJ_ASYNC_WORKER_params_class_declare(fs_id_params, sizeof(FS_id_param_t), FS_ID_PARAMS_COUNT);
+	MICROEJ_ASYNC_WORKER_params_class_declare(fs_path_params, sizeof(FS_path_param_t), FS_PATH_PARAMS_COUNT);
+	MICROEJ_ASYNC_WORKER_params_class_declare(fs_large_params, sizeof(FS_worker_param_t), FS_LARGE_PARAMS_COUNT);
+	static MICROEJ_ASYNC_WORKER_params_class_t *const fs_params_classes[] = {&fs_id_params, &fs_path_params, &fs_large_params};
+	MICROEJ_ASYNC_WORKER_worker_declare_slab(fs_worker, FS_WORKER_JOB_COUNT, fs_params_classes, FS_WAITING_LIST_SIZE, FS_WORKER_THREAD_COUNT);
 	OSAL_task_stack_declare(fs_worker_stack, FS_WORKER_STACK_SIZE);
 
+	// Metadata queries are not delayed by the queued writes, each of which synchronizes the storage.
+	// The other actions are in the normal lane.
+	static const MICROEJ_ASYNC_WORKER_action_lane_t fs_worker_action_lanes[] = {
+		{LLFS_File_IMPL_write_action, MICROEJ_ASYNC_WORKER_LANE_BULK},
+		{LLFS_File_IMPL_write_behind_action, MICROEJ_ASYNC_WORKER_LANE_BULK},
+		{LLFS_IMPL_exist_action, MICROEJ_ASYNC_WORKER_LANE_LATENCY},
+		{LLFS_IMPL_is_file_action, MICROEJ_ASYNC_WORKER_LANE_LATENCY},
+		{LLFS_IMPL_is_directory_action, MICROEJ_ASYNC_WORKER_LANE_LATENCY},
+		{LLFS_IMPL_is_hidden_action, MICROEJ_ASYNC_WORKER_LANE_LATENCY},
+		{LLFS_IMPL_is_accessible_action, MICROEJ_ASYNC_WORKER_LANE_LATENCY},
+		{LLFS_IMPL_get_length_action, MICROEJ_ASYNC_WORKER_LANE_LATENCY},
+		{LLFS_IMPL_get_last_modified_action, MICROEJ_ASYNC_WORKER_LANE_LATENCY},
+		{LLFS_IMPL_get_space_size_action, MICROEJ_ASYNC_WORKER_LANE_LATENCY},
+	};
+
 	int32_t LLFS_set_path_param(uint8_t *path, uint8_t *path_param)
 	{
 		int32_t path_length = SNI_getArrayLength(path);
@@ -51,7 +73,7 @@ extern "C"
 
 	static MICROEJ_ASYNC_WORKER_job_t *LLFS_allocate_path_job(uint8_t *path, SNI_callback *sni_retry_callback)
 	{
-		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_allocate_job(&fs_worker, sni_retry_callback);
+		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_allocate_job_sized(&fs_worker, sni_retry_callback, sizeof(FS_path_param_t));
 		if (job == NULL)
 		{
 			// No job available, either:
@@ -72,16 +94,8 @@ extern "C"
 		return job;
 	}
 
-	static int32_t LLFS_async_exec_path_job(uint8_t *path, SNI_callback *retry_function, MICROEJ_ASYNC_WORKER_action_t action, SNI_callback *on_done)
+	static int32_t LLFS_exec_path_job(MICROEJ_ASYNC_WORKER_job_t *job, MICROEJ_ASYNC_WORKER_action_t action, SNI_callback *on_done)
 	{
-
-		//TODO: inline this call ?
-		MICROEJ_ASYNC_WORKER_job_t *job = LLFS_allocate_path_job(path, retry_function);
-		if (job == NULL)
-		{
-			return LLFS_NOK;
-		}
-
 		MICROEJ_ASYNC_WORKER_status_t status = MICROEJ_ASYNC_WORKER_async_exec(&fs_worker, job, action, on_done);
 
 		if (status != MICROEJ_ASYNC_WORKER_OK)
@@ -97,21 +111,53 @@ extern "C"
 		}
 	}
 
-	static int32_t LLFS_async_exec_directory_job(int32_t directory_ID, SNI_callback *retry_function, MICROEJ_ASYNC_WORKER_action_t action, SNI_callback *on_done)
+	static int32_t LLFS_async_exec_path_job(uint8_t *path, SNI_callback *retry_function, MICROEJ_ASYNC_WORKER_action_t action, SNI_callback *on_done)
 	{
-		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_allocate_job(&fs_worker, retry_function);
+		//TODO: inline this call ?
+		MICROEJ_ASYNC_WORKER_job_t *job = LLFS_allocate_path_job(path, retry_function);
+		if (job == NULL)
+		{
+			return LLFS_NOK;
+		}
+
+		return LLFS_exec_path_job(job, action, on_done);
+	}
+
+	// For the path operations that modify the file system: they are executed after the write-behind writes issued before
+	static int32_t LLFS_async_exec_mutating_path_job(uint8_t *path, SNI_callback *retry_function, MICROEJ_ASYNC_WORKER_action_t action, SNI_callback *on_done)
+	{
+		if (FS_WAIT_WRITE_BEHIND(retry_function) != MICROEJ_ASYNC_WORKER_OK)
+		{
+			// Waiting for the write-behind writes, or an exception is pending
+			return LLFS_NOK;
+		}
+
+		return LLFS_async_exec_path_job(path, retry_function, action, on_done);
+	}
+
+	static MICROEJ_ASYNC_WORKER_job_t *LLFS_allocate_directory_job(int32_t directory_ID, uint32_t params_size, SNI_callback *retry_function)
+	{
+		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_allocate_job_sized(&fs_worker, retry_function, params_size);
 		if (job == NULL)
 		{
 			// No job available, either:
 			// - wait for a job to be available and this function to be executed again,
 			// - or an exception is pending.
-			return LLFS_NOK;
+			return NULL;
 		}
 
 		FS_directory_operation_t *params = (FS_directory_operation_t *)job->params;
 		params->directory_ID = directory_ID;
 
-		MICROEJ_ASYNC_WORKER_status_t status = MICROEJ_ASYNC_WORKER_async_exec(&fs_worker, job, action, on_done);
+		return job;
+	}
+
+	static int32_t LLFS_exec_directory_job(MICROEJ_ASYNC_WORKER_job_t *job, MICROEJ_ASYNC_WORKER_action_t action, SNI_callback *on_done)
+	{
+		FS_directory_operation_t *params = (FS_directory_operation_t *)job->params;
+
+		// Operations on the same directory are executed in order
+		MICROEJ_ASYNC_WORKER_status_t status = MICROEJ_ASYNC_WORKER_async_exec_with_key(&fs_worker, job, action, on_done, params->directory_ID);
 
 		if (status != MICROEJ_ASYNC_WORKER_OK)
 		{
@@ -126,9 +172,25 @@ extern "C"
 		}
 	}
 
+	static int32_t LLFS_async_exec_directory_job(int32_t directory_ID, uint32_t params_size, SNI_callback *retry_function, MICROEJ_ASYNC_WORKER_action_t action, SNI_callback *on_done)
+	{
+		MICROEJ_ASYNC_WORKER_job_t *job = LLFS_allocate_directory_job(directory_ID, params_size, retry_function);
+		if (job == NULL)
+		{
+			return LLFS_NOK;
+		}
+
+		return LLFS_exec_directory_job(job, action, on_done);
+	}
+
 	static int32_t LLFS_async_exec_path_result()
 	{
 		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_get_job_done();
+		if (job == NULL)
+		{
+			// Timed out (an exception is pending) or waiting again
+			return LLFS_NOK;
+		}
 		FS_path_operation_t *params = (FS_path_operation_t *)job->params;
 
 		int32_t result = params->result;
@@ -138,6 +200,13 @@ extern "C"
 
 	void LLFS_IMPL_initialize(void)
 	{
+#ifdef FS_JOB_TIMEOUT_MS
+		MICROEJ_ASYNC_WORKER_set_default_timeout(&fs_worker, FS_JOB_TIMEOUT_MS);
+#endif
+#ifdef FS_THREAD_JOB_QUOTA
+		MICROEJ_ASYNC_WORKER_set_thread_quota(&fs_worker, FS_THREAD_JOB_QUOTA);
+#endif
+		MICROEJ_ASYNC_WORKER_set_action_lanes(&fs_worker, fs_worker_action_lanes, sizeof(fs_worker_action_lanes) / sizeof(fs_worker_action_lanes[0]));
 		MICROEJ_ASYNC_WORKER_status_t status = MICROEJ_ASYNC_WORKER_initialize(&fs_worker, "MicroEJ FS", fs_worker_stack, FS_WORKER_PRIORITY);
 		if (status == MICROEJ_ASYNC_WORKER_INVALID_ARGS)
 		{
@@ -147,6 +216,19 @@ extern "C"
 		{
 			SNI_throwNativeException(status, "Error while initializing FS async worker");
 		}
+#ifdef FS_WORKER_CPU_AFFINITY
+		else
+		{
+			for (int i = 0; i < fs_worker.thread_count; i++)
+			{
+				if (OSAL_OK != OSAL_task_set_affinity(&fs_worker.tasks[i], FS_WORKER_CPU_AFFINITY))
+				{
+					// the worker runs anyway, only its placement is not applied
+					printf("[WARNING] FS async worker affinity not applied\n");
+				}
+			}
+		}
+#endif
 		// else OK
 	}
 
@@ -155,6 +237,16 @@ extern "C"
 		return FS_PATH_LENGTH;
 	}
 
+	int32_t LLFS_IMPL_get_worker_stats(int32_t *stats)
+	{
+		int32_t result = MICROEJ_ASYNC_WORKER_stats_to_array(&fs_worker, stats, SNI_getArrayLength(stats));
+		if (result < 0)
+		{
+			SNI_throwNativeIOException(LLFS_NOK, "FS worker telemetry not available");
+		}
+		return result;
+	}
+
 	static int32_t LLFS_IMPL_get_last_modified_on_done(uint8_t *path, LLFS_date_t *date);
 
 	int32_t LLFS_IMPL_get_last_modified(uint8_t *path, LLFS_date_t *date)
@@ -165,6 +257,11 @@ extern "C"
 	static int32_t LLFS_IMPL_get_last_modified_on_done(uint8_t *path, LLFS_date_t *date)
 	{
 		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_get_job_done();
+		if (job == NULL)
+		{
+			// Timed out (an exception is pending) or waiting again
+			return LLFS_NOK;
+		}
 		FS_get_last_modified_t *params = (FS_get_last_modified_t *)job->params;
 
 		int32_t result = params->result;
@@ -185,6 +282,11 @@ extern "C"
 	static int64_t LLFS_IMPL_path64_function_on_done(uint8_t *path)
 	{
 		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_get_job_done();
+		if (job == NULL)
+		{
+			// Timed out (an exception is pending) or waiting again
+			return LLFS_NOK;
+		}
 		FS_path64_operation_t *params = (FS_path64_operation_t *)job->params;
 
 		int64_t result = params->result;
@@ -194,14 +296,20 @@ extern "C"
 
 	int32_t LLFS_IMPL_set_read_only(uint8_t *path)
 	{
-		return LLFS_async_exec_path_job(path, (SNI_callback *)LLFS_IMPL_set_read_only, LLFS_IMPL_set_read_only_action, (SNI_callback *)LLFS_IMPL_path_function_on_done);
+		return LLFS_async_exec_mutating_path_job(path, (SNI_callback *)LLFS_IMPL_set_read_only, LLFS_IMPL_set_read_only_action, (SNI_callback *)LLFS_IMPL_path_function_on_done);
 	}
 
 	static int32_t LLFS_IMPL_create_on_done(uint8_t *path);
 
 	int32_t LLFS_IMPL_create(uint8_t *path)
 	{
-		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_allocate_job(&fs_worker, (SNI_callback *)LLFS_IMPL_create);
+		if (FS_WAIT_WRITE_BEHIND(LLFS_IMPL_create) != MICROEJ_ASYNC_WORKER_OK)
+		{
+			// Waiting for the write-behind writes, or an exception is pending
+			return LLFS_NOK;
+		}
+
+		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_allocate_job_sized(&fs_worker, (SNI_callback *)LLFS_IMPL_create, sizeof(FS_create_t));
 		if (job == NULL)
 		{
 			// No job available, either:
@@ -233,6 +341,11 @@ extern "C"
 	static int32_t LLFS_IMPL_create_on_done(uint8_t *path)
 	{
 		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_get_job_done();
+		if (job == NULL)
+		{
+			// Timed out (an exception is pending) or waiting again
+			return LLFS_NOK;
+		}
 		FS_create_t *params = (FS_create_t *)job->params;
 
 		int32_t result = params->result;
@@ -248,19 +361,32 @@ extern "C"
 
 	int32_t LLFS_IMPL_open_directory(uint8_t *path)
 	{
-		return LLFS_async_exec_path_job(path, (SNI_callback *)LLFS_IMPL_open_directory, LLFS_IMPL_open_directory_action, (SNI_callback *)LLFS_IMPL_path_function_on_done);
+		MICROEJ_ASYNC_WORKER_job_t *job = LLFS_allocate_path_job(path, (SNI_callback *)LLFS_IMPL_open_directory);
+		if (job == NULL)
+		{
+			return LLFS_NOK;
+		}
+		// An open that times out would leak the directory stream
+		MICROEJ_ASYNC_WORKER_set_job_timeout(job, 0);
+
+		return LLFS_exec_path_job(job, LLFS_IMPL_open_directory_action, (SNI_callback *)LLFS_IMPL_path_function_on_done);
 	}
 
 	static int32_t LLFS_IMPL_read_directory_on_done(int32_t directory_ID, uint8_t *path);
 
 	int32_t LLFS_IMPL_read_directory(int32_t directory_ID, uint8_t *path)
 	{
-		return LLFS_async_exec_directory_job(directory_ID, (SNI_callback *)LLFS_IMPL_read_directory, LLFS_IMPL_read_directory_action, (SNI_callback *)LLFS_IMPL_read_directory_on_done);
+		return LLFS_async_exec_directory_job(directory_ID, sizeof(FS_read_directory_t), (SNI_callback *)LLFS_IMPL_read_directory, LLFS_IMPL_read_directory_action, (SNI_callback *)LLFS_IMPL_read_directory_on_done);
 	}
 
 	static int32_t LLFS_IMPL_read_directory_on_done(int32_t directory_ID, uint8_t *path)
 	{
 		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_get_job_done();
+		if (job == NULL)
+		{
+			// Timed out (an exception is pending) or waiting again
+			return LLFS_NOK;
+		}
 		FS_read_directory_t *params = (FS_read_directory_t *)job->params;
 
 		int32_t result = params->result;
@@ -289,12 +415,25 @@ extern "C"
 
 	int32_t LLFS_IMPL_close_directory(int32_t directory_ID)
 	{
-		return LLFS_async_exec_directory_job(directory_ID, (SNI_callback *)LLFS_IMPL_close_directory, LLFS_IMPL_close_directory_action, (SNI_callback *)LLFS_IMPL_close_directory_on_done);
+		MICROEJ_ASYNC_WORKER_job_t *job = LLFS_allocate_directory_job(directory_ID, sizeof(FS_close_directory_t), (SNI_callback *)LLFS_IMPL_close_directory);
+		if (job == NULL)
+		{
+			return LLFS_NOK;
+		}
+		// A close that times out would leak the directory stream
+		MICROEJ_ASYNC_WORKER_set_job_timeout(job, 0);
+
+		return LLFS_exec_directory_job(job, LLFS_IMPL_close_directory_action, (SNI_callback *)LLFS_IMPL_close_directory_on_done);
 	}
 
 	static int32_t LLFS_IMPL_close_directory_on_done(int32_t directory_ID)
 	{
 		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_get_job_done();
+		if (job == NULL)
+		{
+			// Timed out (an exception is pending) or waiting again
+			return LLFS_NOK;
+		}
 		FS_close_directory_t *params = (FS_close_directory_t *)job->params;
 
 		int32_t result = params->result;
@@ -306,7 +445,13 @@ extern "C"
 
 	int32_t LLFS_IMPL_rename_to(uint8_t *path, uint8_t *new_path)
 	{
-		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_allocate_job(&fs_worker, (SNI_callback *)LLFS_IMPL_rename_to);
+		if (FS_WAIT_WRITE_BEHIND(LLFS_IMPL_rename_to) != MICROEJ_ASYNC_WORKER_OK)
+		{
+			// Waiting for the write-behind writes, or an exception is pending
+			return LLFS_NOK;
+		}
+
+		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_allocate_job_sized(&fs_worker, (SNI_callback *)LLFS_IMPL_rename_to, sizeof(FS_rename_to_t));
 		if (job == NULL)
 		{
 			// No job available, either:
@@ -352,7 +497,7 @@ extern "C"
 
 	int64_t LLFS_IMPL_get_space_size(uint8_t *path, int32_t space_type)
 	{
-		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_allocate_job(&fs_worker, (SNI_callback *)LLFS_IMPL_get_space_size);
+		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_allocate_job_sized(&fs_worker, (SNI_callback *)LLFS_IMPL_get_space_size, sizeof(FS_get_space_size));
 		if (job == NULL)
 		{
 			// No job available, either:
@@ -382,6 +527,11 @@ extern "C"
 	int64_t LLFS_IMPL_get_space_size_on_done(uint8_t *path, int32_t space_type)
 	{
 		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_get_job_done();
+		if (job == NULL)
+		{
+			// Timed out (an exception is pending) or waiting again
+			return LLFS_NOK;
+		}
 		FS_get_space_size *params = (FS_get_space_size *)job->params;
 
 		int64_t result = params->result;
@@ -391,7 +541,7 @@ extern "C"
 
 	int32_t LLFS_IMPL_make_directory(uint8_t *path)
 	{
-		return LLFS_async_exec_path_job(path, (SNI_callback *)LLFS_IMPL_make_directory, LLFS_IMPL_make_directory_action, (SNI_callback *)LLFS_IMPL_path_function_on_done);
+		return LLFS_async_exec_mutating_path_job(path, (SNI_callback *)LLFS_IMPL_make_directory, LLFS_IMPL_make_directory_action, (SNI_callback *)LLFS_IMPL_path_function_on_done);
 	}
 
 	int32_t LLFS_IMPL_is_hidden(uint8_t *path)
@@ -413,7 +563,13 @@ extern "C"
 
 	int32_t LLFS_IMPL_set_last_modified(uint8_t *path, LLFS_date_t *date)
 	{
-		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_allocate_job(&fs_worker, (SNI_callback *)LLFS_IMPL_set_last_modified);
+		if (FS_WAIT_WRITE_BEHIND(LLFS_IMPL_set_last_modified) != MICROEJ_ASYNC_WORKER_OK)
+		{
+			// Waiting for the write-behind writes, or an exception is pending
+			return LLFS_NOK;
+		}
+
+		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_allocate_job_sized(&fs_worker, (SNI_callback *)LLFS_IMPL_set_last_modified, sizeof(FS_set_last_modified_t));
 		if (job == NULL)
 		{
 			// No job available, either:
@@ -447,14 +603,14 @@ extern "C"
 
 	int32_t LLFS_IMPL_delete(uint8_t *path)
 	{
-		return LLFS_async_exec_path_job(path, (SNI_callback *)LLFS_IMPL_delete, LLFS_IMPL_delete_action, (SNI_callback *)LLFS_IMPL_path_function_on_done);
+		return LLFS_async_exec_mutating_path_job(path, (SNI_callback *)LLFS_IMPL_delete, LLFS_IMPL_delete_action, (SNI_callback *)LLFS_IMPL_path_function_on_done);
 	}
 
 	static int32_t LLFS_IMPL_is_accessible_on_done(uint8_t *path, int32_t access);
 
 	int32_t LLFS_IMPL_is_accessible(uint8_t *path, int32_t access)
 	{
-		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_allocate_job(&fs_worker, (SNI_callback *)LLFS_IMPL_is_accessible);
+		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_allocate_job_sized(&fs_worker, (SNI_callback *)LLFS_IMPL_is_accessible, sizeof(FS_is_accessible_t));
 		if (job == NULL)
 		{
 			// No job available, either:
@@ -490,7 +646,13 @@ extern "C"
 
 	int32_t LLFS_IMPL_set_permission(uint8_t *path, int32_t access, int32_t enable, int32_t owner)
 	{
-		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_allocate_job(&fs_worker, (SNI_callback *)LLFS_IMPL_set_permission);
+		if (FS_WAIT_WRITE_BEHIND(LLFS_IMPL_set_permission) != MICROEJ_ASYNC_WORKER_OK)
+		{
+			// Waiting for the write-behind writes, or an exception is pending
+			return LLFS_NOK;
+		}
+
+		MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_allocate_job_sized(&fs_worker, (SNI_callback *)LLFS_IMPL_set_permission, sizeof(FS_set_permission_t));
 		if (job == NULL)
 		{
 			// No job available, either:
@@ -22,6 +22,7 @@
 #include <sys/statfs.h>
 #include <time.h>
 #include <dirent.h>
+#include <pthread.h>
 #include "LLFS_impl.h"
 #include "LLFS_File_impl.h"
 #include "microej_async_worker.h"
@@ -35,6 +36,108 @@ extern "C"
 
 #define LLFS_NORMAL_PERMISSIONS (S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH)
 
+    // Error of a write-behind, reported by the next synchronous operation on the file
+    typedef struct
+    {
+        int32_t file_id; // -1 when the slot is free
+        int32_t error_code;
+        char *error_message;
+    } FS_latched_error_t;
+
+    static FS_latched_error_t fs_latched_errors[FS_LATCHED_ERROR_COUNT] = {[0 ... FS_LATCHED_ERROR_COUNT - 1] = {.file_id = -1}};
+    // Error that found no free slot, set when file_id is not -1: reported by the next synchronous operation on any file
+    static FS_latched_error_t fs_latched_overflow = {.file_id = -1};
+    // the worker tasks execute the operations of different files in parallel
+    static pthread_mutex_t fs_latched_errors_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+    /**
+ * Latch an error on the given file. Only the first error is kept until it is taken. When all the slots are used, the
+ * error is kept in the overflow slot and thrown by the next synchronous operation on any file.
+ */
+    static void FS_latch_error(int32_t file_id, int32_t error_code, char *error_message)
+    {
+        FS_latched_error_t *free_slot = NULL;
+        pthread_mutex_lock(&fs_latched_errors_mutex);
+        bool latched = (fs_latched_overflow.file_id == file_id);
+        for (int i = 0; i < FS_LATCHED_ERROR_COUNT && !latched; i++)
+        {
+            if (fs_latched_errors[i].file_id == file_id)
+            {
+                // an error is already latched on this file
+                latched = true;
+            }
+            else if (free_slot == NULL && fs_latched_errors[i].file_id == -1)
+            {
+                free_slot = &fs_latched_errors[i];
+            }
+        }
+        if (!latched)
+        {
+            if (free_slot == NULL && fs_latched_overflow.file_id == -1)
+            {
+                free_slot = &fs_latched_overflow;
+            }
+            // else an overflow error is already pending: it is thrown before this one could be
+            if (free_slot != NULL)
+            {
+                free_slot->file_id = file_id;
+                free_slot->error_code = error_code;
+                free_slot->error_message = error_message;
+            }
+        }
+        pthread_mutex_unlock(&fs_latched_errors_mutex);
+    }
+
+    /**
+ * Take the error latched on the given file if any, otherwise the overflow error if any.
+ * Returns true and sets error_code and error_message if an error was latched, false otherwise.
+ */
+    static bool FS_take_latched_error(int32_t file_id, int32_t *error_code, char **error_message)
+    {
+        FS_latched_error_t *latched = NULL;
+        pthread_mutex_lock(&fs_latched_errors_mutex);
+        for (int i = 0; i < FS_LATCHED_ERROR_COUNT; i++)
+        {
+            if (fs_latched_errors[i].file_id == file_id)
+            {
+                latched = &fs_latched_errors[i];
+                break;
+            }
+        }
+        if (latched == NULL && fs_latched_overflow.file_id != -1)
+        {
+            latched = &fs_latched_overflow;
+        }
+        if (latched != NULL)
+        {
+            *error_code = latched->error_code;
+            *error_message = latched->error_message;
+            latched->file_id = -1;
+        }
+        pthread_mutex_unlock(&fs_latched_errors_mutex);
+        return latched != NULL;
+    }
+
+    /**
+ * Drop the error latched on the given file, if any. The overflow error of another file is kept.
+ */
+    static void FS_drop_latched_error(int32_t file_id)
+    {
+        pthread_mutex_lock(&fs_latched_errors_mutex);
+        for (int i = 0; i < FS_LATCHED_ERROR_COUNT; i++)
+        {
+            if (fs_latched_errors[i].file_id == file_id)
+            {
+                fs_latched_errors[i].file_id = -1;
+            }
+        }
+        if (fs_latched_overflow.file_id == file_id)
+        {
+            fs_latched_overflow.file_id = -1;
+        }
+        pthread_mutex_unlock(&fs_latched_errors_mutex);
+    }
+
     /**
  * Set the size of the file referenced by the given file descriptor into size_out.
  * Returns LLFS_NOK on error or LLFS_OK on success.
@@ -60,6 +163,34 @@ extern "C"
         return res;
     }
 
+    /**
+ * Set the open() flags matching the given LLFS file mode into open_mode.
+ * Returns LLFS_NOK if the mode is not valid or LLFS_OK on success.
+ */
+    static int FS_open_mode(uint8_t mode, int *open_mode)
+    {
+        int res = LLFS_OK;
+        switch (mode)
+        {
+        case LLFS_FILE_MODE_READ:
+            *open_mode = O_RDONLY;
+            break;
+
+        case LLFS_FILE_MODE_WRITE:
+            *open_mode = O_CREAT | O_WRONLY | O_TRUNC;
+            break;
+
+        case LLFS_FILE_MODE_APPEND:
+            *open_mode = O_CREAT | O_WRONLY | O_APPEND;
+            break;
+
+        default:
+            res = LLFS_NOK;
+            break;
+        }
+        return res;
+    }
+
     void LLFS_IMPL_get_last_modified_action(MICROEJ_ASYNC_WORKER_job_t *job)
     {
         FS_get_last_modified_t *params = (FS_get_last_modified_t *)job->params;
@@ -467,28 +598,15 @@ extern "C"
         uint8_t *path = (uint8_t *)&params->path;
         uint8_t mode = params->mode;
 
-        mode_t open_mode;
+        int open_mode;
         int fd;
 
         params->result = LLFS_NOK; // error by default
         params->error_code = LLFS_NOK;
         params->error_message = NULL;
 
-        switch (mode)
+        if (FS_open_mode(mode, &open_mode) != LLFS_OK)
         {
-        case LLFS_FILE_MODE_READ:
-            open_mode = O_RDONLY;
-            break;
-
-        case LLFS_FILE_MODE_WRITE:
-            open_mode = O_CREAT | O_WRONLY | O_TRUNC;
-            break;
-
-        case LLFS_FILE_MODE_APPEND:
-            open_mode = O_CREAT | O_WRONLY | O_APPEND;
-            break;
-
-        default:
             params->error_code = mode;
             params->error_message = "Invalid mode";
             return;
@@ -519,6 +637,13 @@ extern "C"
         uint8_t *data = params->data;
         int32_t length = params->length;
 
+        if (FS_take_latched_error(file_id, &params->error_code, &params->error_message))
+        {
+            // a write-behind on this file failed
+            params->result = LLFS_NOK;
+            return;
+        }
+
         ssize_t written_count = write(file_id, data, length);
 
         // - written_count < 0 when an error is detected
@@ -544,6 +669,18 @@ extern "C"
 #endif
     }
 
+    void LLFS_File_IMPL_write_behind_action(MICROEJ_ASYNC_WORKER_job_t *job)
+    {
+        FS_write_read_t *params = (FS_write_read_t *)job->params;
+
+        // nobody waits for the result: keep the error for the next synchronous operation on the file
+        LLFS_File_IMPL_write_action(job);
+        if (params->result == LLFS_NOK)
+        {
+            FS_latch_error(params->file_id, params->error_code, params->error_message);
+        }
+    }
+
     void LLFS_File_IMPL_read_action(MICROEJ_ASYNC_WORKER_job_t *job)
     {
         FS_write_read_t *params = (FS_write_read_t *)job->params;
@@ -551,6 +688,13 @@ extern "C"
         uint8_t *data = params->data;
         int32_t length = params->length;
 
+        if (FS_take_latched_error(file_id, &params->error_code, &params->error_message))
+        {
+            // a write-behind on this file failed
+            params->result = LLFS_NOK;
+            return;
+        }
+
         ssize_t read_count = read(file_id, data, length);
 
         if (read_count < 0)
@@ -585,6 +729,13 @@ extern "C"
             params->result = LLFS_NOK;
             params->error_code = errno;
             params->error_message = strerror(errno);
+            // drop the error of a write-behind, if any: the file descriptor may be reused
+            FS_drop_latched_error(file_id);
+        }
+        else if (FS_take_latched_error(file_id, &params->error_code, &params->error_message))
+        {
+            // closed, but a write-behind on this file failed
+            params->result = LLFS_NOK;
         }
         else
         {
@@ -602,6 +753,13 @@ extern "C"
         int32_t file_id = params->file_id;
         int64_t n = params->n;
 
+        if (FS_take_latched_error(file_id, &params->error_code, &params->error_message))
+        {
+            // a write-behind on this file failed
+            params->result = LLFS_NOK;
+            return;
+        }
+
         // Basically do a lseek with the given offset.
         // Before, checks the value of the offset:
         //	- don't go out of the bounds of the file:
@@ -670,6 +828,13 @@ extern "C"
         FS_available_t *params = (FS_available_t *)job->params;
         int32_t file_id = params->file_id;
 
+        if (FS_take_latched_error(file_id, &params->error_code, &params->error_message))
+        {
+            // a write-behind on this file failed
+            params->result = LLFS_NOK;
+            return;
+        }
+
         params->result = LLFS_NOK; // error by default
         params->error_code = LLFS_NOK;
         params->error_message = NULL;
@@ -702,6 +867,118 @@ extern "C"
 #endif
     }
 
+    void LLFS_File_IMPL_transfer_open_action(MICROEJ_ASYNC_WORKER_job_t *job)
+    {
+        FS_file_transfer_t *params = (FS_file_transfer_t *)job->params;
+        int open_mode;
+
+        params->result = LLFS_NOK; // error by default
+        params->error_code = LLFS_NOK;
+        params->error_message = NULL;
+
+        if (FS_open_mode(params->mode, &open_mode) != LLFS_OK)
+        {
+            params->error_code = params->mode;
+            params->error_message = "Invalid mode";
+            MICROEJ_ASYNC_WORKER_stop_chain(job);
+            return;
+        }
+
+        params->file_id = open((char *)params->path, open_mode, LLFS_NORMAL_PERMISSIONS);
+        if (params->file_id == -1)
+        {
+            params->error_code = errno;
+            params->error_message = strerror(errno);
+            MICROEJ_ASYNC_WORKER_stop_chain(job);
+        }
+        else
+        {
+            params->result = LLFS_OK;
+        }
+
+#ifdef LLFS_DEBUG
+        printf("LLFS_DEBUG [%s:%u] open file %s for transfer: %d (errno %d)\n", __FILE__, __LINE__, params->path, params->file_id, params->error_code);
+#endif
+    }
+
+    void LLFS_File_IMPL_transfer_read_action(MICROEJ_ASYNC_WORKER_job_t *job)
+    {
+        FS_file_transfer_t *params = (FS_file_transfer_t *)job->params;
+        int32_t read_total = 0;
+
+        // read until the array is full or the end of the file is reached
+        while (read_total < params->length)
+        {
+            ssize_t read_count = read(params->file_id, params->data + read_total, params->length - read_total);
+            if (read_count < 0)
+            {
+                params->result = LLFS_NOK; // error
+                params->error_code = errno;
+                params->error_message = strerror(errno);
+                // the close action is skipped
+                close(params->file_id);
+                MICROEJ_ASYNC_WORKER_stop_chain(job);
+                return;
+            }
+            if (read_count == 0)
+            {
+                break;
+            }
+            read_total += read_count;
+        }
+        params->result = (read_total == 0 && params->length > 0) ? LLFS_EOF : read_total;
+
+#ifdef LLFS_DEBUG
+        printf("LLFS_DEBUG [%s:%u] read file %d - %d bytes read\n", __FILE__, __LINE__, params->file_id, read_total);
+#endif
+    }
+
+    void LLFS_File_IMPL_transfer_write_action(MICROEJ_ASYNC_WORKER_job_t *job)
+    {
+        FS_file_transfer_t *params = (FS_file_transfer_t *)job->params;
+        int32_t written_total = 0;
+
+        while (written_total < params->length)
+        {
+            ssize_t written_count = write(params->file_id, params->data + written_total, params->length - written_total);
+            if (written_count <= 0)
+            {
+                params->result = LLFS_NOK; // error
+                params->error_code = errno;
+                params->error_message = strerror(errno);
+                // the close action is skipped
+                close(params->file_id);
+                MICROEJ_ASYNC_WORKER_stop_chain(job);
+                return;
+            }
+            written_total += written_count;
+        }
+        params->result = written_total;
+        // fsync needed
+        fsync(params->file_id);
+
+#ifdef LLFS_DEBUG
+        printf("LLFS_DEBUG [%s:%u] write file %d - %d bytes written\n", __FILE__, __LINE__, params->file_id, written_total);
+#endif
+    }
+
+    void LLFS_File_IMPL_transfer_close_action(MICROEJ_ASYNC_WORKER_job_t *job)
+    {
+        FS_file_transfer_t *params = (FS_file_transfer_t *)job->params;
+
+        // keep the result of the transfer unless the close fails
+        if (close(params->file_id) != 0)
+        {
+            params->result = LLFS_NOK;
+            params->error_code = errno;
+            params->error_message = strerror(errno);
+        }
+
+#ifdef LLFS_DEBUG
+        printf("LLFS_DEBUG [%s:%u] close file %d after transfer (status %d errno %d)\n", __FILE__, __LINE__, params->file_id, params->result, params->error_code);
+#endif
+    }
+
 #ifdef __cplusplus
 }
 #endif
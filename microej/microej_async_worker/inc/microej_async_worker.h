@@ -115,6 +115,7 @@
  * @date @CCO_DATE@
  */
 
+#include <stdbool.h>
 #include <stdint.h>
 #include "sni.h"
 #include "osal.h"
@@ -137,6 +138,74 @@ typedef struct MICROEJ_ASYNC_WORKER_job MICROEJ_ASYNC_WORKER_job_t;
 /** @brief Pointer to a function to call asynchronously. */
 typedef void (*MICROEJ_ASYNC_WORKER_action_t)(MICROEJ_ASYNC_WORKER_job_t* job);
 
+/**
+ * @brief Latency classes of the jobs. The queued jobs of the highest lane are executed first.
+ */
+typedef enum {
+	/** @brief Long operations, e.g. file writes that synchronize the storage. */
+	MICROEJ_ASYNC_WORKER_LANE_BULK = 0,
+	/** @brief Default lane of the actions not listed with <code>MICROEJ_ASYNC_WORKER_set_action_lanes()</code>. */
+	MICROEJ_ASYNC_WORKER_LANE_NORMAL,
+	/** @brief Short operations, e.g. file metadata queries. */
+	MICROEJ_ASYNC_WORKER_LANE_LATENCY,
+	/** @brief Number of lanes. */
+	MICROEJ_ASYNC_WORKER_LANE_COUNT
+} MICROEJ_ASYNC_WORKER_lane_t;
+
+/** @brief Default lane of an action, see <code>MICROEJ_ASYNC_WORKER_set_action_lanes()</code>. */
+typedef struct {
+	MICROEJ_ASYNC_WORKER_action_t action;
+	MICROEJ_ASYNC_WORKER_lane_t lane;
+} MICROEJ_ASYNC_WORKER_action_lane_t;
+
+#ifndef MICROEJ_ASYNC_WORKER_TELEMETRY_ACTION_COUNT
+/** @brief Number of distinct actions recorded per worker when MICROEJ_ASYNC_WORKER_TELEMETRY is defined. */
+#define MICROEJ_ASYNC_WORKER_TELEMETRY_ACTION_COUNT (16)
+#endif
+
+/**
+ * @brief Telemetry of the jobs of a worker executing an action, see <code>MICROEJ_ASYNC_WORKER_get_stats()</code>.
+ *
+ * The histograms have the layout of the OSAL instrumentation histograms: bucket 0 counts the durations under
+ * 1 microsecond, bucket i counts the durations in [2^(i-1), 2^i[ microseconds and the last bucket also counts the
+ * longer durations. A chain is recorded under its first action.
+ */
+typedef struct {
+	MICROEJ_ASYNC_WORKER_action_t action; // The action, NULL for an unused record
+	uint32_t jobs; // Number of jobs started
+	uint32_t queue_histogram[OSAL_STATS_HISTOGRAM_SIZE]; // Time between the submission of a job and its start
+	uint32_t run_histogram[OSAL_STATS_HISTOGRAM_SIZE]; // Time spent in the action
+	uint32_t resume_histogram[OSAL_STATS_HISTOGRAM_SIZE]; // Time between the start of a job and the Java thread resumption
+} MICROEJ_ASYNC_WORKER_action_stats_t;
+
+/** @brief Telemetry of a worker, see <code>MICROEJ_ASYNC_WORKER_get_stats()</code>. */
+typedef struct {
+	uint32_t job_exhaustions; // Calls to MICROEJ_ASYNC_WORKER_allocate_job() that found no free job
+	uint32_t waiting_list_full; // Exceptions thrown because the waiting list was full
+	int32_t waiting_list_high_water; // Maximum number of Java threads waiting for a free job
+	int32_t pending_jobs; // Number of jobs submitted and not started yet
+	int32_t pending_high_water; // Maximum number of jobs submitted and not started yet
+	uint32_t untracked_jobs; // Jobs whose action did not fit in the MICROEJ_ASYNC_WORKER_TELEMETRY_ACTION_COUNT records
+} MICROEJ_ASYNC_WORKER_stats_t;
+
+/** @brief A Java thread waiting for a free job. Internal data. */
+typedef struct {
+	int32_t thread_id; // Id of the Java thread
+	int32_t priority; // Priority of the Java thread, from 1 to 10
+} MICROEJ_ASYNC_WORKER_waiting_thread_t;
+
+/**
+ * @brief A size class of the parameters slab of a worker, declared with <code>MICROEJ_ASYNC_WORKER_params_class_declare()</code>.
+ *
+ * All the fields of this structure are internal data and must not be modified.
+ */
+typedef struct {
+	uint32_t params_size; // Size of a parameters block
+	uint32_t count; // Number of parameters blocks
+	OSAL_pool_storage_t* storage; // Storage of pool, followed by the blocks
+	OSAL_pool_handle_t pool; // Free parameters blocks
+} MICROEJ_ASYNC_WORKER_params_class_t;
+
 /**
  * @brief A job to execute in a worker.
  *
@@ -144,6 +213,35 @@ typedef void (*MICROEJ_ASYNC_WORKER_action_t)(MICROEJ_ASYNC_WORKER_job_t* job);
  * and freed using <code>MICROEJ_ASYNC_WORKER_free_job()</code>.
  */
 struct MICROEJ_ASYNC_WORKER_job{
+	/** @brief Structure internal data. Must not be modified. */
+	struct {
+		MICROEJ_ASYNC_WORKER_action_t action; // Pointer to the action to execute asynchronously. Overwritten by the jobs pool while the job is free.
+		int32_t thread_id; // Id of the Java thread that is waiting for this job to complete
+		int32_t owner; // Id of the Java thread that allocated the job, -1 while the job is free
+		const MICROEJ_ASYNC_WORKER_action_t* chain; // Actions executed in sequence, NULL when the job executes a single action
+		int32_t chain_length; // Length of the chain array
+		uint8_t chain_stopped; // Set by MICROEJ_ASYNC_WORKER_stop_chain() to skip the next actions of the chain
+		uint8_t detached; // Set when no Java thread waits for this job: the worker frees it once executed
+		uint8_t detached_epoch; // Epoch of a detached job, see MICROEJ_ASYNC_WORKER_wait_detached_jobs()
+		uint32_t state; // Queued, running, done, timed out, expired, cancelled or free in the low byte, generation of the job above. Updated atomically by the worker, the timer and the virtual machine tasks.
+		uint32_t timeout; // Maximum time in milliseconds the Java thread waits for the job, 0 to wait forever
+		uint32_t deadline; // OSAL_get_time_ms() value at which the Java thread is resumed if the job is not done, valid if timeout is set
+		SNI_callback on_done; // Callback of the suspended Java thread, suspended again with it when resumed before the job is done
+		void* worker; // The MICROEJ_ASYNC_WORKER_handle_t executing the job
+		OSAL_prio_queue_node_t node; // Link in the jobs queue
+		uint8_t lane; // Lane of the job in the jobs queue
+		int32_t key; // Affinity key, valid when has_key is set
+		uint8_t has_key; // Set when the job was executed with MICROEJ_ASYNC_WORKER_async_exec_with_key()
+		MICROEJ_ASYNC_WORKER_job_t* next_same_key; // Next job with the same key, executed after this one
+		MICROEJ_ASYNC_WORKER_job_t* last_same_key; // Last job with the same key, valid for the key owner only
+		MICROEJ_ASYNC_WORKER_job_t* next_key_owner; // Next in the key owners linked list
+		MICROEJ_ASYNC_WORKER_params_class_t* params_class; // Class of the params block of a slab worker, NULL otherwise
+#ifdef MICROEJ_ASYNC_WORKER_TELEMETRY
+		uint32_t submit_time; // OSAL_get_time_us() value when the job was submitted
+		uint32_t start_time; // OSAL_get_time_us() value when the job was started
+		MICROEJ_ASYNC_WORKER_action_stats_t* action_stats; // Record of the job action, NULL if not recorded
+#endif
+	} _intern;
 	/**
 	 * @brief Pointers to the parameters.
 	 *
@@ -151,12 +249,6 @@ struct MICROEJ_ASYNC_WORKER_job{
 	 * This pointer field must not be modified but the content of the referenced union can be modified.
 	 */
 	void* params;
-	/** @brief Structure internal data. Must not be modified. */
-	struct {
-		MICROEJ_ASYNC_WORKER_action_t action; // Pointer to the action to execute asynchronously.
-		int32_t thread_id; // Id of the Java thread that is waiting for this job to complete
-		MICROEJ_ASYNC_WORKER_job_t* next_free_job; // Next in the free jobs linked list.
-	} _intern;
 };
 
 /**
@@ -169,15 +261,39 @@ struct MICROEJ_ASYNC_WORKER_job{
  */
 typedef struct {
 	int32_t job_count; // Maximum number of jobs.
-	MICROEJ_ASYNC_WORKER_job_t* free_jobs; // Linked list of free jobs
-	void* params; // Pointer to params array. Length of this array is job_count.
-	int32_t params_sizeof; // Size of the params union
+	OSAL_pool_storage_t* jobs_pool_storage; // Storage of jobs_pool, followed by job_count jobs
+	OSAL_pool_handle_t jobs_pool; // Pool of free jobs
+	void* params; // Pointer to params array. Length of this array is job_count. NULL for a slab worker.
+	int32_t params_sizeof; // Size of the params union, size of the largest params class for a slab worker
+	MICROEJ_ASYNC_WORKER_params_class_t* const* params_classes; // Size classes of the params of a slab worker, by increasing size
+	int32_t params_classes_count; // Length of the params_classes array, 0 if the worker is not a slab worker
+	MICROEJ_ASYNC_WORKER_job_t* jobs; // First block of jobs_pool_storage: the job_count jobs are contiguous blocks of jobs_pool
+	int32_t thread_quota; // Maximum number of jobs allocated by a Java thread at a time, 0 for no limit
 	int32_t waiting_threads_length; // Length of the waiting_threads array
-	int32_t* waiting_threads; // Array of waiting threads (circular list)
-	uint16_t waiting_thread_offset; // Offset of the first waiting thread. If equals to free_waiting_thread_offset: no waiting thread
-	uint16_t free_waiting_thread_offset; // Offset of the first free slot in waiting_threads array
-	OSAL_queue_handle_t jobs_queue; // Linked list of jobs
-	OSAL_task_handle_t task; // The task that executes this worker.
+	MICROEJ_ASYNC_WORKER_waiting_thread_t* waiting_threads; // Threads waiting for a free job, by decreasing priority then in arrival order
+	int32_t waiting_threads_count; // Number of waiting threads, stored from the start of waiting_threads
+	OSAL_prio_queue_storage_t* jobs_queue_storage; // Storage of jobs_queue
+	OSAL_prio_queue_handle_t jobs_queue; // Queue of jobs to execute, one level per lane
+	const MICROEJ_ASYNC_WORKER_action_lane_t* action_lanes; // Default lane of the actions. Length of this array is action_lanes_count.
+	int32_t action_lanes_count; // Length of the action_lanes array
+	uint32_t job_timeout; // Timeout of the allocated jobs, 0 to wait forever
+	OSAL_timer_storage_t timeout_timer_storage; // Storage of timeout_timer
+	OSAL_timer_handle_t timeout_timer; // Resumes the Java threads of the jobs not done at their deadline, created with the first job with a timeout
+	uint32_t timeout_timer_deadline; // Deadline the timeout timer is started for, valid if timeout_timer_armed is set
+	uint8_t timeout_timer_armed; // Set while the timeout timer is started. Protected by jobs_mutex, like the two fields above.
+	int32_t thread_count; // Number of tasks that execute this worker
+	OSAL_task_handle_t* tasks; // The tasks that execute this worker. Length of this array is thread_count.
+	OSAL_mutex_storage_t* jobs_mutex_storage; // Storage of jobs_mutex
+	OSAL_mutex_handle_t jobs_mutex; // Protects key_owners, the jobs chained on them and the waiting threads list
+	MICROEJ_ASYNC_WORKER_job_t* key_owners; // For each key in progress, the job queued or executed. Linked list.
+	int32_t detached_pending[2]; // Number of detached jobs not executed yet, by epoch. Protected by jobs_mutex.
+	uint8_t detached_epoch; // Epoch of the detached jobs submitted now. Protected by jobs_mutex.
+	int32_t* detached_waiters; // Java threads waiting for the detached jobs. Length of this array is waiting_threads_length.
+	int32_t detached_waiters_count; // Number of waiting threads, stored from the start of detached_waiters. Protected by jobs_mutex.
+#ifdef MICROEJ_ASYNC_WORKER_TELEMETRY
+	MICROEJ_ASYNC_WORKER_stats_t stats; // Worker telemetry
+	MICROEJ_ASYNC_WORKER_action_stats_t action_stats[MICROEJ_ASYNC_WORKER_TELEMETRY_ACTION_COUNT]; // Telemetry per action, claimed on first use
+#endif
 } MICROEJ_ASYNC_WORKER_handle_t;
 
 /**
@@ -191,18 +307,102 @@ typedef struct {
  * @param  _waiting_list_size Maximum Java thread that can be suspended on <code>MICROEJ_ASYNC_WORKER_allocate_job()</code> when no job is available. Must be greater than 0.
  */
 #define MICROEJ_ASYNC_WORKER_worker_declare(_name, _job_count, _param_type, _waiting_list_size)\
+	MICROEJ_ASYNC_WORKER_worker_declare_threads(_name, _job_count, _param_type, _waiting_list_size, 1)
+
+/**
+ * @brief Declares a worker named <code>_name</code> executed by several tasks sharing the same jobs queue.
+ *
+ * This macro must be used outside of any function so the worker is declared as a global variable.
+ * Jobs executed with <code>MICROEJ_ASYNC_WORKER_async_exec()</code> may run in parallel on different tasks, use
+ * <code>MICROEJ_ASYNC_WORKER_async_exec_with_key()</code> to keep the order of related jobs.
+ *
+ * @param _name name of the worker variable.
+ * @param _job_count maximum number of jobs that can be allocated for this worker. Must be greater than 0.
+ * @param _param_type type of the union of all the parameters structures
+ * @param  _waiting_list_size Maximum Java thread that can be suspended on <code>MICROEJ_ASYNC_WORKER_allocate_job()</code> when no job is available. Must be greater than 0.
+ * @param _thread_count number of tasks that execute the jobs. Must be greater than 0.
+ */
+#define MICROEJ_ASYNC_WORKER_worker_declare_threads(_name, _job_count, _param_type, _waiting_list_size, _thread_count)\
 	_param_type _name ## _params[_job_count];\
-	MICROEJ_ASYNC_WORKER_job_t _name ## _jobs[_job_count];\
-	int32_t _name ## _waiting_threads[_waiting_list_size+1];\
+	MICROEJ_ASYNC_WORKER_worker_declare_intern(_name, _job_count, _name ## _params, sizeof(_param_type), NULL, 0, _waiting_list_size, _thread_count)
+
+/**
+ * @brief Declares a worker named <code>_name</code> whose job parameters are allocated from size classes.
+ *
+ * A job of a worker declared with <code>MICROEJ_ASYNC_WORKER_worker_declare()</code> reserves the size of the union of
+ * all the parameters structures. The jobs of a slab worker are allocated with
+ * <code>MICROEJ_ASYNC_WORKER_allocate_job_sized()</code>, that takes a parameters block from the smallest class that
+ * fits the given size and has a free block. The job count can then be raised for the operations with small parameters
+ * without reserving the largest parameters for each job.
+ * <p>
+ * This macro must be used outside of any function so the worker is declared as a global variable.
+ * For example:
+ * @code
+ *	MICROEJ_ASYNC_WORKER_params_class_declare(my_small_params, sizeof(my_small_params_t), 8);
+ *	MICROEJ_ASYNC_WORKER_params_class_declare(my_large_params, sizeof(my_worker_param_t), 2);
+ *	MICROEJ_ASYNC_WORKER_params_class_t* const my_params_classes[] = {&my_small_params, &my_large_params};
+ *	MICROEJ_ASYNC_WORKER_worker_declare_slab(my_worker, 10, my_params_classes, MY_WORKER_WAITING_LIST_SIZE, 1);
+ * @endcode
+ *
+ * @param _name name of the worker variable.
+ * @param _job_count maximum number of jobs that can be allocated for this worker. Must be greater than 0.
+ * @param _params_classes array of pointers to the size classes, by increasing size. Must be a global array.
+ * @param  _waiting_list_size Maximum Java thread that can be suspended on <code>MICROEJ_ASYNC_WORKER_allocate_job()</code> when no job is available. Must be greater than 0.
+ * @param _thread_count number of tasks that execute the jobs. Must be greater than 0.
+ */
+#define MICROEJ_ASYNC_WORKER_worker_declare_slab(_name, _job_count, _params_classes, _waiting_list_size, _thread_count)\
+	MICROEJ_ASYNC_WORKER_worker_declare_intern(_name, _job_count, NULL, 0, _params_classes, sizeof(_params_classes) / sizeof((_params_classes)[0]), _waiting_list_size, _thread_count)
+
+/**
+ * @brief Declares a size class named <code>_name</code> of the parameters slab of a worker.
+ *
+ * This macro must be used outside of any function so the class is declared as a global variable.
+ *
+ * @param _name name of the class variable.
+ * @param _params_size size of the parameters blocks of this class.
+ * @param _count number of parameters blocks of this class. Must be greater than 0.
+ */
+#define MICROEJ_ASYNC_WORKER_params_class_declare(_name, _params_size, _count)\
+	OSAL_pool_storage_declare(_name ## _storage, _params_size, _count);\
+	MICROEJ_ASYNC_WORKER_params_class_t _name = {\
+		.params_size = _params_size,\
+		.count = _count,\
+		.storage = &_name ## _storage.pool\
+	}
+
+// Declares the storages and the handle of a worker. Internal, see MICROEJ_ASYNC_WORKER_worker_declare_threads().
+#define MICROEJ_ASYNC_WORKER_worker_declare_intern(_name, _job_count, _params, _params_sizeof, _params_classes, _params_classes_count, _waiting_list_size, _thread_count)\
+	OSAL_pool_storage_declare(_name ## _jobs_pool_storage, sizeof(MICROEJ_ASYNC_WORKER_job_t), _job_count);\
+	MICROEJ_ASYNC_WORKER_waiting_thread_t _name ## _waiting_threads[_waiting_list_size];\
+	int32_t _name ## _detached_waiters[_waiting_list_size];\
+	OSAL_prio_queue_storage_declare(_name ## _jobs_queue_storage);\
+	OSAL_task_handle_t _name ## _tasks[_thread_count];\
+	OSAL_mutex_storage_declare(_name ## _jobs_mutex_storage);\
 	MICROEJ_ASYNC_WORKER_handle_t _name = {\
 		.job_count = _job_count,\
-		.free_jobs = _name ## _jobs,\
-		.params = _name ## _params,\
-		.params_sizeof = sizeof(_param_type),\
-		.waiting_threads_length = _waiting_list_size+1,\
+		.jobs_pool_storage = &_name ## _jobs_pool_storage.pool,\
+		.params = _params,\
+		.params_sizeof = _params_sizeof,\
+		.params_classes = _params_classes,\
+		.params_classes_count = _params_classes_count,\
+		.jobs = (MICROEJ_ASYNC_WORKER_job_t*)_name ## _jobs_pool_storage.blocks,\
+		.thread_quota = 0,\
+		.waiting_threads_length = _waiting_list_size,\
 		.waiting_threads = _name ## _waiting_threads,\
-		.waiting_thread_offset = 0,\
-		.free_waiting_thread_offset = 0\
+		.waiting_threads_count = 0,\
+		.jobs_queue_storage = &_name ## _jobs_queue_storage,\
+		.action_lanes = NULL,\
+		.action_lanes_count = 0,\
+		.job_timeout = 0,\
+		.timeout_timer = NULL,\
+		.timeout_timer_armed = 0,\
+		.thread_count = _thread_count,\
+		.tasks = _name ## _tasks,\
+		.jobs_mutex_storage = &_name ## _jobs_mutex_storage,\
+		.key_owners = NULL,\
+		.detached_epoch = 0,\
+		.detached_waiters = _name ## _detached_waiters,\
+		.detached_waiters_count = 0\
 	}
 
 
@@ -211,7 +411,8 @@ typedef struct {
  *
  * @param[in] worker the worker to initialize. Declared with <code>MICROEJ_ASYNC_WORKER_worker_declare()</code> macro.
  * @param[in] name worker name.
- * @param[in] stack worker task stack declared using <code>OSAL_task_stack_declare()</code> macro.
+ * @param[in] stack worker task stack declared using <code>OSAL_task_stack_declare()</code> macro. When the worker
+ * is declared with several tasks, each task is created with this stack declaration.
  * @param[in] priority worker task priority.
  *
  * @return MICROEJ_ASYNC_WORKER_INVALID_ARGS if given worker has not been correctly declared.
@@ -220,6 +421,26 @@ typedef struct {
  */
 MICROEJ_ASYNC_WORKER_status_t MICROEJ_ASYNC_WORKER_initialize(MICROEJ_ASYNC_WORKER_handle_t* worker, uint8_t* name, OSAL_task_stack_t stack, int32_t priority);
 
+/**
+ * @brief Sets the default lane of the actions of the given worker.
+ *
+ * The jobs executed with <code>MICROEJ_ASYNC_WORKER_async_exec()</code> or <code>MICROEJ_ASYNC_WORKER_async_exec_with_key()</code>
+ * are queued in the lane of their action, or in <code>MICROEJ_ASYNC_WORKER_LANE_NORMAL</code> if the action is not listed.
+ * This lane is then raised or lowered by one when the calling Java thread priority is above or below the normal priority.
+ * SNI does not give the Java thread priority: unless the integration defines
+ * <code>MICROEJ_ASYNC_WORKER_JAVA_THREAD_PRIORITY()</code>, all the threads have the normal priority and the lane of the
+ * action is used as is.
+ * <p>
+ * This function must be called within the virtual machine task, before executing jobs.
+ *
+ * @param[in] worker the worker.
+ * @param[in] action_lanes the default lanes. The array is referenced, not copied.
+ * @param[in] count length of the action_lanes array.
+ *
+ * @return MICROEJ_ASYNC_WORKER_INVALID_ARGS if a lane is not valid, otherwise MICROEJ_ASYNC_WORKER_OK.
+ */
+MICROEJ_ASYNC_WORKER_status_t MICROEJ_ASYNC_WORKER_set_action_lanes(MICROEJ_ASYNC_WORKER_handle_t* worker, const MICROEJ_ASYNC_WORKER_action_lane_t* action_lanes, int32_t count);
+
 /**
  * @brief Allocates a new job for the given worker.
  *
@@ -227,7 +448,10 @@ MICROEJ_ASYNC_WORKER_status_t MICROEJ_ASYNC_WORKER_initialize(MICROEJ_ASYNC_WORK
  * <p>
  * If there is no job available, the current Java thread is suspended, added to the waiting list and <code>NULL</code>
  * is returned. Then, when a job is available, the Java thread is resumed and the function
- * <code>sni_retry_callback</code> is called.
+ * <code>sni_retry_callback</code> is called. The waiting threads are resumed by decreasing priority, in their arrival
+ * order for a same priority. The priority is given by <code>MICROEJ_ASYNC_WORKER_JAVA_THREAD_PRIORITY()</code>, which the
+ * integration must define: by default all the threads have the normal priority and are resumed in arrival order. A thread that holds the number of jobs set with
+ * <code>MICROEJ_ASYNC_WORKER_set_thread_quota()</code> waits until one of them is freed, even if other jobs are available.
  * Usually the <code>sni_retry_callback</code> function argument is the current SNI function itself (i.e. the function
  * that is currently calling <code>MICROEJ_ASYNC_WORKER_allocate_job()</code>).
  * <p>
@@ -247,6 +471,41 @@ MICROEJ_ASYNC_WORKER_status_t MICROEJ_ASYNC_WORKER_initialize(MICROEJ_ASYNC_WORK
  */
 MICROEJ_ASYNC_WORKER_job_t* MICROEJ_ASYNC_WORKER_allocate_job(MICROEJ_ASYNC_WORKER_handle_t* worker, SNI_callback sni_retry_callback);
 
+/**
+ * @brief Limits the number of jobs a Java thread may hold at a time in the given worker.
+ *
+ * A job is held from its allocation until it is freed, which for a detached job is when the worker has executed it.
+ * The quota prevents one thread, e.g. one issuing detached writes, from taking all the jobs of the worker.
+ * <p>
+ * This function must be called within the virtual machine task.
+ *
+ * @param[in] worker the worker.
+ * @param[in] quota the maximum number of jobs held by a Java thread, 0 for no limit (default).
+ */
+void MICROEJ_ASYNC_WORKER_set_thread_quota(MICROEJ_ASYNC_WORKER_handle_t* worker, int32_t quota);
+
+/**
+ * @brief Allocates a new job whose parameters hold at least <code>params_size</code> bytes.
+ *
+ * Behaves like <code>MICROEJ_ASYNC_WORKER_allocate_job()</code>. On a worker declared with
+ * <code>MICROEJ_ASYNC_WORKER_worker_declare_slab()</code>, the parameters are taken from the smallest class that fits
+ * <code>params_size</code>, or from a larger class if all its blocks are used. When no job or no fitting block is
+ * available, the current Java thread waits in the waiting list: it may be resumed by the release of a job of another
+ * class and then wait again. <code>MICROEJ_ASYNC_WORKER_allocate_job()</code> allocates the largest parameters.
+ * <p>
+ * If <code>params_size</code> exceeds the largest parameters, an SNI exception is thrown using
+ * <code>SNI_throwNativeIOException()</code> and <code>NULL</code> is returned.
+ * <p>
+ * This function must be called within the virtual machine task.
+ *
+ * @param[in] worker the worker in which to allocate a job.
+ * @param[in] sni_retry_callback if the current Java thread has been suspended, this function is called when it is resumed.
+ * @param[in] params_size size of the parameters structure used by the job.
+ *
+ * @return A job on success or NULL if no job is available.
+ */
+MICROEJ_ASYNC_WORKER_job_t* MICROEJ_ASYNC_WORKER_allocate_job_sized(MICROEJ_ASYNC_WORKER_handle_t* worker, SNI_callback sni_retry_callback, uint32_t params_size);
+
 
 /**
  * @brief Frees a job previously allocated with MICROEJ_ASYNC_WORKER_allocate_job().
@@ -292,13 +551,279 @@ MICROEJ_ASYNC_WORKER_status_t MICROEJ_ASYNC_WORKER_free_job(MICROEJ_ASYNC_WORKER
  */
 MICROEJ_ASYNC_WORKER_status_t MICROEJ_ASYNC_WORKER_async_exec(MICROEJ_ASYNC_WORKER_handle_t* worker, MICROEJ_ASYNC_WORKER_job_t* job, MICROEJ_ASYNC_WORKER_action_t action, SNI_callback on_done_callback);
 
+/**
+ * @brief Executes several actions on the given job asynchronously, one after the other, and resumes the current Java
+ * thread once all of them are done.
+ *
+ * Behaves like <code>MICROEJ_ASYNC_WORKER_async_exec()</code>, so that a sequence of operations costs a single round trip
+ * between the virtual machine and the worker. All the actions share the job parameters. An action that fails calls
+ * <code>MICROEJ_ASYNC_WORKER_stop_chain()</code> so that the next actions are skipped. The job is queued in the lane
+ * of the first action.
+ * <p>
+ * This function must be called within the virtual machine task.
+ *
+ * @param[in] worker the worker used to execute the given job. Must be the same than the one used to allocate the job.
+ * @param[in] job the job to execute. Must have been allocated with <code>MICROEJ_ASYNC_WORKER_allocate_job()</code>.
+ * @param[in] actions the functions to execute asynchronously, in order. The array is referenced until the job is done.
+ * @param[in] count length of the actions array. Must be greater than 0.
+ * @param[in] on_done_callback the <code>SNI_callback</code> called when the job is done.
+ *
+ * @return <code>MICROEJ_ASYNC_WORKER_OK</code> on success, otherwise returns the error status
+ * <code>MICROEJ_ASYNC_WORKER_ERROR</code>.
+ */
+MICROEJ_ASYNC_WORKER_status_t MICROEJ_ASYNC_WORKER_async_exec_chain(MICROEJ_ASYNC_WORKER_handle_t* worker, MICROEJ_ASYNC_WORKER_job_t* job, const MICROEJ_ASYNC_WORKER_action_t* actions, int32_t count, SNI_callback on_done_callback);
+
+/**
+ * @brief Executes the given job asynchronously without suspending the current Java thread.
+ *
+ * The job parameters must hold a copy of all the data the action needs: the Java thread continues immediately and
+ * its arrays may be modified or moved before the action is executed. The worker frees the job once the action is
+ * done, no callback is called. The action reports its errors by its own means, for example by latching them on the
+ * resource so that the next synchronous operation on this resource throws them.
+ * <p>
+ * This function must be called within the virtual machine task.
+ *
+ * @param[in] worker the worker used to execute the given job. Must be the same than the one used to allocate the job.
+ * @param[in] job the job to execute. Must have been allocated with <code>MICROEJ_ASYNC_WORKER_allocate_job()</code>.
+ * @param[in] action the function to execute asynchronously.
+ *
+ * @return <code>MICROEJ_ASYNC_WORKER_OK</code> on success, otherwise returns the error status
+ * <code>MICROEJ_ASYNC_WORKER_ERROR</code> and the job must be freed by the caller.
+ */
+MICROEJ_ASYNC_WORKER_status_t MICROEJ_ASYNC_WORKER_async_exec_detached(MICROEJ_ASYNC_WORKER_handle_t* worker, MICROEJ_ASYNC_WORKER_job_t* job, MICROEJ_ASYNC_WORKER_action_t action);
+
+/**
+ * @brief Executes the given job asynchronously without suspending the current Java thread, after the jobs previously
+ * executed with the same key.
+ *
+ * Combines <code>MICROEJ_ASYNC_WORKER_async_exec_detached()</code> and <code>MICROEJ_ASYNC_WORKER_async_exec_with_key()</code>:
+ * a synchronous job executed later with the same key is executed after this one.
+ *
+ * @param[in] worker the worker used to execute the given job. Must be the same than the one used to allocate the job.
+ * @param[in] job the job to execute. Must have been allocated with <code>MICROEJ_ASYNC_WORKER_allocate_job()</code>.
+ * @param[in] action the function to execute asynchronously.
+ * @param[in] key the affinity key of the job.
+ *
+ * @return <code>MICROEJ_ASYNC_WORKER_OK</code> on success, otherwise returns the error status
+ * <code>MICROEJ_ASYNC_WORKER_ERROR</code> and the job must be freed by the caller.
+ */
+MICROEJ_ASYNC_WORKER_status_t MICROEJ_ASYNC_WORKER_async_exec_detached_with_key(MICROEJ_ASYNC_WORKER_handle_t* worker, MICROEJ_ASYNC_WORKER_job_t* job, MICROEJ_ASYNC_WORKER_action_t action, int32_t key);
+
+/**
+ * @brief Waits for the detached jobs executed before this call to be done.
+ *
+ * An operation without key, e.g. on a path, is not ordered with the detached jobs: calling this function first makes it
+ * see their effects. If the given worker has no detached job pending, returns <code>MICROEJ_ASYNC_WORKER_OK</code>.
+ * Otherwise the current Java thread is suspended and <code>MICROEJ_ASYNC_WORKER_ERROR</code> is returned. Then, when
+ * these jobs are done, the Java thread is resumed and the function <code>sni_retry_callback</code> is called: it calls
+ * this function again. The detached jobs executed while the thread waits delay it at most once more.
+ * <p>
+ * If the waiting list is full, an SNI exception is thrown using <code>SNI_throwNativeIOException()</code> and
+ * <code>MICROEJ_ASYNC_WORKER_ERROR</code> is returned.
+ * <p>
+ * This function must be called within the virtual machine task.
+ *
+ * @param[in] worker the worker.
+ * @param[in] sni_retry_callback the <code>SNI_callback</code> called when the detached jobs are done.
+ *
+ * @return <code>MICROEJ_ASYNC_WORKER_OK</code> if no detached job is pending, otherwise <code>MICROEJ_ASYNC_WORKER_ERROR</code>.
+ */
+MICROEJ_ASYNC_WORKER_status_t MICROEJ_ASYNC_WORKER_wait_detached_jobs(MICROEJ_ASYNC_WORKER_handle_t* worker, SNI_callback sni_retry_callback);
+
+/**
+ * @brief Skips the next actions of the job executed with <code>MICROEJ_ASYNC_WORKER_async_exec_chain()</code>.
+ *
+ * This function must be called by an action of the given job, typically when it fails. The on done callback is called
+ * as soon as the current action returns. Has no effect on a job executing a single action.
+ *
+ * @param[in] job the job being executed.
+ */
+void MICROEJ_ASYNC_WORKER_stop_chain(MICROEJ_ASYNC_WORKER_job_t* job);
+
+/**
+ * @brief Executes the given job asynchronously in the given lane.
+ *
+ * Behaves like <code>MICROEJ_ASYNC_WORKER_async_exec()</code> but overrides the default lane of the action and the
+ * priority of the calling Java thread.
+ * <p>
+ * This function must be called within the virtual machine task.
+ *
+ * @param[in] worker the worker used to execute the given job. Must be the same than the one used to allocate the job.
+ * @param[in] job the job to execute. Must have been allocated with <code>MICROEJ_ASYNC_WORKER_allocate_job()</code>.
+ * @param[in] action the function to execute asynchronously.
+ * @param[in] on_done_callback the <code>SNI_callback</code> called when the job is done.
+ * @param[in] lane the lane of the job.
+ *
+ * @return <code>MICROEJ_ASYNC_WORKER_OK</code> on success, otherwise returns the error status
+ * <code>MICROEJ_ASYNC_WORKER_ERROR</code>.
+ */
+MICROEJ_ASYNC_WORKER_status_t MICROEJ_ASYNC_WORKER_async_exec_in_lane(MICROEJ_ASYNC_WORKER_handle_t* worker, MICROEJ_ASYNC_WORKER_job_t* job, MICROEJ_ASYNC_WORKER_action_t action, SNI_callback on_done_callback, MICROEJ_ASYNC_WORKER_lane_t lane);
+
+/**
+ * @brief Executes the given job asynchronously, after the jobs previously executed with the same key.
+ *
+ * Behaves like <code>MICROEJ_ASYNC_WORKER_async_exec()</code>. In addition, on a worker declared with several tasks,
+ * jobs with the same key are executed one at a time in the order of the calls, while jobs with different keys may
+ * be executed in parallel. For example, the key of a file operation can be the file identifier. A job chained behind
+ * a job with the same key is executed right after it, whatever its lane.
+ * <p>
+ * This function must be called within the virtual machine task.
+ *
+ * @param[in] worker the worker used to execute the given job. Must be the same than the one used to allocate the job.
+ * @param[in] job the job to execute. Must have been allocated with <code>MICROEJ_ASYNC_WORKER_allocate_job()</code>.
+ * @param[in] action the function to execute asynchronously.
+ * @param[in] on_done_callback the <code>SNI_callback</code> called when the job is done.
+ * @param[in] key the affinity key of the job.
+ *
+ * @return <code>MICROEJ_ASYNC_WORKER_OK</code> on success, otherwise returns the error status
+ * <code>MICROEJ_ASYNC_WORKER_ERROR</code>.
+ */
+MICROEJ_ASYNC_WORKER_status_t MICROEJ_ASYNC_WORKER_async_exec_with_key(MICROEJ_ASYNC_WORKER_handle_t* worker, MICROEJ_ASYNC_WORKER_job_t* job, MICROEJ_ASYNC_WORKER_action_t action, SNI_callback on_done_callback, int32_t key);
+
+/**
+ * @brief Sets the default timeout of the jobs allocated for the given worker.
+ *
+ * See <code>MICROEJ_ASYNC_WORKER_set_job_timeout()</code>.
+ *
+ * @param[in] worker the worker.
+ * @param[in] timeout the maximum time in milliseconds a Java thread waits for a job, 0 to wait forever (default).
+ * The detached jobs never time out.
+ */
+void MICROEJ_ASYNC_WORKER_set_default_timeout(MICROEJ_ASYNC_WORKER_handle_t* worker, uint32_t timeout);
+
+/**
+ * @brief Sets the timeout of the given job. Must be called before executing the job.
+ *
+ * The Java thread is resumed when the timeout elapses even if the job is not done. Then
+ * <code>MICROEJ_ASYNC_WORKER_get_job_done()</code> cancels the job and throws a timeout exception. A job still queued
+ * when its deadline is reached is not executed. The timeouts are served by a timer of the worker, created on the timer
+ * service task with the first job that has a timeout. The timeout of a detached job is ignored: it is always executed.
+ *
+ * @param[in] job the job allocated with <code>MICROEJ_ASYNC_WORKER_allocate_job()</code>.
+ * @param[in] timeout the maximum time in milliseconds the Java thread waits for the job, 0 to wait forever.
+ */
+void MICROEJ_ASYNC_WORKER_set_job_timeout(MICROEJ_ASYNC_WORKER_job_t* job, uint32_t timeout);
+
+/**
+ * @brief Cancels a job the Java thread does not wait for anymore.
+ *
+ * A job still queued is dropped and freed. A running job is flagged and freed by the worker once its action returns,
+ * its Java thread is not resumed. In both cases, the job must not be used anymore.
+ * <p>
+ * This function must be called within the virtual machine task.
+ *
+ * @param[in] worker the worker executing the job.
+ * @param[in] job the job to cancel.
+ *
+ * @return <code>MICROEJ_ASYNC_WORKER_OK</code> if the job has been cancelled, <code>MICROEJ_ASYNC_WORKER_ERROR</code>
+ * if the job is already done: it must then be handled and freed as usual.
+ */
+MICROEJ_ASYNC_WORKER_status_t MICROEJ_ASYNC_WORKER_cancel_job(MICROEJ_ASYNC_WORKER_handle_t* worker, MICROEJ_ASYNC_WORKER_job_t* job);
+
+/**
+ * @brief Copies the telemetry of the given worker.
+ *
+ * The counters are updated concurrently by the worker tasks: each record is consistent only to within the jobs in
+ * progress. The telemetry is only recorded when <code>MICROEJ_ASYNC_WORKER_TELEMETRY</code> is defined
+ * (<code>CONFIG_MICROEJ_ASYNC_WORKER_TELEMETRY</code>).
+ *
+ * @param[in] worker the worker.
+ * @param[out] stats filled with the worker counters. May be NULL.
+ * @param[out] actions filled with the records of the actions executed so far. May be NULL if max is 0.
+ * @param[in] max length of the actions array.
+ * @param[out] count number of action records copied.
+ *
+ * @return <code>MICROEJ_ASYNC_WORKER_OK</code> on success, <code>MICROEJ_ASYNC_WORKER_INVALID_ARGS</code> if an
+ * argument is not valid, <code>MICROEJ_ASYNC_WORKER_ERROR</code> if the telemetry is not compiled in.
+ */
+MICROEJ_ASYNC_WORKER_status_t MICROEJ_ASYNC_WORKER_get_stats(MICROEJ_ASYNC_WORKER_handle_t* worker, MICROEJ_ASYNC_WORKER_stats_t* stats, MICROEJ_ASYNC_WORKER_action_stats_t* actions, int32_t max, int32_t* count);
+
+/**
+ * @brief Resets the counters, high-water marks and histograms of the given worker. The action records are kept.
+ *
+ * @param[in] worker the worker.
+ *
+ * @return <code>MICROEJ_ASYNC_WORKER_OK</code> on success, <code>MICROEJ_ASYNC_WORKER_ERROR</code> if the telemetry
+ * is not compiled in.
+ */
+MICROEJ_ASYNC_WORKER_status_t MICROEJ_ASYNC_WORKER_reset_stats(MICROEJ_ASYNC_WORKER_handle_t* worker);
+
+/**
+ * @brief Copies the telemetry of the given worker in an int array, for an SNI native.
+ *
+ * The array holds the <code>MICROEJ_ASYNC_WORKER_stats_t</code> fields in declaration order, the number of action
+ * records, then for each record the action address, the number of jobs and the queue, run and resume histograms of
+ * <code>OSAL_STATS_HISTOGRAM_SIZE</code> values each. The records that do not fit in the array are not copied.
+ *
+ * @param[in] worker the worker.
+ * @param[out] array the array to fill.
+ * @param[in] length length of the array.
+ *
+ * @return the number of values written, or -1 if the array is too small for the worker counters or if the telemetry
+ * is not compiled in.
+ */
+int32_t MICROEJ_ASYNC_WORKER_stats_to_array(MICROEJ_ASYNC_WORKER_handle_t* worker, int32_t* array, int32_t length);
+
+/**
+ * @brief Sets the coalescing window of the completion ring.
+ *
+ * When <code>MICROEJ_ASYNC_WORKER_COMPLETION_RING_SIZE</code> is defined
+ * (<code>CONFIG_MICROEJ_ASYNC_WORKER_COMPLETION_RING</code>), the worker tasks do not resume the Java thread of a done
+ * job: they push it in a ring shared by all the workers, drained by the virtual machine task with
+ * <code>MICROEJ_ASYNC_WORKER_drain_completions()</code>. Only the first completion pushed since the last drain may wake
+ * the virtual machine task up: immediately if the window is 0 and the task is idle, otherwise once the window elapses.
+ * The completions that do not fit in the ring resume their Java thread directly.
+ *
+ * @param[in] window the time in milliseconds a completion may wait for the virtual machine task, 0 to wake it up
+ * immediately when it is idle. The default is <code>MICROEJ_ASYNC_WORKER_COMPLETION_WINDOW_MS</code>.
+ */
+void MICROEJ_ASYNC_WORKER_set_completion_window(uint32_t window);
+
+/**
+ * @brief Tells the completion ring whether the virtual machine task waits for a wakeup.
+ *
+ * The virtual machine task sets it before its last <code>MICROEJ_ASYNC_WORKER_drain_completions()</code> call
+ * preceding its wait, and clears it when it is woken up. While it is cleared, a completion does not wake the virtual
+ * machine task up: it is drained before the task goes idle, or on the first system tick after the window. Until this
+ * function is called, the virtual machine task is considered idle.
+ *
+ * @param[in] idle true when the virtual machine task is about to wait, false when it is woken up.
+ */
+void MICROEJ_ASYNC_WORKER_set_vm_idle(bool idle);
+
+/**
+ * @brief Resumes the Java threads of the jobs pushed in the completion ring.
+ *
+ * This function must be called within the virtual machine task, when it handles a wakeup and before it goes idle.
+ *
+ * @return the number of Java threads resumed, 0 if the completion ring is not compiled in.
+ */
+int32_t MICROEJ_ASYNC_WORKER_drain_completions(void);
+
+/**
+ * @brief Returns true once the coalescing window of the first pending completion has elapsed.
+ *
+ * This function is called from the system tick interrupt: when it returns true, the caller wakes the virtual machine
+ * task up with <code>LLMJVM_schedule()</code>. It returns true once per window. On NuttX, the deadlines are counted in
+ * system ticks so that the check is a comparison with <code>clock_systimer()</code>.
+ *
+ * @return true if the virtual machine task must be woken up to drain the completion ring.
+ */
+bool MICROEJ_ASYNC_WORKER_completions_due(void);
+
 /**
  * @brief Returns the job that has been executed.
  *
  * This function must be called after the execution of a job in the function passed as <code>on_done_callback</code>
  * argument to <code>MICROEJ_ASYNC_WORKER_async_exec()</code>.
+ * <p>
+ * When the timeout of the job elapsed before the job is done, the job is cancelled, a timeout exception is thrown and
+ * <code>NULL</code> is returned. When the Java thread has been resumed for another reason, it is suspended again with
+ * the same <code>on_done_callback</code> and <code>NULL</code> is returned without exception: the callback must then
+ * return at once.
  *
- * @return the job that has been executed asynchronously or <code>NULL</code> if not called from an <code>on_done_callback</code>.
+ * @return the job that has been executed asynchronously or <code>NULL</code> if not called from an <code>on_done_callback</code>
+ * or if the job is not done.
  */
 MICROEJ_ASYNC_WORKER_job_t* MICROEJ_ASYNC_WORKER_get_job_done();
 
@@ -16,139 +16,767 @@
 
 #include "microej_async_worker.h"
 #include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
+#if defined(MICROEJ_ASYNC_WORKER_COMPLETION_RING_SIZE) && !defined(MICROEJ_ASYNC_WORKER_WAKEUP_VM)
+#include "LLMJVM_impl.h"
+#endif
+#if defined(MICROEJ_ASYNC_WORKER_COMPLETION_RING_SIZE) && defined(__NuttX__)
+#include <nuttx/clock.h>
+#endif
 
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
-	// Entry point of the async worker task.
+#ifndef MICROEJ_ASYNC_WORKER_LANE_FAIRNESS_LIMIT
+// Number of jobs of higher lanes executed before a waiting job of a lower lane, so that the bulk lane does not starve.
+#define MICROEJ_ASYNC_WORKER_LANE_FAIRNESS_LIMIT (8)
+#endif
+
+#ifndef MICROEJ_ASYNC_WORKER_JAVA_THREAD_PRIORITY
+// Priority of the current Java thread, from 1 to 10. SNI does not give access to it: define this macro to inherit the
+// priority stored by the application, by default all the threads have the normal priority.
+#define MICROEJ_ASYNC_WORKER_JAVA_THREAD_PRIORITY() (MICROEJ_ASYNC_WORKER_JAVA_NORM_PRIORITY)
+#endif
+
+#ifdef MICROEJ_ASYNC_WORKER_COMPLETION_RING_SIZE
+#if (MICROEJ_ASYNC_WORKER_COMPLETION_RING_SIZE <= 0) || ((MICROEJ_ASYNC_WORKER_COMPLETION_RING_SIZE & (MICROEJ_ASYNC_WORKER_COMPLETION_RING_SIZE - 1)) != 0)
+#error "MICROEJ_ASYNC_WORKER_COMPLETION_RING_SIZE must be a power of 2"
+#endif
+
+#ifndef MICROEJ_ASYNC_WORKER_COMPLETION_WINDOW_MS
+// Default coalescing window of the completion ring, see MICROEJ_ASYNC_WORKER_set_completion_window().
+#define MICROEJ_ASYNC_WORKER_COMPLETION_WINDOW_MS (0)
+#endif
+
+#ifndef MICROEJ_ASYNC_WORKER_WAKEUP_VM
+// Wakes up the virtual machine task so that it drains the completion ring.
+#define MICROEJ_ASYNC_WORKER_WAKEUP_VM() LLMJVM_schedule()
+#endif
+
+// Clock of the completion deadlines. On NuttX, the system tick counter: MICROEJ_ASYNC_WORKER_completions_due() is
+// called from the system tick hook.
+#ifdef __NuttX__
+#define MICROEJ_ASYNC_WORKER_COMPLETION_CLOCK() ((uint32_t)clock_systimer())
+#define MICROEJ_ASYNC_WORKER_MS_TO_COMPLETION_CLOCK(_ms) ((uint32_t)MSEC2TICK(_ms))
+#else
+#define MICROEJ_ASYNC_WORKER_COMPLETION_CLOCK() MICROEJ_ASYNC_WORKER_time_ms()
+#define MICROEJ_ASYNC_WORKER_MS_TO_COMPLETION_CLOCK(_ms) (_ms)
+#endif
+
+#define MICROEJ_ASYNC_WORKER_COMPLETION_RING_MASK (MICROEJ_ASYNC_WORKER_COMPLETION_RING_SIZE - 1)
+
+// Values of the completion ring state
+#define MICROEJ_ASYNC_WORKER_COMPLETIONS_IDLE (0)
+// Completions pushed since the last drain, the virtual machine task wakeup has been requested
+#define MICROEJ_ASYNC_WORKER_COMPLETIONS_ARMED (1)
+// Completions pushed since the last drain, the virtual machine task is woken up at the deadline
+#define MICROEJ_ASYNC_WORKER_COMPLETIONS_DEFERRED (2)
+#endif
+
+// Value of java.lang.Thread.NORM_PRIORITY
+#define MICROEJ_ASYNC_WORKER_JAVA_NORM_PRIORITY (5)
+
+// Values of the job state. Each state reached by a compare-and-swap is reached once per submission: the task that
+// publishes DONE or TIMED_OUT is the only one that resumes the Java thread.
+#define MICROEJ_ASYNC_WORKER_JOB_QUEUED (0)
+#define MICROEJ_ASYNC_WORKER_JOB_RUNNING (1)
+#define MICROEJ_ASYNC_WORKER_JOB_DONE (2)
+// Timed out and left by the worker task: freed by the virtual machine task
+#define MICROEJ_ASYNC_WORKER_JOB_EXPIRED (3)
+// Java thread not waiting anymore: freed by the worker task
+#define MICROEJ_ASYNC_WORKER_JOB_CANCELLED (4)
+// Java thread resumed by its timeout while the job is queued or running
+#define MICROEJ_ASYNC_WORKER_JOB_TIMED_OUT (5)
+// Job not submitted
+#define MICROEJ_ASYNC_WORKER_JOB_FREE (6)
+
+// The state value is stored in the low byte of the state, the generation of the job in the upper bits
+#define MICROEJ_ASYNC_WORKER_JOB_STATE_MASK (0xFF)
+#define MICROEJ_ASYNC_WORKER_JOB_GENERATION (0x100)
+#define MICROEJ_ASYNC_WORKER_JOB_STATE(_state) ((uint8_t)((_state) & MICROEJ_ASYNC_WORKER_JOB_STATE_MASK))
+#define MICROEJ_ASYNC_WORKER_JOB_WITH_STATE(_state, _value) (((_state) & ~(uint32_t)MICROEJ_ASYNC_WORKER_JOB_STATE_MASK) | (_value))
+
+	// Takes a free job and a params block of at least params_size bytes, returns NULL if one of them is not available.
+	static MICROEJ_ASYNC_WORKER_job_t *MICROEJ_ASYNC_WORKER_take_job(MICROEJ_ASYNC_WORKER_handle_t *worker, uint32_t params_size, int32_t owner);
+	// Returns true if the given Java thread holds the number of jobs allowed by the thread quota.
+	static bool MICROEJ_ASYNC_WORKER_over_quota(MICROEJ_ASYNC_WORKER_handle_t *worker, int32_t thread_id);
+	// Removes the waiting thread at the given index and resumes it. Must be called with jobs_mutex held.
+	static void MICROEJ_ASYNC_WORKER_resume_waiting_thread(MICROEJ_ASYNC_WORKER_handle_t *worker, int32_t index);
+	// Entry point of the async worker tasks.
 	static void *MICROEJ_ASYNC_WORKER_loop(void *args);
+	// Posts a job to the worker tasks, then suspends the current Java thread unless the job is detached.
+	static MICROEJ_ASYNC_WORKER_status_t MICROEJ_ASYNC_WORKER_post_job(MICROEJ_ASYNC_WORKER_handle_t *worker, MICROEJ_ASYNC_WORKER_job_t *job, SNI_callback on_done_callback);
+	// Posts a job after the jobs with the same key, then suspends the current Java thread unless the job is detached.
+	static MICROEJ_ASYNC_WORKER_status_t MICROEJ_ASYNC_WORKER_post_job_with_key(MICROEJ_ASYNC_WORKER_handle_t *worker, MICROEJ_ASYNC_WORKER_job_t *job, SNI_callback on_done_callback, int32_t key);
+	// Returns the lane of a job executed with the given action by the current Java thread.
+	static MICROEJ_ASYNC_WORKER_lane_t MICROEJ_ASYNC_WORKER_get_default_lane(MICROEJ_ASYNC_WORKER_handle_t *worker, MICROEJ_ASYNC_WORKER_action_t action);
+	// Sets the state and the deadline of a job submitted by the current Java thread.
+	static void MICROEJ_ASYNC_WORKER_prepare_job(MICROEJ_ASYNC_WORKER_handle_t *worker, MICROEJ_ASYNC_WORKER_job_t *job);
+	// Marks a fetched job as running and sets its running state, returns false if it timed out or has been cancelled.
+	static bool MICROEJ_ASYNC_WORKER_start_job(MICROEJ_ASYNC_WORKER_job_t *job, uint32_t *running_state);
+	// Frees a timed out or cancelled job, or leaves it to the virtual machine task if its Java thread has not cancelled it yet.
+	static void MICROEJ_ASYNC_WORKER_abandon_job(MICROEJ_ASYNC_WORKER_handle_t *worker, MICROEJ_ASYNC_WORKER_job_t *job);
+	// Counts a detached job in the current epoch.
+	static void MICROEJ_ASYNC_WORKER_add_detached_job(MICROEJ_ASYNC_WORKER_handle_t *worker, MICROEJ_ASYNC_WORKER_job_t *job);
+	// Uncounts a detached job executed or not queued, resumes the threads waiting for the detached jobs when its epoch is done.
+	static void MICROEJ_ASYNC_WORKER_remove_detached_job(MICROEJ_ASYNC_WORKER_handle_t *worker, MICROEJ_ASYNC_WORKER_job_t *job);
+	// Starts the timeout timer of the worker if the given deadline is the earliest one.
+	static void MICROEJ_ASYNC_WORKER_arm_timeout(MICROEJ_ASYNC_WORKER_handle_t *worker, uint32_t deadline);
+	// Timeout timer callback: resumes the Java threads whose job is not done at its deadline.
+	static void MICROEJ_ASYNC_WORKER_expire_jobs(void *args);
+	// Executes a job and the jobs chained on its key, then resumes their Java threads.
+	static void MICROEJ_ASYNC_WORKER_execute(MICROEJ_ASYNC_WORKER_handle_t *worker, MICROEJ_ASYNC_WORKER_job_t *job);
+	// Resumes the Java thread of a done job, or defers it to the virtual machine task through the completion ring.
+	static void MICROEJ_ASYNC_WORKER_complete(int32_t thread_id);
+	// Removes the given key owner from the key owners list and replaces it with the next job with the same key if any.
+	static MICROEJ_ASYNC_WORKER_job_t *MICROEJ_ASYNC_WORKER_release_key(MICROEJ_ASYNC_WORKER_handle_t *worker, MICROEJ_ASYNC_WORKER_job_t *owner);
+	static bool MICROEJ_ASYNC_WORKER_unchain_job(MICROEJ_ASYNC_WORKER_handle_t *worker, MICROEJ_ASYNC_WORKER_job_t *job);
+#ifdef MICROEJ_ASYNC_WORKER_COMPLETION_RING_SIZE
+	// Pushes the thread of a done job in the completion ring, returns false if the ring is full. Called by the worker tasks.
+	static bool MICROEJ_ASYNC_WORKER_push_completion(int32_t thread_id);
+	// Resumes the threads pushed in the completion ring until the first slot not published yet, returns their number.
+	static int32_t MICROEJ_ASYNC_WORKER_pop_completions(void);
+
+	// Slot of the completion ring. For the push of index i, seq is the round of i (i without the slot bits) when the
+	// slot is free, the round + 1 once the thread is published and the next round once the thread is resumed.
+	typedef struct
+	{
+		uint32_t seq;
+		int32_t thread_id;
+	} MICROEJ_ASYNC_WORKER_completion_t;
+
+	// Shared by all the workers: the virtual machine task drains it in one batch.
+	static MICROEJ_ASYNC_WORKER_completion_t MICROEJ_ASYNC_WORKER_completions[MICROEJ_ASYNC_WORKER_COMPLETION_RING_SIZE];
+	// Index of the next push, claimed by the worker tasks
+	static uint32_t MICROEJ_ASYNC_WORKER_completions_tail;
+	// Index of the next pop, only used by the virtual machine task
+	static uint32_t MICROEJ_ASYNC_WORKER_completions_head;
+	static uint8_t MICROEJ_ASYNC_WORKER_completions_state = MICROEJ_ASYNC_WORKER_COMPLETIONS_IDLE;
+	// In MICROEJ_ASYNC_WORKER_COMPLETION_CLOCK() units
+	static uint32_t MICROEJ_ASYNC_WORKER_completions_deadline;
+	static uint32_t MICROEJ_ASYNC_WORKER_completion_window = MICROEJ_ASYNC_WORKER_COMPLETION_WINDOW_MS;
+	// Set by the virtual machine task while it waits for a wakeup. Until the port calls
+	// MICROEJ_ASYNC_WORKER_set_vm_idle(), the virtual machine task is considered idle.
+	static uint8_t MICROEJ_ASYNC_WORKER_vm_idle = 1;
+#ifndef __NuttX__
+	// Returns the current time in milliseconds.
+	static uint32_t MICROEJ_ASYNC_WORKER_time_ms(void);
+#endif
+#endif
+#ifdef MICROEJ_ASYNC_WORKER_TELEMETRY
+	// Returns the current time in microseconds.
+	static uint32_t MICROEJ_ASYNC_WORKER_time_us(void);
+	// Adds a duration to a log2 histogram.
+	static void MICROEJ_ASYNC_WORKER_histogram_add(uint32_t *histogram, uint32_t duration_us);
+	// Returns the record of the given action, claiming a free one on first use. Returns NULL if all the records are used.
+	static MICROEJ_ASYNC_WORKER_action_stats_t *MICROEJ_ASYNC_WORKER_get_action_stats(MICROEJ_ASYNC_WORKER_handle_t *worker, MICROEJ_ASYNC_WORKER_action_t action);
+	// Adds delta to the number of pending jobs and updates its high-water mark.
+	static void MICROEJ_ASYNC_WORKER_add_pending_jobs(MICROEJ_ASYNC_WORKER_handle_t *worker, int32_t delta);
+#endif
 
 	MICROEJ_ASYNC_WORKER_status_t MICROEJ_ASYNC_WORKER_initialize(MICROEJ_ASYNC_WORKER_handle_t *worker, uint8_t *name, OSAL_task_stack_t stack, int32_t priority)
 	{
 		// Check configuration
 		int32_t job_count = worker->job_count;
-		if (job_count <= 0 || worker->waiting_threads_length <= 0)
+		if (job_count <= 0 || worker->jobs == NULL || worker->waiting_threads_length <= 0 || worker->thread_count <= 0)
+		{
+			return MICROEJ_ASYNC_WORKER_INVALID_ARGS;
+		}
+		if (worker->params == NULL && worker->params_classes_count <= 0)
 		{
 			return MICROEJ_ASYNC_WORKER_INVALID_ARGS;
 		}
 
-		// Init jobs
-		MICROEJ_ASYNC_WORKER_job_t *jobs = worker->free_jobs;
+		// Create the params pools of a slab worker
+		for (int32_t i = 0; i < worker->params_classes_count; i++)
+		{
+			MICROEJ_ASYNC_WORKER_params_class_t *params_class = worker->params_classes[i];
+			if (i > 0 && params_class->params_size < worker->params_classes[i - 1]->params_size)
+			{
+				return MICROEJ_ASYNC_WORKER_INVALID_ARGS;
+			}
+			OSAL_status_t res = OSAL_pool_create(name, params_class->params_size, params_class->count, params_class->storage, &params_class->pool);
+			if (res != OSAL_OK)
+			{
+				return MICROEJ_ASYNC_WORKER_ERROR;
+			}
+			worker->params_sizeof = (int32_t)params_class->params_size;
+		}
+
+		// Create jobs pool in the storage declared with the worker
+		OSAL_status_t res = OSAL_pool_create(name, sizeof(MICROEJ_ASYNC_WORKER_job_t), job_count, worker->jobs_pool_storage, &worker->jobs_pool);
+		if (res != OSAL_OK)
+		{
+			return MICROEJ_ASYNC_WORKER_ERROR;
+		}
+
+		// Init jobs: bind each job to its params once, the pool only uses the first word of a free job.
+		// The jobs are the blocks of the pool storage declared with the worker.
 		void *params = worker->params;
 		int32_t params_sizeof = worker->params_sizeof;
-		for (int i = 0; i < job_count - 1; i++)
+		for (int i = 0; i < job_count; i++)
 		{
-			jobs[i]._intern.next_free_job = &jobs[i + 1];
-			jobs[i].params = params;
-			params = params + params_sizeof;
+			MICROEJ_ASYNC_WORKER_job_t *job = (MICROEJ_ASYNC_WORKER_job_t *)((uint8_t *)worker->jobs + (i * OSAL_POOL_BLOCK_SIZE(sizeof(MICROEJ_ASYNC_WORKER_job_t))));
+			// The params of a slab worker are bound at allocation time
+			job->params = params;
+			job->_intern.params_class = NULL;
+			job->_intern.owner = -1;
+			job->_intern.state = MICROEJ_ASYNC_WORKER_JOB_FREE;
+			if (params != NULL)
+			{
+				params = params + params_sizeof;
+			}
 		}
-		jobs[job_count - 1]._intern.next_free_job = NULL;
-		jobs[job_count - 1].params = params;
 
-		// Create queue
-		OSAL_status_t res = OSAL_queue_create(name, worker->job_count, &worker->jobs_queue);
+		// Create queue in the storage declared with the worker: no heap allocation
+		res = OSAL_prio_queue_create_static(name, MICROEJ_ASYNC_WORKER_LANE_COUNT, worker->jobs_queue_storage, &worker->jobs_queue);
 		if (res != OSAL_OK)
 		{
 			return MICROEJ_ASYNC_WORKER_ERROR;
 		}
+		OSAL_prio_queue_set_fairness(&worker->jobs_queue, MICROEJ_ASYNC_WORKER_LANE_FAIRNESS_LIMIT);
 
-		// Create task
-		res = OSAL_task_create(MICROEJ_ASYNC_WORKER_loop, name, stack, priority, worker, &worker->task);
+		// Create the lock of the affinity keys
+		res = OSAL_mutex_create_static(name, worker->jobs_mutex_storage, &worker->jobs_mutex);
 		if (res != OSAL_OK)
 		{
 			return MICROEJ_ASYNC_WORKER_ERROR;
 		}
+
+		// Create tasks: they all fetch the same jobs queue
+		for (int i = 0; i < worker->thread_count; i++)
+		{
+			res = OSAL_task_create(MICROEJ_ASYNC_WORKER_loop, name, stack, priority, worker, &worker->tasks[i]);
+			if (res != OSAL_OK)
+			{
+				return MICROEJ_ASYNC_WORKER_ERROR;
+			}
+		}
+		return MICROEJ_ASYNC_WORKER_OK;
+	}
+
+	MICROEJ_ASYNC_WORKER_status_t MICROEJ_ASYNC_WORKER_set_action_lanes(MICROEJ_ASYNC_WORKER_handle_t *worker, const MICROEJ_ASYNC_WORKER_action_lane_t *action_lanes, int32_t count)
+	{
+		if (count < 0 || (count > 0 && action_lanes == NULL))
+		{
+			return MICROEJ_ASYNC_WORKER_INVALID_ARGS;
+		}
+		for (int32_t i = 0; i < count; i++)
+		{
+			if (action_lanes[i].lane >= MICROEJ_ASYNC_WORKER_LANE_COUNT)
+			{
+				return MICROEJ_ASYNC_WORKER_INVALID_ARGS;
+			}
+		}
+		worker->action_lanes = action_lanes;
+		worker->action_lanes_count = count;
 		return MICROEJ_ASYNC_WORKER_OK;
 	}
 
 	MICROEJ_ASYNC_WORKER_job_t *MICROEJ_ASYNC_WORKER_allocate_job(MICROEJ_ASYNC_WORKER_handle_t *async_worker, SNI_callback sni_retry_callback)
 	{
+		return MICROEJ_ASYNC_WORKER_allocate_job_sized(async_worker, sni_retry_callback, (uint32_t)async_worker->params_sizeof);
+	}
 
-		MICROEJ_ASYNC_WORKER_job_t *job = async_worker->free_jobs;
-		if (job == NULL)
+	MICROEJ_ASYNC_WORKER_job_t *MICROEJ_ASYNC_WORKER_allocate_job_sized(MICROEJ_ASYNC_WORKER_handle_t *async_worker, SNI_callback sni_retry_callback, uint32_t params_size)
+	{
+		if (params_size > (uint32_t)async_worker->params_sizeof)
+		{
+			SNI_throwNativeIOException(-1, "MICROEJ_ASYNC_WORKER: job parameters too large.");
+			return NULL;
+		}
+
+		int32_t thread_id = SNI_getCurrentJavaThreadID();
+		MICROEJ_ASYNC_WORKER_job_t *job = NULL;
+		if (!MICROEJ_ASYNC_WORKER_over_quota(async_worker, thread_id))
 		{
-			// No free job available: wait for a free job.
-			// Store the current thread id in the waiting list.
-			// First check if there is a free element in the waiting list.
-			int32_t free_waiting_thread_offset = async_worker->free_waiting_thread_offset;
-			int32_t new_free_waiting_thread_offset = free_waiting_thread_offset + 1;
-			if (new_free_waiting_thread_offset >= async_worker->waiting_threads_length)
+			job = MICROEJ_ASYNC_WORKER_take_job(async_worker, params_size, thread_id);
+			if (job != NULL)
 			{
-				new_free_waiting_thread_offset = 0;
+				return job;
 			}
+		}
 
-			if (new_free_waiting_thread_offset == async_worker->waiting_thread_offset)
+		// Detached jobs are freed by the worker tasks: retry under the lock of the waiting list so that a job freed
+		// meanwhile either is allocated here or wakes this thread up.
+		OSAL_mutex_take(&async_worker->jobs_mutex, OSAL_INFINITE_TIME);
+		if (!MICROEJ_ASYNC_WORKER_over_quota(async_worker, thread_id))
+		{
+			job = MICROEJ_ASYNC_WORKER_take_job(async_worker, params_size, thread_id);
+		}
+		if (job == NULL)
+		{
+			// No free job available, or quota reached: wait for a free job.
+#ifdef MICROEJ_ASYNC_WORKER_TELEMETRY
+			__atomic_fetch_add(&async_worker->stats.job_exhaustions, 1, __ATOMIC_RELAXED);
+#endif
+			int32_t count = async_worker->waiting_threads_count;
+			if (count == async_worker->waiting_threads_length)
 			{
 				// The waiting list is full.
+#ifdef MICROEJ_ASYNC_WORKER_TELEMETRY
+				__atomic_fetch_add(&async_worker->stats.waiting_list_full, 1, __ATOMIC_RELAXED);
+#endif
 				SNI_throwNativeIOException(-1, "MICROEJ_ASYNC_WORKER: thread cannot be suspended, waiting list is full.");
 			}
 			else
 			{
-				async_worker->free_waiting_thread_offset = (uint16_t)new_free_waiting_thread_offset;
-				int32_t thread_id = SNI_getCurrentJavaThreadID();
-				async_worker->waiting_threads[free_waiting_thread_offset] = thread_id;
+				// Insert the current thread after the threads with a higher or equal priority
+				int32_t priority = MICROEJ_ASYNC_WORKER_JAVA_THREAD_PRIORITY();
+				MICROEJ_ASYNC_WORKER_waiting_thread_t *waiting_threads = async_worker->waiting_threads;
+				int32_t index = count;
+				while (index > 0 && waiting_threads[index - 1].priority < priority)
+				{
+					waiting_threads[index] = waiting_threads[index - 1];
+					index--;
+				}
+				waiting_threads[index].thread_id = thread_id;
+				waiting_threads[index].priority = priority;
+				async_worker->waiting_threads_count = count + 1;
+#ifdef MICROEJ_ASYNC_WORKER_TELEMETRY
+				if (count + 1 > async_worker->stats.waiting_list_high_water)
+				{
+					async_worker->stats.waiting_list_high_water = count + 1;
+				}
+#endif
 				SNI_suspendCurrentJavaThreadWithCallback(0, sni_retry_callback, NULL);
 			}
+		}
+		// else free job found: already removed from the pool.
+		OSAL_mutex_give(&async_worker->jobs_mutex);
+		return job;
+	}
+
+	void MICROEJ_ASYNC_WORKER_set_thread_quota(MICROEJ_ASYNC_WORKER_handle_t *worker, int32_t quota)
+	{
+		worker->thread_quota = quota;
+	}
+
+	static bool MICROEJ_ASYNC_WORKER_over_quota(MICROEJ_ASYNC_WORKER_handle_t *worker, int32_t thread_id)
+	{
+		int32_t quota = worker->thread_quota;
+		if (quota <= 0)
+		{
+			return false;
+		}
+
+		// Few jobs: count the ones of the thread rather than maintaining a per-thread table
+		int32_t held = 0;
+		uint8_t *block = (uint8_t *)worker->jobs;
+		for (int32_t i = 0; i < worker->job_count; i++)
+		{
+			MICROEJ_ASYNC_WORKER_job_t *job = (MICROEJ_ASYNC_WORKER_job_t *)block;
+			if (__atomic_load_n(&job->_intern.owner, __ATOMIC_RELAXED) == thread_id)
+			{
+				held++;
+			}
+			block += OSAL_POOL_BLOCK_SIZE(sizeof(MICROEJ_ASYNC_WORKER_job_t));
+		}
+		return held >= quota;
+	}
 
+	static MICROEJ_ASYNC_WORKER_job_t *MICROEJ_ASYNC_WORKER_take_job(MICROEJ_ASYNC_WORKER_handle_t *worker, uint32_t params_size, int32_t owner)
+	{
+		MICROEJ_ASYNC_WORKER_job_t *job = NULL;
+		if (OSAL_pool_alloc(&worker->jobs_pool, (void **)&job) != OSAL_OK)
+		{
 			return NULL;
 		}
-		else
+
+		if (worker->params_classes_count > 0)
 		{
-			// Free job found: remove it from the free list and return it.
-			async_worker->free_jobs = job->_intern.next_free_job;
-			job->_intern.next_free_job = NULL;
-			return job;
+			// Smallest fitting class first, then borrow from the larger ones
+			void *params = NULL;
+			MICROEJ_ASYNC_WORKER_params_class_t *params_class = NULL;
+			for (int32_t i = 0; i < worker->params_classes_count && params == NULL; i++)
+			{
+				params_class = worker->params_classes[i];
+				if (params_class->params_size < params_size || OSAL_pool_alloc(&params_class->pool, &params) != OSAL_OK)
+				{
+					params = NULL;
+				}
+			}
+			if (params == NULL)
+			{
+				// Give the job back without waking up a waiting thread: the pools are as before this call
+				OSAL_pool_free(&worker->jobs_pool, job);
+				return NULL;
+			}
+			job->params = params;
+			job->_intern.params_class = params_class;
 		}
+
+		job->_intern.timeout = worker->job_timeout;
+		__atomic_store_n(&job->_intern.owner, owner, __ATOMIC_RELAXED);
+		return job;
 	}
 
 	MICROEJ_ASYNC_WORKER_status_t MICROEJ_ASYNC_WORKER_free_job(MICROEJ_ASYNC_WORKER_handle_t *worker, MICROEJ_ASYNC_WORKER_job_t *job)
 	{
-		job->_intern.next_free_job = worker->free_jobs;
-		worker->free_jobs = job;
+		// Release the params first: the job may be allocated again as soon as it is freed
+		if (job->_intern.params_class != NULL)
+		{
+			OSAL_pool_free(&job->_intern.params_class->pool, job->params);
+			job->_intern.params_class = NULL;
+		}
+		__atomic_store_n(&job->_intern.owner, -1, __ATOMIC_RELAXED);
+		// Ignored by the timeout timer until it is submitted again
+		uint32_t state = __atomic_load_n(&job->_intern.state, __ATOMIC_RELAXED);
+		__atomic_store_n(&job->_intern.state, MICROEJ_ASYNC_WORKER_JOB_WITH_STATE(state, MICROEJ_ASYNC_WORKER_JOB_FREE), __ATOMIC_RELEASE);
+		OSAL_pool_free(&worker->jobs_pool, job);
 
-		int32_t waiting_thread_offset = worker->waiting_thread_offset;
-		if (waiting_thread_offset != worker->free_waiting_thread_offset)
+		OSAL_mutex_take(&worker->jobs_mutex, OSAL_INFINITE_TIME);
+		int32_t index = 0;
+		while (index < worker->waiting_threads_count)
 		{
-			// A thread was waiting for a free job: notify it
-			int32_t thread_id = worker->waiting_threads[waiting_thread_offset];
-			int32_t new_waiting_thread_offset = waiting_thread_offset + 1;
-			if (new_waiting_thread_offset >= worker->waiting_threads_length)
+			if (MICROEJ_ASYNC_WORKER_over_quota(worker, worker->waiting_threads[index].thread_id))
 			{
-				new_waiting_thread_offset = 0;
+				// Still holds its quota of jobs: left waiting for one of them
+				index++;
+			}
+			else
+			{
+				// A thread was waiting for a free job: notify the first one by priority
+				MICROEJ_ASYNC_WORKER_resume_waiting_thread(worker, index);
+				if (worker->params_classes_count == 0)
+				{
+					break;
+				}
+				// else the released params may not fit this thread: notify all of them, those that still find no
+				// fitting params wait again
 			}
-			worker->waiting_thread_offset = new_waiting_thread_offset;
-			SNI_resumeJavaThread(thread_id);
 		}
+		OSAL_mutex_give(&worker->jobs_mutex);
 
 		return MICROEJ_ASYNC_WORKER_OK;
 	}
 
+	static void MICROEJ_ASYNC_WORKER_resume_waiting_thread(MICROEJ_ASYNC_WORKER_handle_t *worker, int32_t index)
+	{
+		MICROEJ_ASYNC_WORKER_waiting_thread_t *waiting_threads = worker->waiting_threads;
+		int32_t thread_id = waiting_threads[index].thread_id;
+		int32_t count = worker->waiting_threads_count - 1;
+		for (int32_t i = index; i < count; i++)
+		{
+			waiting_threads[i] = waiting_threads[i + 1];
+		}
+		worker->waiting_threads_count = count;
+		SNI_resumeJavaThread(thread_id);
+	}
+
 	MICROEJ_ASYNC_WORKER_status_t MICROEJ_ASYNC_WORKER_async_exec(MICROEJ_ASYNC_WORKER_handle_t *worker, MICROEJ_ASYNC_WORKER_job_t *job, MICROEJ_ASYNC_WORKER_action_t action, SNI_callback on_done_callback)
 	{
 
 		job->_intern.action = action;
 		job->_intern.thread_id = SNI_getCurrentJavaThreadID();
-		OSAL_status_t res = OSAL_queue_post(&worker->jobs_queue, job);
-		if (res == OSAL_OK)
+		job->_intern.chain = NULL;
+		job->_intern.detached = 0;
+		job->_intern.lane = MICROEJ_ASYNC_WORKER_get_default_lane(worker, action);
+		job->_intern.has_key = 0;
+		MICROEJ_ASYNC_WORKER_prepare_job(worker, job);
+		return MICROEJ_ASYNC_WORKER_post_job(worker, job, on_done_callback);
+	}
+
+	MICROEJ_ASYNC_WORKER_status_t MICROEJ_ASYNC_WORKER_async_exec_chain(MICROEJ_ASYNC_WORKER_handle_t *worker, MICROEJ_ASYNC_WORKER_job_t *job, const MICROEJ_ASYNC_WORKER_action_t *actions, int32_t count, SNI_callback on_done_callback)
+	{
+		if (actions == NULL || count <= 0)
 		{
-			SNI_suspendCurrentJavaThreadWithCallback(0, on_done_callback, job);
-			return MICROEJ_ASYNC_WORKER_OK;
+			SNI_throwNativeIOException(-1, "MICROEJ_ASYNC_WORKER: Invalid chain.");
+			return MICROEJ_ASYNC_WORKER_ERROR;
 		}
-		else
+
+		job->_intern.action = actions[0];
+		job->_intern.thread_id = SNI_getCurrentJavaThreadID();
+		job->_intern.chain = actions;
+		job->_intern.chain_length = count;
+		job->_intern.detached = 0;
+		job->_intern.lane = MICROEJ_ASYNC_WORKER_get_default_lane(worker, actions[0]);
+		job->_intern.has_key = 0;
+		MICROEJ_ASYNC_WORKER_prepare_job(worker, job);
+		return MICROEJ_ASYNC_WORKER_post_job(worker, job, on_done_callback);
+	}
+
+	void MICROEJ_ASYNC_WORKER_stop_chain(MICROEJ_ASYNC_WORKER_job_t *job)
+	{
+		job->_intern.chain_stopped = 1;
+	}
+
+	MICROEJ_ASYNC_WORKER_status_t MICROEJ_ASYNC_WORKER_async_exec_in_lane(MICROEJ_ASYNC_WORKER_handle_t *worker, MICROEJ_ASYNC_WORKER_job_t *job, MICROEJ_ASYNC_WORKER_action_t action, SNI_callback on_done_callback, MICROEJ_ASYNC_WORKER_lane_t lane)
+	{
+		if (lane >= MICROEJ_ASYNC_WORKER_LANE_COUNT)
 		{
-			SNI_throwNativeIOException(-1, "MICROEJ_ASYNC_WORKER: Internal error.");
+			SNI_throwNativeIOException(-1, "MICROEJ_ASYNC_WORKER: Invalid lane.");
 			return MICROEJ_ASYNC_WORKER_ERROR;
 		}
+
+		job->_intern.action = action;
+		job->_intern.thread_id = SNI_getCurrentJavaThreadID();
+		job->_intern.chain = NULL;
+		job->_intern.detached = 0;
+		job->_intern.lane = lane;
+		job->_intern.has_key = 0;
+		MICROEJ_ASYNC_WORKER_prepare_job(worker, job);
+		return MICROEJ_ASYNC_WORKER_post_job(worker, job, on_done_callback);
+	}
+
+	MICROEJ_ASYNC_WORKER_status_t MICROEJ_ASYNC_WORKER_async_exec_with_key(MICROEJ_ASYNC_WORKER_handle_t *worker, MICROEJ_ASYNC_WORKER_job_t *job, MICROEJ_ASYNC_WORKER_action_t action, SNI_callback on_done_callback, int32_t key)
+	{
+		job->_intern.action = action;
+		job->_intern.thread_id = SNI_getCurrentJavaThreadID();
+		job->_intern.chain = NULL;
+		job->_intern.detached = 0;
+		job->_intern.lane = MICROEJ_ASYNC_WORKER_get_default_lane(worker, action);
+		MICROEJ_ASYNC_WORKER_prepare_job(worker, job);
+		return MICROEJ_ASYNC_WORKER_post_job_with_key(worker, job, on_done_callback, key);
+	}
+
+	MICROEJ_ASYNC_WORKER_status_t MICROEJ_ASYNC_WORKER_async_exec_detached(MICROEJ_ASYNC_WORKER_handle_t *worker, MICROEJ_ASYNC_WORKER_job_t *job, MICROEJ_ASYNC_WORKER_action_t action)
+	{
+		job->_intern.action = action;
+		job->_intern.thread_id = SNI_getCurrentJavaThreadID();
+		job->_intern.chain = NULL;
+		job->_intern.detached = 1;
+		// Nobody waits for the job: it is always executed
+		job->_intern.timeout = 0;
+		job->_intern.lane = MICROEJ_ASYNC_WORKER_get_default_lane(worker, action);
+		job->_intern.has_key = 0;
+		MICROEJ_ASYNC_WORKER_prepare_job(worker, job);
+		MICROEJ_ASYNC_WORKER_add_detached_job(worker, job);
+		MICROEJ_ASYNC_WORKER_status_t status = MICROEJ_ASYNC_WORKER_post_job(worker, job, NULL);
+		if (status != MICROEJ_ASYNC_WORKER_OK)
+		{
+			MICROEJ_ASYNC_WORKER_remove_detached_job(worker, job);
+		}
+		return status;
+	}
+
+	MICROEJ_ASYNC_WORKER_status_t MICROEJ_ASYNC_WORKER_async_exec_detached_with_key(MICROEJ_ASYNC_WORKER_handle_t *worker, MICROEJ_ASYNC_WORKER_job_t *job, MICROEJ_ASYNC_WORKER_action_t action, int32_t key)
+	{
+		job->_intern.action = action;
+		job->_intern.thread_id = SNI_getCurrentJavaThreadID();
+		job->_intern.chain = NULL;
+		job->_intern.detached = 1;
+		// Nobody waits for the job: it is always executed
+		job->_intern.timeout = 0;
+		job->_intern.lane = MICROEJ_ASYNC_WORKER_get_default_lane(worker, action);
+		MICROEJ_ASYNC_WORKER_prepare_job(worker, job);
+		MICROEJ_ASYNC_WORKER_add_detached_job(worker, job);
+		MICROEJ_ASYNC_WORKER_status_t status = MICROEJ_ASYNC_WORKER_post_job_with_key(worker, job, NULL, key);
+		if (status != MICROEJ_ASYNC_WORKER_OK)
+		{
+			MICROEJ_ASYNC_WORKER_remove_detached_job(worker, job);
+		}
+		return status;
+	}
+
+	MICROEJ_ASYNC_WORKER_status_t MICROEJ_ASYNC_WORKER_wait_detached_jobs(MICROEJ_ASYNC_WORKER_handle_t *worker, SNI_callback sni_retry_callback)
+	{
+		MICROEJ_ASYNC_WORKER_status_t result = MICROEJ_ASYNC_WORKER_OK;
+		OSAL_mutex_take(&worker->jobs_mutex, OSAL_INFINITE_TIME);
+		uint8_t epoch = worker->detached_epoch;
+		if (worker->detached_pending[epoch] != 0 || worker->detached_pending[epoch ^ 1] != 0)
+		{
+			result = MICROEJ_ASYNC_WORKER_ERROR;
+			if (worker->detached_pending[epoch ^ 1] == 0)
+			{
+				// Wait for the current epoch only: the detached jobs executed from now on are counted in the next one
+				worker->detached_epoch = epoch ^ 1;
+			}
+			// else wait for the previous epoch first, then for the current one when retrying
+
+			int32_t thread_id = SNI_getCurrentJavaThreadID();
+			int32_t count = worker->detached_waiters_count;
+			int32_t index = 0;
+			while (index < count && worker->detached_waiters[index] != thread_id)
+			{
+				index++;
+			}
+			if (index == count && count == worker->waiting_threads_length)
+			{
+				// The waiting list is full.
+				SNI_throwNativeIOException(-1, "MICROEJ_ASYNC_WORKER: thread cannot be suspended, waiting list is full.");
+			}
+			else
+			{
+				if (index == count)
+				{
+					worker->detached_waiters[count] = thread_id;
+					worker->detached_waiters_count = count + 1;
+				}
+				// else already registered before a spurious resume
+				SNI_suspendCurrentJavaThreadWithCallback(0, sni_retry_callback, NULL);
+			}
+		}
+		OSAL_mutex_give(&worker->jobs_mutex);
+		return result;
+	}
+
+	static void MICROEJ_ASYNC_WORKER_add_detached_job(MICROEJ_ASYNC_WORKER_handle_t *worker, MICROEJ_ASYNC_WORKER_job_t *job)
+	{
+		OSAL_mutex_take(&worker->jobs_mutex, OSAL_INFINITE_TIME);
+		uint8_t epoch = worker->detached_epoch;
+		job->_intern.detached_epoch = epoch;
+		worker->detached_pending[epoch]++;
+		OSAL_mutex_give(&worker->jobs_mutex);
+	}
+
+	static void MICROEJ_ASYNC_WORKER_remove_detached_job(MICROEJ_ASYNC_WORKER_handle_t *worker, MICROEJ_ASYNC_WORKER_job_t *job)
+	{
+		OSAL_mutex_take(&worker->jobs_mutex, OSAL_INFINITE_TIME);
+		uint8_t epoch = job->_intern.detached_epoch;
+		worker->detached_pending[epoch]--;
+		if (worker->detached_pending[epoch] == 0)
+		{
+			// The waiting threads check again the epoch they wait for
+			for (int32_t i = 0; i < worker->detached_waiters_count; i++)
+			{
+				SNI_resumeJavaThread(worker->detached_waiters[i]);
+			}
+			worker->detached_waiters_count = 0;
+		}
+		OSAL_mutex_give(&worker->jobs_mutex);
+	}
+
+	static MICROEJ_ASYNC_WORKER_status_t MICROEJ_ASYNC_WORKER_post_job_with_key(MICROEJ_ASYNC_WORKER_handle_t *worker, MICROEJ_ASYNC_WORKER_job_t *job, SNI_callback on_done_callback, int32_t key)
+	{
+		job->_intern.has_key = 1;
+		job->_intern.key = key;
+		job->_intern.next_same_key = NULL;
+
+		// Look for a job with the same key, queued or in progress
+		OSAL_mutex_take(&worker->jobs_mutex, OSAL_INFINITE_TIME);
+		MICROEJ_ASYNC_WORKER_job_t *owner = worker->key_owners;
+		while (owner != NULL && owner->_intern.key != key)
+		{
+			owner = owner->_intern.next_key_owner;
+		}
+
+		if (owner != NULL)
+		{
+			// Chain the job: the task executing the owner executes it afterwards
+			owner->_intern.last_same_key->_intern.next_same_key = job;
+			owner->_intern.last_same_key = job;
+			OSAL_mutex_give(&worker->jobs_mutex);
+			if (!job->_intern.detached)
+			{
+				// Without SNI timeout: the timeout timer resumes the Java thread
+				job->_intern.on_done = on_done_callback;
+				SNI_suspendCurrentJavaThreadWithCallback(0, on_done_callback, job);
+			}
+			return MICROEJ_ASYNC_WORKER_OK;
+		}
+
+		// First job with this key: it becomes the key owner
+		job->_intern.last_same_key = job;
+		job->_intern.next_key_owner = worker->key_owners;
+		worker->key_owners = job;
+		OSAL_mutex_give(&worker->jobs_mutex);
+
+		MICROEJ_ASYNC_WORKER_status_t status = MICROEJ_ASYNC_WORKER_post_job(worker, job, on_done_callback);
+		if (status != MICROEJ_ASYNC_WORKER_OK)
+		{
+			// Not queued: no other job can have been chained since jobs are only executed from the virtual machine task
+			OSAL_mutex_take(&worker->jobs_mutex, OSAL_INFINITE_TIME);
+			MICROEJ_ASYNC_WORKER_release_key(worker, job);
+			OSAL_mutex_give(&worker->jobs_mutex);
+		}
+		return status;
+	}
+
+	void MICROEJ_ASYNC_WORKER_set_default_timeout(MICROEJ_ASYNC_WORKER_handle_t *worker, uint32_t timeout)
+	{
+		worker->job_timeout = timeout;
+	}
+
+	void MICROEJ_ASYNC_WORKER_set_job_timeout(MICROEJ_ASYNC_WORKER_job_t *job, uint32_t timeout)
+	{
+		job->_intern.timeout = timeout;
+	}
+
+	MICROEJ_ASYNC_WORKER_status_t MICROEJ_ASYNC_WORKER_cancel_job(MICROEJ_ASYNC_WORKER_handle_t *worker, MICROEJ_ASYNC_WORKER_job_t *job)
+	{
+		// A queued job without key is only referenced by the queue: drop it now to release its slot
+		if (!job->_intern.has_key && OSAL_prio_queue_remove(&worker->jobs_queue, &job->_intern.node) == OSAL_OK)
+		{
+#ifdef MICROEJ_ASYNC_WORKER_TELEMETRY
+			MICROEJ_ASYNC_WORKER_add_pending_jobs(worker, -1);
+#endif
+			MICROEJ_ASYNC_WORKER_free_job(worker, job);
+			return MICROEJ_ASYNC_WORKER_OK;
+		}
+
+		// A job chained behind the owner of its key is only referenced by the chain: drop it as well
+		if (job->_intern.has_key)
+		{
+			OSAL_mutex_take(&worker->jobs_mutex, OSAL_INFINITE_TIME);
+			bool unchained = MICROEJ_ASYNC_WORKER_unchain_job(worker, job);
+			OSAL_mutex_give(&worker->jobs_mutex);
+			if (unchained)
+			{
+#ifdef MICROEJ_ASYNC_WORKER_TELEMETRY
+				MICROEJ_ASYNC_WORKER_add_pending_jobs(worker, -1);
+#endif
+				MICROEJ_ASYNC_WORKER_free_job(worker, job);
+				return MICROEJ_ASYNC_WORKER_OK;
+			}
+		}
+
+		uint32_t state = __atomic_load_n(&job->_intern.state, __ATOMIC_ACQUIRE);
+		while (1)
+		{
+			uint8_t value = MICROEJ_ASYNC_WORKER_JOB_STATE(state);
+			if (value == MICROEJ_ASYNC_WORKER_JOB_DONE)
+			{
+				return MICROEJ_ASYNC_WORKER_ERROR;
+			}
+			if (value == MICROEJ_ASYNC_WORKER_JOB_EXPIRED)
+			{
+				// The worker left the job to this task
+				MICROEJ_ASYNC_WORKER_free_job(worker, job);
+				return MICROEJ_ASYNC_WORKER_OK;
+			}
+			// Owner of its key, running or timed out: the worker frees it
+			if (__atomic_compare_exchange_n(&job->_intern.state, &state, MICROEJ_ASYNC_WORKER_JOB_WITH_STATE(state, MICROEJ_ASYNC_WORKER_JOB_CANCELLED), false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+			{
+				return MICROEJ_ASYNC_WORKER_OK;
+			}
+			// else the worker updated the state meanwhile: state holds the new value
+		}
 	}
 
 	MICROEJ_ASYNC_WORKER_job_t *MICROEJ_ASYNC_WORKER_get_job_done()
 	{
 		MICROEJ_ASYNC_WORKER_job_t *job = NULL;
 		SNI_getCallbackArgs((void **)&job, NULL);
+		if (job != NULL)
+		{
+			// The thread is only resumed by the task that published DONE or TIMED_OUT
+			uint8_t state = MICROEJ_ASYNC_WORKER_JOB_STATE(__atomic_load_n(&job->_intern.state, __ATOMIC_ACQUIRE));
+			if (state == MICROEJ_ASYNC_WORKER_JOB_QUEUED || state == MICROEJ_ASYNC_WORKER_JOB_RUNNING)
+			{
+				// Resumed by someone else: wait again for the worker or the timeout
+				SNI_suspendCurrentJavaThreadWithCallback(0, job->_intern.on_done, job);
+				job = NULL;
+			}
+			else if (state != MICROEJ_ASYNC_WORKER_JOB_DONE)
+			{
+				// Timed out: the job cannot be done anymore
+				MICROEJ_ASYNC_WORKER_cancel_job((MICROEJ_ASYNC_WORKER_handle_t *)job->_intern.worker, job);
+				SNI_throwNativeIOException(ETIMEDOUT, "MICROEJ_ASYNC_WORKER: job timed out.");
+				job = NULL;
+			}
+		}
+#ifdef MICROEJ_ASYNC_WORKER_TELEMETRY
+		if (job != NULL && job->_intern.action_stats != NULL)
+		{
+			MICROEJ_ASYNC_WORKER_histogram_add(job->_intern.action_stats->resume_histogram, MICROEJ_ASYNC_WORKER_time_us() - job->_intern.start_time);
+		}
+#endif
 		return job;
 	}
 
@@ -158,18 +786,666 @@ extern "C"
 
 		while (1)
 		{
-			MICROEJ_ASYNC_WORKER_job_t *job;
-			OSAL_status_t res = OSAL_queue_fetch(&worker->jobs_queue, (void **)&job, OSAL_INFINITE_TIME);
+			// Fetch one job at a time: a job queued in a higher lane meanwhile is executed next
+			OSAL_prio_queue_node_t *node;
+			OSAL_status_t res = OSAL_prio_queue_fetch(&worker->jobs_queue, &node, OSAL_INFINITE_TIME);
 
 			if (res == OSAL_OK)
 			{
 				// New job to execute
-				job->_intern.action(job);
-				SNI_resumeJavaThread(job->_intern.thread_id);
+				MICROEJ_ASYNC_WORKER_job_t *job = (MICROEJ_ASYNC_WORKER_job_t *)((uint8_t *)node - offsetof(MICROEJ_ASYNC_WORKER_job_t, _intern.node));
+				MICROEJ_ASYNC_WORKER_execute(worker, job);
 			}
 		}
 	}
 
+	static MICROEJ_ASYNC_WORKER_lane_t MICROEJ_ASYNC_WORKER_get_default_lane(MICROEJ_ASYNC_WORKER_handle_t *worker, MICROEJ_ASYNC_WORKER_action_t action)
+	{
+		int32_t lane = MICROEJ_ASYNC_WORKER_LANE_NORMAL;
+		for (int32_t i = 0; i < worker->action_lanes_count; i++)
+		{
+			if (worker->action_lanes[i].action == action)
+			{
+				lane = worker->action_lanes[i].lane;
+				break;
+			}
+		}
+
+		// Inherit the priority of the calling Java thread
+		int32_t priority = MICROEJ_ASYNC_WORKER_JAVA_THREAD_PRIORITY();
+		if (priority > MICROEJ_ASYNC_WORKER_JAVA_NORM_PRIORITY && lane < MICROEJ_ASYNC_WORKER_LANE_COUNT - 1)
+		{
+			lane++;
+		}
+		else if (priority < MICROEJ_ASYNC_WORKER_JAVA_NORM_PRIORITY && lane > MICROEJ_ASYNC_WORKER_LANE_BULK)
+		{
+			lane--;
+		}
+		return (MICROEJ_ASYNC_WORKER_lane_t)lane;
+	}
+
+	static MICROEJ_ASYNC_WORKER_status_t MICROEJ_ASYNC_WORKER_post_job(MICROEJ_ASYNC_WORKER_handle_t *worker, MICROEJ_ASYNC_WORKER_job_t *job, SNI_callback on_done_callback)
+	{
+		OSAL_status_t res = OSAL_prio_queue_post(&worker->jobs_queue, &job->_intern.node, job->_intern.lane);
+		if (res == OSAL_OK)
+		{
+			if (!job->_intern.detached)
+			{
+				// Without SNI timeout: the timeout timer resumes the Java thread
+				job->_intern.on_done = on_done_callback;
+				SNI_suspendCurrentJavaThreadWithCallback(0, on_done_callback, job);
+			}
+			return MICROEJ_ASYNC_WORKER_OK;
+		}
+		else
+		{
+#ifdef MICROEJ_ASYNC_WORKER_TELEMETRY
+			MICROEJ_ASYNC_WORKER_add_pending_jobs(worker, -1);
+#endif
+			SNI_throwNativeIOException(-1, "MICROEJ_ASYNC_WORKER: Internal error.");
+			return MICROEJ_ASYNC_WORKER_ERROR;
+		}
+	}
+
+	static void MICROEJ_ASYNC_WORKER_prepare_job(MICROEJ_ASYNC_WORKER_handle_t *worker, MICROEJ_ASYNC_WORKER_job_t *job)
+	{
+		job->_intern.worker = worker;
+		if (job->_intern.timeout != 0)
+		{
+			uint32_t now = 0;
+			OSAL_get_time_ms(&now);
+			job->_intern.deadline = now + job->_intern.timeout;
+		}
+#ifdef MICROEJ_ASYNC_WORKER_TELEMETRY
+		job->_intern.submit_time = MICROEJ_ASYNC_WORKER_time_us();
+		MICROEJ_ASYNC_WORKER_add_pending_jobs(worker, 1);
+#endif
+		// New generation: a compare-and-swap based on a previous submission fails. Publishes the fields above.
+		uint32_t state = __atomic_load_n(&job->_intern.state, __ATOMIC_RELAXED) + MICROEJ_ASYNC_WORKER_JOB_GENERATION;
+		__atomic_store_n(&job->_intern.state, MICROEJ_ASYNC_WORKER_JOB_WITH_STATE(state, MICROEJ_ASYNC_WORKER_JOB_QUEUED), __ATOMIC_RELEASE);
+		if (job->_intern.timeout != 0)
+		{
+			MICROEJ_ASYNC_WORKER_arm_timeout(worker, job->_intern.deadline);
+		}
+	}
+
+	static bool MICROEJ_ASYNC_WORKER_start_job(MICROEJ_ASYNC_WORKER_job_t *job, uint32_t *running_state)
+	{
+		uint32_t state = __atomic_load_n(&job->_intern.state, __ATOMIC_ACQUIRE);
+		while (MICROEJ_ASYNC_WORKER_JOB_STATE(state) == MICROEJ_ASYNC_WORKER_JOB_QUEUED)
+		{
+			// Do not start a job whose Java thread is about to time out
+			bool expired = false;
+			if (job->_intern.timeout != 0)
+			{
+				uint32_t now = 0;
+				OSAL_get_time_ms(&now);
+				expired = (int32_t)(now - job->_intern.deadline) >= 0;
+			}
+			int32_t thread_id = job->_intern.thread_id;
+			uint32_t next_state = MICROEJ_ASYNC_WORKER_JOB_WITH_STATE(state, expired ? MICROEJ_ASYNC_WORKER_JOB_TIMED_OUT : MICROEJ_ASYNC_WORKER_JOB_RUNNING);
+			if (__atomic_compare_exchange_n(&job->_intern.state, &state, next_state, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+			{
+				if (expired)
+				{
+					SNI_resumeJavaThread(thread_id);
+					return false;
+				}
+				*running_state = next_state;
+				return true;
+			}
+			// else timed out or cancelled meanwhile: state holds the new value
+		}
+		return false;
+	}
+
+	static void MICROEJ_ASYNC_WORKER_abandon_job(MICROEJ_ASYNC_WORKER_handle_t *worker, MICROEJ_ASYNC_WORKER_job_t *job)
+	{
+		uint32_t state = __atomic_load_n(&job->_intern.state, __ATOMIC_ACQUIRE);
+		while (MICROEJ_ASYNC_WORKER_JOB_STATE(state) == MICROEJ_ASYNC_WORKER_JOB_TIMED_OUT)
+		{
+			// The Java thread has been resumed and cancels the job: it frees it once left
+			if (__atomic_compare_exchange_n(&job->_intern.state, &state, MICROEJ_ASYNC_WORKER_JOB_WITH_STATE(state, MICROEJ_ASYNC_WORKER_JOB_EXPIRED), false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+			{
+				return;
+			}
+			// else cancelled meanwhile: state holds the new value
+		}
+		// Cancelled
+		MICROEJ_ASYNC_WORKER_free_job(worker, job);
+	}
+
+	static void MICROEJ_ASYNC_WORKER_arm_timeout(MICROEJ_ASYNC_WORKER_handle_t *worker, uint32_t deadline)
+	{
+		OSAL_mutex_take(&worker->jobs_mutex, OSAL_INFINITE_TIME);
+		if (worker->timeout_timer == NULL)
+		{
+			// First job with a timeout: the timer service task is only started when needed
+			OSAL_timer_create_static((uint8_t *)"async worker timeout", MICROEJ_ASYNC_WORKER_expire_jobs, worker, &worker->timeout_timer_storage, &worker->timeout_timer);
+		}
+		// Without timer the Java thread waits for the job
+		if (worker->timeout_timer != NULL && (!worker->timeout_timer_armed || (int32_t)(deadline - worker->timeout_timer_deadline) < 0))
+		{
+			uint32_t now = 0;
+			OSAL_get_time_ms(&now);
+			int32_t delay = (int32_t)(deadline - now);
+			if (OSAL_timer_start(&worker->timeout_timer, delay > 0 ? (uint32_t)delay : 0, 0) == OSAL_OK)
+			{
+				worker->timeout_timer_armed = 1;
+				worker->timeout_timer_deadline = deadline;
+			}
+		}
+		OSAL_mutex_give(&worker->jobs_mutex);
+	}
+
+	static void MICROEJ_ASYNC_WORKER_expire_jobs(void *args)
+	{
+		MICROEJ_ASYNC_WORKER_handle_t *worker = (MICROEJ_ASYNC_WORKER_handle_t *)args;
+		uint32_t now = 0;
+		OSAL_get_time_ms(&now);
+
+		OSAL_mutex_take(&worker->jobs_mutex, OSAL_INFINITE_TIME);
+		bool pending = false;
+		uint32_t next_deadline = 0;
+		uint8_t *block = (uint8_t *)worker->jobs;
+		for (int32_t i = 0; i < worker->job_count; i++)
+		{
+			MICROEJ_ASYNC_WORKER_job_t *job = (MICROEJ_ASYNC_WORKER_job_t *)block;
+			block += OSAL_POOL_BLOCK_SIZE(sizeof(MICROEJ_ASYNC_WORKER_job_t));
+			uint32_t state = __atomic_load_n(&job->_intern.state, __ATOMIC_ACQUIRE);
+			uint8_t value = MICROEJ_ASYNC_WORKER_JOB_STATE(state);
+			if ((value != MICROEJ_ASYNC_WORKER_JOB_QUEUED && value != MICROEJ_ASYNC_WORKER_JOB_RUNNING) || job->_intern.timeout == 0)
+			{
+				continue;
+			}
+			// Fields of the generation read in state: a successful compare-and-swap proves the job was not submitted again
+			uint32_t deadline = job->_intern.deadline;
+			int32_t thread_id = job->_intern.thread_id;
+			if ((int32_t)(now - deadline) >= 0)
+			{
+				if (__atomic_compare_exchange_n(&job->_intern.state, &state, MICROEJ_ASYNC_WORKER_JOB_WITH_STATE(state, MICROEJ_ASYNC_WORKER_JOB_TIMED_OUT), false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+				{
+					SNI_resumeJavaThread(thread_id);
+				}
+				// else done, timed out or cancelled meanwhile
+			}
+			else if (!pending || (int32_t)(deadline - next_deadline) < 0)
+			{
+				pending = true;
+				next_deadline = deadline;
+			}
+		}
+
+		worker->timeout_timer_armed = 0;
+		if (pending && OSAL_timer_start(&worker->timeout_timer, next_deadline - now, 0) == OSAL_OK)
+		{
+			worker->timeout_timer_armed = 1;
+			worker->timeout_timer_deadline = next_deadline;
+		}
+		OSAL_mutex_give(&worker->jobs_mutex);
+	}
+
+	static void MICROEJ_ASYNC_WORKER_execute(MICROEJ_ASYNC_WORKER_handle_t *worker, MICROEJ_ASYNC_WORKER_job_t *job)
+	{
+		while (job != NULL)
+		{
+			uint32_t running_state = 0;
+			bool started = MICROEJ_ASYNC_WORKER_start_job(job, &running_state);
+#ifdef MICROEJ_ASYNC_WORKER_TELEMETRY
+			MICROEJ_ASYNC_WORKER_add_pending_jobs(worker, -1);
+			MICROEJ_ASYNC_WORKER_action_stats_t *action_stats = NULL;
+			if (started)
+			{
+				action_stats = MICROEJ_ASYNC_WORKER_get_action_stats(worker, job->_intern.action);
+				job->_intern.action_stats = action_stats;
+				job->_intern.start_time = MICROEJ_ASYNC_WORKER_time_us();
+				if (action_stats != NULL)
+				{
+					__atomic_fetch_add(&action_stats->jobs, 1, __ATOMIC_RELAXED);
+					MICROEJ_ASYNC_WORKER_histogram_add(action_stats->queue_histogram, job->_intern.start_time - job->_intern.submit_time);
+				}
+			}
+#endif
+
+			if (started)
+			{
+				if (job->_intern.chain == NULL)
+				{
+					job->_intern.action(job);
+				}
+				else
+				{
+					// Early exit: an action stops the chain on error
+					job->_intern.chain_stopped = 0;
+					for (int32_t i = 0; i < job->_intern.chain_length && !job->_intern.chain_stopped; i++)
+					{
+						job->_intern.chain[i](job);
+					}
+				}
+#ifdef MICROEJ_ASYNC_WORKER_TELEMETRY
+				if (action_stats != NULL)
+				{
+					MICROEJ_ASYNC_WORKER_histogram_add(action_stats->run_histogram, MICROEJ_ASYNC_WORKER_time_us() - job->_intern.start_time);
+				}
+#endif
+			}
+
+			// Read the job before publishing its final state: the job may be freed as soon as the Java thread sees it
+			int32_t thread_id = job->_intern.thread_id;
+			uint8_t detached = job->_intern.detached;
+			MICROEJ_ASYNC_WORKER_job_t *next_job = NULL;
+			if (job->_intern.has_key)
+			{
+				OSAL_mutex_take(&worker->jobs_mutex, OSAL_INFINITE_TIME);
+				next_job = MICROEJ_ASYNC_WORKER_release_key(worker, job);
+				OSAL_mutex_give(&worker->jobs_mutex);
+			}
+
+			if (detached)
+			{
+				// No Java thread waits for this job
+				MICROEJ_ASYNC_WORKER_remove_detached_job(worker, job);
+				MICROEJ_ASYNC_WORKER_free_job(worker, job);
+			}
+			else if (started && __atomic_compare_exchange_n(&job->_intern.state, &running_state, MICROEJ_ASYNC_WORKER_JOB_WITH_STATE(running_state, MICROEJ_ASYNC_WORKER_JOB_DONE), false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+			{
+				// Neither timed out nor cancelled: this task is the only one to resume the Java thread
+				MICROEJ_ASYNC_WORKER_complete(thread_id);
+			}
+			else
+			{
+				// Timed out or cancelled before it started or while running
+				MICROEJ_ASYNC_WORKER_abandon_job(worker, job);
+			}
+			job = next_job;
+		}
+	}
+
+	static MICROEJ_ASYNC_WORKER_job_t *MICROEJ_ASYNC_WORKER_release_key(MICROEJ_ASYNC_WORKER_handle_t *worker, MICROEJ_ASYNC_WORKER_job_t *owner)
+	{
+		MICROEJ_ASYNC_WORKER_job_t *next_job = owner->_intern.next_same_key;
+		MICROEJ_ASYNC_WORKER_job_t **link = &worker->key_owners;
+		while (*link != owner)
+		{
+			link = &(*link)->_intern.next_key_owner;
+		}
+
+		if (next_job != NULL)
+		{
+			// The next job with the same key becomes the key owner
+			next_job->_intern.last_same_key = owner->_intern.last_same_key;
+			next_job->_intern.next_key_owner = owner->_intern.next_key_owner;
+			*link = next_job;
+		}
+		else
+		{
+			*link = owner->_intern.next_key_owner;
+		}
+		return next_job;
+	}
+
+	// Must be called with jobs_mutex taken. Returns false if the job is not chained behind the owner of its key.
+	static bool MICROEJ_ASYNC_WORKER_unchain_job(MICROEJ_ASYNC_WORKER_handle_t *worker, MICROEJ_ASYNC_WORKER_job_t *job)
+	{
+		MICROEJ_ASYNC_WORKER_job_t *owner = worker->key_owners;
+		while (owner != NULL && owner->_intern.key != job->_intern.key)
+		{
+			owner = owner->_intern.next_key_owner;
+		}
+		if (owner == NULL || owner == job)
+		{
+			// Not queued with its key anymore, or executed next by the worker
+			return false;
+		}
+
+		MICROEJ_ASYNC_WORKER_job_t *previous = owner;
+		while (previous->_intern.next_same_key != NULL && previous->_intern.next_same_key != job)
+		{
+			previous = previous->_intern.next_same_key;
+		}
+		if (previous->_intern.next_same_key == NULL)
+		{
+			return false;
+		}
+
+		previous->_intern.next_same_key = job->_intern.next_same_key;
+		if (owner->_intern.last_same_key == job)
+		{
+			owner->_intern.last_same_key = previous;
+		}
+		return true;
+	}
+
+#ifdef MICROEJ_ASYNC_WORKER_COMPLETION_RING_SIZE
+
+	static void MICROEJ_ASYNC_WORKER_complete(int32_t thread_id)
+	{
+		if (!MICROEJ_ASYNC_WORKER_push_completion(thread_id))
+		{
+			// Ring full: a wakeup of the virtual machine task is already pending
+			SNI_resumeJavaThread(thread_id);
+			return;
+		}
+
+		// Publish before arming: a drain that disarms the ring afterwards pops this completion, otherwise this task arms it
+		uint8_t state = MICROEJ_ASYNC_WORKER_COMPLETIONS_IDLE;
+		if (__atomic_compare_exchange_n(&MICROEJ_ASYNC_WORKER_completions_state, &state, MICROEJ_ASYNC_WORKER_COMPLETIONS_ARMED, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+		{
+			// First completion since the last drain. Arming is ordered before reading the idle flag: the virtual machine
+			// task sets it before its last drain, so that either it pops this completion or this task wakes it up.
+			uint32_t window = __atomic_load_n(&MICROEJ_ASYNC_WORKER_completion_window, __ATOMIC_RELAXED);
+			if (window == 0 && __atomic_load_n(&MICROEJ_ASYNC_WORKER_vm_idle, __ATOMIC_SEQ_CST) != 0)
+			{
+				MICROEJ_ASYNC_WORKER_WAKEUP_VM();
+			}
+			else
+			{
+				// The virtual machine task is running, or the window is not elapsed: it drains the ring before going
+				// idle, and at the latest on the first system tick after the deadline
+				__atomic_store_n(&MICROEJ_ASYNC_WORKER_completions_deadline, MICROEJ_ASYNC_WORKER_COMPLETION_CLOCK() + MICROEJ_ASYNC_WORKER_MS_TO_COMPLETION_CLOCK(window), __ATOMIC_RELAXED);
+				state = MICROEJ_ASYNC_WORKER_COMPLETIONS_ARMED;
+				__atomic_compare_exchange_n(&MICROEJ_ASYNC_WORKER_completions_state, &state, MICROEJ_ASYNC_WORKER_COMPLETIONS_DEFERRED, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+				// else drained meanwhile
+			}
+		}
+		// else the ring is already armed
+	}
+
+	static bool MICROEJ_ASYNC_WORKER_push_completion(int32_t thread_id)
+	{
+		uint32_t index = __atomic_load_n(&MICROEJ_ASYNC_WORKER_completions_tail, __ATOMIC_RELAXED);
+		while (1)
+		{
+			MICROEJ_ASYNC_WORKER_completion_t *slot = &MICROEJ_ASYNC_WORKER_completions[index & MICROEJ_ASYNC_WORKER_COMPLETION_RING_MASK];
+			uint32_t round = index & ~MICROEJ_ASYNC_WORKER_COMPLETION_RING_MASK;
+			int32_t diff = (int32_t)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - round);
+			if (diff == 0)
+			{
+				// Free slot: claim it, unless another worker task claimed it meanwhile
+				if (__atomic_compare_exchange_n(&MICROEJ_ASYNC_WORKER_completions_tail, &index, index + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+				{
+					slot->thread_id = thread_id;
+					__atomic_store_n(&slot->seq, round + 1, __ATOMIC_RELEASE);
+					return true;
+				}
+				// else index holds the new tail
+			}
+			else if (diff < 0)
+			{
+				// The slot still holds a thread of the previous round
+				return false;
+			}
+			else
+			{
+				// Claimed by another worker task meanwhile
+				index = __atomic_load_n(&MICROEJ_ASYNC_WORKER_completions_tail, __ATOMIC_RELAXED);
+			}
+		}
+	}
+
+	static int32_t MICROEJ_ASYNC_WORKER_pop_completions(void)
+	{
+		int32_t count = 0;
+		uint32_t index = MICROEJ_ASYNC_WORKER_completions_head;
+		while (1)
+		{
+			MICROEJ_ASYNC_WORKER_completion_t *slot = &MICROEJ_ASYNC_WORKER_completions[index & MICROEJ_ASYNC_WORKER_COMPLETION_RING_MASK];
+			uint32_t round = index & ~MICROEJ_ASYNC_WORKER_COMPLETION_RING_MASK;
+			if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != round + 1)
+			{
+				// Empty, or claimed but not published yet: its worker task arms the ring once published
+				break;
+			}
+			int32_t thread_id = slot->thread_id;
+			__atomic_store_n(&slot->seq, round + MICROEJ_ASYNC_WORKER_COMPLETION_RING_SIZE, __ATOMIC_RELEASE);
+			index++;
+			SNI_resumeJavaThread(thread_id);
+			count++;
+		}
+		MICROEJ_ASYNC_WORKER_completions_head = index;
+		return count;
+	}
+
+	void MICROEJ_ASYNC_WORKER_set_completion_window(uint32_t window)
+	{
+		__atomic_store_n(&MICROEJ_ASYNC_WORKER_completion_window, window, __ATOMIC_RELAXED);
+	}
+
+	void MICROEJ_ASYNC_WORKER_set_vm_idle(bool idle)
+	{
+		__atomic_store_n(&MICROEJ_ASYNC_WORKER_vm_idle, idle ? 1 : 0, __ATOMIC_SEQ_CST);
+	}
+
+	int32_t MICROEJ_ASYNC_WORKER_drain_completions(void)
+	{
+		if (__atomic_load_n(&MICROEJ_ASYNC_WORKER_completions_state, __ATOMIC_SEQ_CST) == MICROEJ_ASYNC_WORKER_COMPLETIONS_IDLE)
+		{
+			// Nothing published since the last drain
+			return 0;
+		}
+		int32_t count = MICROEJ_ASYNC_WORKER_pop_completions();
+		// Disarm, then pop the completions published by the worker tasks that found the ring armed
+		__atomic_store_n(&MICROEJ_ASYNC_WORKER_completions_state, MICROEJ_ASYNC_WORKER_COMPLETIONS_IDLE, __ATOMIC_SEQ_CST);
+		count += MICROEJ_ASYNC_WORKER_pop_completions();
+		return count;
+	}
+
+	bool MICROEJ_ASYNC_WORKER_completions_due(void)
+	{
+		if (__atomic_load_n(&MICROEJ_ASYNC_WORKER_completions_state, __ATOMIC_ACQUIRE) != MICROEJ_ASYNC_WORKER_COMPLETIONS_DEFERRED)
+		{
+			return false;
+		}
+		if ((int32_t)(MICROEJ_ASYNC_WORKER_COMPLETION_CLOCK() - __atomic_load_n(&MICROEJ_ASYNC_WORKER_completions_deadline, __ATOMIC_RELAXED)) < 0)
+		{
+			return false;
+		}
+		// Report the deadline once: the ring stays armed until the virtual machine task drains it
+		uint8_t state = MICROEJ_ASYNC_WORKER_COMPLETIONS_DEFERRED;
+		return __atomic_compare_exchange_n(&MICROEJ_ASYNC_WORKER_completions_state, &state, MICROEJ_ASYNC_WORKER_COMPLETIONS_ARMED, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+	}
+
+#ifndef __NuttX__
+	static uint32_t MICROEJ_ASYNC_WORKER_time_ms(void)
+	{
+		uint32_t now = 0;
+		OSAL_get_time_ms(&now);
+		return now;
+	}
+#endif
+
+#else // MICROEJ_ASYNC_WORKER_COMPLETION_RING_SIZE
+
+	static void MICROEJ_ASYNC_WORKER_complete(int32_t thread_id)
+	{
+		SNI_resumeJavaThread(thread_id);
+	}
+
+	void MICROEJ_ASYNC_WORKER_set_completion_window(uint32_t window)
+	{
+	}
+
+	void MICROEJ_ASYNC_WORKER_set_vm_idle(bool idle)
+	{
+	}
+
+	int32_t MICROEJ_ASYNC_WORKER_drain_completions(void)
+	{
+		return 0;
+	}
+
+	bool MICROEJ_ASYNC_WORKER_completions_due(void)
+	{
+		return false;
+	}
+
+#endif // MICROEJ_ASYNC_WORKER_COMPLETION_RING_SIZE
+
+#ifdef MICROEJ_ASYNC_WORKER_TELEMETRY
+
+	MICROEJ_ASYNC_WORKER_status_t MICROEJ_ASYNC_WORKER_get_stats(MICROEJ_ASYNC_WORKER_handle_t *worker, MICROEJ_ASYNC_WORKER_stats_t *stats, MICROEJ_ASYNC_WORKER_action_stats_t *actions, int32_t max, int32_t *count)
+	{
+		if (max < 0 || (actions == NULL && max != 0) || count == NULL)
+		{
+			return MICROEJ_ASYNC_WORKER_INVALID_ARGS;
+		}
+
+		if (stats != NULL)
+		{
+			*stats = worker->stats;
+		}
+		int32_t copied = 0;
+		for (int32_t i = 0; i < MICROEJ_ASYNC_WORKER_TELEMETRY_ACTION_COUNT && copied < max; i++)
+		{
+			if (__atomic_load_n(&worker->action_stats[i].action, __ATOMIC_ACQUIRE) != NULL)
+			{
+				actions[copied] = worker->action_stats[i];
+				copied++;
+			}
+		}
+		*count = copied;
+		return MICROEJ_ASYNC_WORKER_OK;
+	}
+
+	MICROEJ_ASYNC_WORKER_status_t MICROEJ_ASYNC_WORKER_reset_stats(MICROEJ_ASYNC_WORKER_handle_t *worker)
+	{
+		// The number of pending jobs is a current value, not a counter
+		worker->stats.job_exhaustions = 0;
+		worker->stats.waiting_list_full = 0;
+		worker->stats.waiting_list_high_water = 0;
+		worker->stats.pending_high_water = worker->stats.pending_jobs;
+		worker->stats.untracked_jobs = 0;
+		for (int32_t i = 0; i < MICROEJ_ASYNC_WORKER_TELEMETRY_ACTION_COUNT; i++)
+		{
+			MICROEJ_ASYNC_WORKER_action_stats_t *action_stats = &worker->action_stats[i];
+			action_stats->jobs = 0;
+			memset(action_stats->queue_histogram, 0, sizeof(action_stats->queue_histogram));
+			memset(action_stats->run_histogram, 0, sizeof(action_stats->run_histogram));
+			memset(action_stats->resume_histogram, 0, sizeof(action_stats->resume_histogram));
+		}
+		return MICROEJ_ASYNC_WORKER_OK;
+	}
+
+	int32_t MICROEJ_ASYNC_WORKER_stats_to_array(MICROEJ_ASYNC_WORKER_handle_t *worker, int32_t *array, int32_t length)
+	{
+		// Worker counters and number of records, then per record: action, jobs and 3 histograms
+		const int32_t header_length = 7;
+		const int32_t record_length = 2 + (3 * OSAL_STATS_HISTOGRAM_SIZE);
+		if (array == NULL || length < header_length)
+		{
+			return -1;
+		}
+
+		MICROEJ_ASYNC_WORKER_stats_t stats = worker->stats;
+		array[0] = (int32_t)stats.job_exhaustions;
+		array[1] = (int32_t)stats.waiting_list_full;
+		array[2] = stats.waiting_list_high_water;
+		array[3] = stats.pending_jobs;
+		array[4] = stats.pending_high_water;
+		array[5] = (int32_t)stats.untracked_jobs;
+
+		int32_t offset = header_length;
+		int32_t records = 0;
+		for (int32_t i = 0; i < MICROEJ_ASYNC_WORKER_TELEMETRY_ACTION_COUNT && offset + record_length <= length; i++)
+		{
+			MICROEJ_ASYNC_WORKER_action_stats_t *action_stats = &worker->action_stats[i];
+			if (__atomic_load_n(&action_stats->action, __ATOMIC_ACQUIRE) != NULL)
+			{
+				array[offset++] = (int32_t)(intptr_t)action_stats->action;
+				array[offset++] = (int32_t)action_stats->jobs;
+				for (int32_t j = 0; j < OSAL_STATS_HISTOGRAM_SIZE; j++)
+				{
+					array[offset++] = (int32_t)action_stats->queue_histogram[j];
+				}
+				for (int32_t j = 0; j < OSAL_STATS_HISTOGRAM_SIZE; j++)
+				{
+					array[offset++] = (int32_t)action_stats->run_histogram[j];
+				}
+				for (int32_t j = 0; j < OSAL_STATS_HISTOGRAM_SIZE; j++)
+				{
+					array[offset++] = (int32_t)action_stats->resume_histogram[j];
+				}
+				records++;
+			}
+		}
+		array[6] = records;
+		return offset;
+	}
+
+	static uint32_t MICROEJ_ASYNC_WORKER_time_us(void)
+	{
+		uint32_t now = 0;
+		OSAL_get_time_us(&now);
+		return now;
+	}
+
+	static void MICROEJ_ASYNC_WORKER_histogram_add(uint32_t *histogram, uint32_t duration_us)
+	{
+		// bucket i holds [2^(i-1), 2^i[ us, like the OSAL instrumentation
+		uint32_t bucket = (duration_us == 0) ? 0 : (32 - __builtin_clz(duration_us));
+		if (bucket >= OSAL_STATS_HISTOGRAM_SIZE)
+		{
+			bucket = OSAL_STATS_HISTOGRAM_SIZE - 1;
+		}
+		__atomic_fetch_add(&histogram[bucket], 1, __ATOMIC_RELAXED);
+	}
+
+	static MICROEJ_ASYNC_WORKER_action_stats_t *MICROEJ_ASYNC_WORKER_get_action_stats(MICROEJ_ASYNC_WORKER_handle_t *worker, MICROEJ_ASYNC_WORKER_action_t action)
+	{
+		for (int32_t i = 0; i < MICROEJ_ASYNC_WORKER_TELEMETRY_ACTION_COUNT; i++)
+		{
+			MICROEJ_ASYNC_WORKER_action_stats_t *action_stats = &worker->action_stats[i];
+			MICROEJ_ASYNC_WORKER_action_t recorded = __atomic_load_n(&action_stats->action, __ATOMIC_ACQUIRE);
+			if (recorded == NULL)
+			{
+				// Free record: claim it, unless another worker task claimed it meanwhile
+				if (__atomic_compare_exchange_n(&action_stats->action, &recorded, action, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+				{
+					return action_stats;
+				}
+			}
+			if (recorded == action)
+			{
+				return action_stats;
+			}
+		}
+		__atomic_fetch_add(&worker->stats.untracked_jobs, 1, __ATOMIC_RELAXED);
+		return NULL;
+	}
+
+	static void MICROEJ_ASYNC_WORKER_add_pending_jobs(MICROEJ_ASYNC_WORKER_handle_t *worker, int32_t delta)
+	{
+		int32_t pending = __atomic_add_fetch(&worker->stats.pending_jobs, delta, __ATOMIC_RELAXED);
+		int32_t high_water = __atomic_load_n(&worker->stats.pending_high_water, __ATOMIC_RELAXED);
+		while (pending > high_water && !__atomic_compare_exchange_n(&worker->stats.pending_high_water, &high_water, pending, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+		{
+			// high_water holds the new value
+		}
+	}
+
+#else // MICROEJ_ASYNC_WORKER_TELEMETRY
+
+	MICROEJ_ASYNC_WORKER_status_t MICROEJ_ASYNC_WORKER_get_stats(MICROEJ_ASYNC_WORKER_handle_t *worker, MICROEJ_ASYNC_WORKER_stats_t *stats, MICROEJ_ASYNC_WORKER_action_stats_t *actions, int32_t max, int32_t *count)
+	{
+		if (count != NULL)
+		{
+			*count = 0;
+		}
+		return MICROEJ_ASYNC_WORKER_ERROR;
+	}
+
+	MICROEJ_ASYNC_WORKER_status_t MICROEJ_ASYNC_WORKER_reset_stats(MICROEJ_ASYNC_WORKER_handle_t *worker)
+	{
+		return MICROEJ_ASYNC_WORKER_ERROR;
+	}
+
+	int32_t MICROEJ_ASYNC_WORKER_stats_to_array(MICROEJ_ASYNC_WORKER_handle_t *worker, int32_t *array, int32_t length)
+	{
+		return -1;
+	}
+
+#endif // MICROEJ_ASYNC_WORKER_TELEMETRY
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,433 @@
+/*
+ * C
+ *
+ * Copyright 2019 MicroEJ Corp. All rights reserved.
+ * This library is provided in source code for use, modification and test, subject to license terms.
+ * Any modification of the source code will break MicroEJ Corp. warranties on the whole library.
+ */
+
+/**
+ * @file
+ * @brief Asynchronous Worker host benchmarks and stress tests
+ * @author MicroEJ Developer Team
+ * @version 0.1.0
+ * @date 17 October 2026
+ *
+ * Usage: microej_async_worker_bench [-g] [benchmark...]
+ * Without benchmark name, all the benchmarks are run. With -g, each benchmark compares its results to the thresholds
+ * below and the program exits with a non-zero status if one of them is exceeded (regression gate).
+ *
+ * The Java threads run on the fake virtual machine of sni_stub.c. Each of them calls a native function that executes
+ * a job on the worker, then checks the result of the job in its Java code and calls the native function again. The
+ * port functions of the fake virtual machine drain the completion ring like the NuttX port: the benchmarks compare
+ * the completion ring (microej_async_worker_bench_ring) with the direct resumes (microej_async_worker_bench).
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "sni.h"
+#include "osal.h"
+#include "osal_bench_helper.h"
+#include "microej_async_worker.h"
+
+// Gate thresholds. They are loose enough for a loaded single CPU host: they catch lost resumes, leaked jobs and late
+// timeouts, not small performance variations.
+#ifndef MICROEJ_ASYNC_WORKER_BENCH_MAX_P99_LATENCY_US
+#define MICROEJ_ASYNC_WORKER_BENCH_MAX_P99_LATENCY_US (5000)
+#endif
+#ifndef MICROEJ_ASYNC_WORKER_BENCH_MIN_THROUGHPUT
+#define MICROEJ_ASYNC_WORKER_BENCH_MIN_THROUGHPUT (1000)
+#endif
+#ifndef MICROEJ_ASYNC_WORKER_BENCH_MAX_OVERSHOOT_US
+#define MICROEJ_ASYNC_WORKER_BENCH_MAX_OVERSHOOT_US (20000)
+#endif
+
+// Worker configuration, e.g. -DMICROEJ_ASYNC_WORKER_BENCH_TASKS=1 to compare with a single worker task
+#ifndef MICROEJ_ASYNC_WORKER_BENCH_JOB_COUNT
+#define MICROEJ_ASYNC_WORKER_BENCH_JOB_COUNT (16)
+#endif
+#ifndef MICROEJ_ASYNC_WORKER_BENCH_WAITING_LIST_SIZE
+#define MICROEJ_ASYNC_WORKER_BENCH_WAITING_LIST_SIZE (32)
+#endif
+#ifndef MICROEJ_ASYNC_WORKER_BENCH_TASKS
+#define MICROEJ_ASYNC_WORKER_BENCH_TASKS (2)
+#endif
+
+#define MICROEJ_ASYNC_WORKER_BENCH_STACK_SIZE (65536)
+#define MICROEJ_ASYNC_WORKER_BENCH_PRIORITY (100)
+#define MICROEJ_ASYNC_WORKER_BENCH_JOBS (20000)
+#define MICROEJ_ASYNC_WORKER_BENCH_MAX_THREADS (MICROEJ_ASYNC_WORKER_BENCH_WAITING_LIST_SIZE)
+#define MICROEJ_ASYNC_WORKER_BENCH_EXHAUSTION_JOBS (200)
+#define MICROEJ_ASYNC_WORKER_BENCH_EXHAUSTION_WORK_US (50)
+#define MICROEJ_ASYNC_WORKER_BENCH_TIMEOUT_THREADS (4)
+#define MICROEJ_ASYNC_WORKER_BENCH_TIMEOUT_JOBS (20)
+#define MICROEJ_ASYNC_WORKER_BENCH_TIMEOUT_MS (10)
+#define MICROEJ_ASYNC_WORKER_BENCH_SLOW_JOB_MS (40)
+#define MICROEJ_ASYNC_WORKER_BENCH_WAKEUP_THREADS (8)
+#define MICROEJ_ASYNC_WORKER_BENCH_WAKEUP_WORK_US (20)
+// Period of the system tick of the fake virtual machine
+#define MICROEJ_ASYNC_WORKER_BENCH_TICK_MS (1)
+
+typedef struct
+{
+	uint32_t value;
+	uint32_t result;
+	uint32_t work_us; // Busy loop duration of the action
+	uint32_t sleep_ms; // Sleep duration of the action
+} microej_async_worker_bench_params_t;
+
+// A Java thread of the benchmark
+typedef struct
+{
+	uint32_t remaining; // Jobs left to execute
+	uint32_t sequence;
+	uint32_t work_us;
+	uint32_t slow_every; // Every slow_every job is a slow job with a timeout, 0 for none
+	uint32_t start;
+	bool submitting; // Set from the first native call of a job until the Java code gets its result
+	bool slow;
+	uint32_t errors;
+	uint32_t timeouts;
+	uint32_t late_timeouts; // Slow jobs that did not time out in time
+} microej_async_worker_bench_thread_t;
+
+MICROEJ_ASYNC_WORKER_worker_declare_threads(microej_async_worker_bench_worker, MICROEJ_ASYNC_WORKER_BENCH_JOB_COUNT, microej_async_worker_bench_params_t, MICROEJ_ASYNC_WORKER_BENCH_WAITING_LIST_SIZE, MICROEJ_ASYNC_WORKER_BENCH_TASKS);
+OSAL_task_stack_declare(microej_async_worker_bench_worker_stack, MICROEJ_ASYNC_WORKER_BENCH_STACK_SIZE);
+OSAL_task_stack_declare(microej_async_worker_bench_stack, MICROEJ_ASYNC_WORKER_BENCH_STACK_SIZE);
+
+static microej_async_worker_bench_thread_t microej_async_worker_bench_threads[MICROEJ_ASYNC_WORKER_BENCH_MAX_THREADS];
+static uint32_t microej_async_worker_bench_samples[MICROEJ_ASYNC_WORKER_BENCH_JOBS];
+static uint32_t microej_async_worker_bench_samples_count;
+static uint32_t microej_async_worker_bench_max_overshoot;
+
+static uint32_t microej_async_worker_bench_expected(uint32_t value)
+{
+	return (value * 2) + 1;
+}
+
+static void microej_async_worker_bench_action(MICROEJ_ASYNC_WORKER_job_t *job)
+{
+	microej_async_worker_bench_params_t *params = (microej_async_worker_bench_params_t *)job->params;
+	if (params->sleep_ms != 0)
+	{
+		OSAL_sleep(params->sleep_ms);
+	}
+	if (params->work_us != 0)
+	{
+		uint32_t start = osal_bench_time_us();
+		while ((osal_bench_time_us() - start) < params->work_us)
+		{
+			// Busy loop: the action uses the CPU
+		}
+	}
+	params->result = microej_async_worker_bench_expected(params->value);
+}
+
+static int32_t microej_async_worker_bench_compute_done(void);
+
+// Native function: executes the next job of the calling thread on the worker. Also the retry callback when no job
+// is free.
+static int32_t microej_async_worker_bench_compute(void)
+{
+	microej_async_worker_bench_thread_t *thread = &microej_async_worker_bench_threads[SNI_getCurrentJavaThreadID()];
+	if (!thread->submitting)
+	{
+		thread->submitting = true;
+		thread->start = osal_bench_time_us();
+	}
+
+	MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_allocate_job(&microej_async_worker_bench_worker, (SNI_callback)microej_async_worker_bench_compute);
+	if (job == NULL)
+	{
+		// Waiting for a free job, or an exception is pending
+		return 0;
+	}
+	microej_async_worker_bench_params_t *params = (microej_async_worker_bench_params_t *)job->params;
+	params->value = thread->sequence;
+	params->result = 0;
+	params->work_us = thread->work_us;
+	params->sleep_ms = 0;
+	thread->slow = (thread->slow_every != 0) && ((thread->sequence % thread->slow_every) == 0);
+	if (thread->slow)
+	{
+		params->sleep_ms = MICROEJ_ASYNC_WORKER_BENCH_SLOW_JOB_MS;
+		MICROEJ_ASYNC_WORKER_set_job_timeout(job, MICROEJ_ASYNC_WORKER_BENCH_TIMEOUT_MS);
+	}
+	MICROEJ_ASYNC_WORKER_async_exec(&microej_async_worker_bench_worker, job, microej_async_worker_bench_action, (SNI_callback)microej_async_worker_bench_compute_done);
+	// The thread is suspended, or async_exec() has thrown an exception
+	return 0;
+}
+
+static int32_t microej_async_worker_bench_compute_done(void)
+{
+	MICROEJ_ASYNC_WORKER_job_t *job = MICROEJ_ASYNC_WORKER_get_job_done();
+	if (job == NULL)
+	{
+		// Timed out (an exception is pending) or waiting again
+		return 0;
+	}
+	microej_async_worker_bench_params_t *params = (microej_async_worker_bench_params_t *)job->params;
+	int32_t result = (int32_t)params->result;
+	MICROEJ_ASYNC_WORKER_free_job(&microej_async_worker_bench_worker, job);
+	return result;
+}
+
+// Java code: checks the result of the job and executes the next one.
+static SNI_STUB_native_t microej_async_worker_bench_java_code(void *context, int32_t result, const int32_t *exception)
+{
+	microej_async_worker_bench_thread_t *thread = (microej_async_worker_bench_thread_t *)context;
+	uint32_t latency = osal_bench_time_us() - thread->start;
+	if (thread->slow)
+	{
+		if (exception == NULL || *exception != ETIMEDOUT)
+		{
+			thread->errors++;
+		}
+		else
+		{
+			thread->timeouts++;
+			uint32_t overshoot = latency - (MICROEJ_ASYNC_WORKER_BENCH_TIMEOUT_MS * 1000);
+			if (latency < (MICROEJ_ASYNC_WORKER_BENCH_TIMEOUT_MS * 1000) || overshoot > MICROEJ_ASYNC_WORKER_BENCH_MAX_OVERSHOOT_US)
+			{
+				thread->late_timeouts++;
+			}
+			if (latency >= (MICROEJ_ASYNC_WORKER_BENCH_TIMEOUT_MS * 1000) && overshoot > microej_async_worker_bench_max_overshoot)
+			{
+				microej_async_worker_bench_max_overshoot = overshoot;
+			}
+		}
+	}
+	else
+	{
+		if (exception != NULL || (uint32_t)result != microej_async_worker_bench_expected(thread->sequence))
+		{
+			thread->errors++;
+		}
+		if (microej_async_worker_bench_samples_count < MICROEJ_ASYNC_WORKER_BENCH_JOBS)
+		{
+			microej_async_worker_bench_samples[microej_async_worker_bench_samples_count++] = latency;
+		}
+	}
+
+	thread->submitting = false;
+	thread->sequence++;
+	thread->remaining--;
+	return thread->remaining == 0 ? NULL : microej_async_worker_bench_compute;
+}
+
+// Runs the given number of Java threads until each one has executed its jobs. Returns the elapsed time in
+// microseconds and adds the errors of the threads to the given counters.
+static uint32_t microej_async_worker_bench_run(uint32_t threads, uint32_t jobs_per_thread, uint32_t work_us, uint32_t slow_every, uint32_t *errors, uint32_t *timeouts, uint32_t *late_timeouts)
+{
+	microej_async_worker_bench_samples_count = 0;
+	microej_async_worker_bench_max_overshoot = 0;
+	for (uint32_t t = 0; t < threads; t++)
+	{
+		microej_async_worker_bench_thread_t *thread = &microej_async_worker_bench_threads[t];
+		memset(thread, 0, sizeof(microej_async_worker_bench_thread_t));
+		thread->remaining = jobs_per_thread;
+		thread->work_us = work_us;
+		thread->slow_every = slow_every;
+		if (SNI_STUB_create_thread(microej_async_worker_bench_compute, microej_async_worker_bench_java_code, thread) != (int32_t)t)
+		{
+			printf("  cannot create Java thread %lu\n", (unsigned long)t);
+			exit(2);
+		}
+	}
+	uint32_t start = osal_bench_time_us();
+	SNI_STUB_run();
+	uint32_t elapsed = osal_bench_time_us() - start;
+	for (uint32_t t = 0; t < threads; t++)
+	{
+		*errors += microej_async_worker_bench_threads[t].errors;
+		*timeouts += microej_async_worker_bench_threads[t].timeouts;
+		*late_timeouts += microej_async_worker_bench_threads[t].late_timeouts;
+	}
+	return elapsed == 0 ? 1 : elapsed;
+}
+
+/*
+ * Port functions of the fake virtual machine, as in LLMJVM_nuttx.c. They do nothing without the completion ring.
+ */
+
+static void microej_async_worker_bench_idle_vm(bool idle)
+{
+	MICROEJ_ASYNC_WORKER_set_vm_idle(idle);
+	if (idle)
+	{
+		MICROEJ_ASYNC_WORKER_drain_completions();
+	}
+}
+
+static void microej_async_worker_bench_ack_wakeup(void)
+{
+	MICROEJ_ASYNC_WORKER_drain_completions();
+}
+
+static void microej_async_worker_bench_tick(void *arg)
+{
+	if (MICROEJ_ASYNC_WORKER_completions_due())
+	{
+		SNI_STUB_wakeup();
+	}
+}
+
+/*
+ * Round trip: one Java thread executing empty jobs, from the native call to the return to Java.
+ */
+
+static bool microej_async_worker_bench_round_trip(bool gate)
+{
+	uint32_t errors = 0;
+	uint32_t timeouts = 0;
+	uint32_t late_timeouts = 0;
+	uint32_t elapsed = microej_async_worker_bench_run(1, MICROEJ_ASYNC_WORKER_BENCH_JOBS, 0, 0, &errors, &timeouts, &late_timeouts);
+	uint32_t p99 = osal_bench_report_latency("round trip", microej_async_worker_bench_samples, microej_async_worker_bench_samples_count);
+	uint32_t throughput = (uint32_t)(((uint64_t)MICROEJ_ASYNC_WORKER_BENCH_JOBS * 1000000) / elapsed);
+	printf("  %-28s %8lu jobs/s  VM wakeups %lu\n", "1 thread", (unsigned long)throughput, (unsigned long)SNI_STUB_get_wakeups());
+	bool ok = osal_bench_check(gate, errors == 0, "wrong job results");
+	ok = osal_bench_check(gate, throughput >= MICROEJ_ASYNC_WORKER_BENCH_MIN_THROUGHPUT, "throughput below MICROEJ_ASYNC_WORKER_BENCH_MIN_THROUGHPUT") && ok;
+	return osal_bench_check(gate, p99 <= MICROEJ_ASYNC_WORKER_BENCH_MAX_P99_LATENCY_US, "round trip p99 above MICROEJ_ASYNC_WORKER_BENCH_MAX_P99_LATENCY_US") && ok;
+}
+
+/*
+ * Threads: 1 to 16 Java threads sharing the worker, with empty jobs.
+ */
+
+static bool microej_async_worker_bench_threads_scaling(bool gate)
+{
+	bool ok = true;
+	for (uint32_t threads = 1; threads <= MICROEJ_ASYNC_WORKER_BENCH_JOB_COUNT; threads *= 2)
+	{
+		uint32_t errors = 0;
+		uint32_t timeouts = 0;
+		uint32_t late_timeouts = 0;
+		uint32_t jobs = MICROEJ_ASYNC_WORKER_BENCH_JOBS / threads;
+		uint32_t elapsed = microej_async_worker_bench_run(threads, jobs, 0, 0, &errors, &timeouts, &late_timeouts);
+		uint32_t throughput = (uint32_t)(((uint64_t)jobs * threads * 1000000) / elapsed);
+		char name[32];
+		snprintf(name, sizeof(name), "%lu thread(s)", (unsigned long)threads);
+		printf("  %-28s %8lu jobs/s  VM wakeups %lu\n", name, (unsigned long)throughput, (unsigned long)SNI_STUB_get_wakeups());
+		uint32_t p99 = osal_bench_report_latency("round trip", microej_async_worker_bench_samples, microej_async_worker_bench_samples_count);
+		ok = osal_bench_check(gate, errors == 0, "wrong job results") && ok;
+		ok = osal_bench_check(gate, throughput >= MICROEJ_ASYNC_WORKER_BENCH_MIN_THROUGHPUT, "throughput below MICROEJ_ASYNC_WORKER_BENCH_MIN_THROUGHPUT") && ok;
+		// The jobs of the other threads are executed before: the latency grows with the number of threads
+		ok = osal_bench_check(gate, p99 <= threads * MICROEJ_ASYNC_WORKER_BENCH_MAX_P99_LATENCY_US, "round trip p99 above threads * MICROEJ_ASYNC_WORKER_BENCH_MAX_P99_LATENCY_US") && ok;
+	}
+	return ok;
+}
+
+/*
+ * Pool exhaustion: twice as many Java threads as jobs. The threads without job wait in the waiting list and are
+ * resumed when a job is freed: a lost resume blocks the benchmark.
+ */
+
+static bool microej_async_worker_bench_pool_exhaustion(bool gate)
+{
+	uint32_t errors = 0;
+	uint32_t timeouts = 0;
+	uint32_t late_timeouts = 0;
+	uint32_t threads = MICROEJ_ASYNC_WORKER_BENCH_MAX_THREADS;
+	uint32_t elapsed = microej_async_worker_bench_run(threads, MICROEJ_ASYNC_WORKER_BENCH_EXHAUSTION_JOBS, MICROEJ_ASYNC_WORKER_BENCH_EXHAUSTION_WORK_US, 0, &errors, &timeouts, &late_timeouts);
+	uint32_t throughput = (uint32_t)(((uint64_t)MICROEJ_ASYNC_WORKER_BENCH_EXHAUSTION_JOBS * threads * 1000000) / elapsed);
+	char name[32];
+	snprintf(name, sizeof(name), "%lu threads, %d jobs", (unsigned long)threads, MICROEJ_ASYNC_WORKER_BENCH_JOB_COUNT);
+	printf("  %-28s %8lu jobs/s  VM wakeups %lu\n", name, (unsigned long)throughput, (unsigned long)SNI_STUB_get_wakeups());
+	osal_bench_report_latency("round trip", microej_async_worker_bench_samples, microej_async_worker_bench_samples_count);
+	return osal_bench_check(gate, errors == 0, "wrong job results or waiting list full");
+}
+
+/*
+ * Timeout: every other job sleeps longer than its timeout. It must time out within MAX_OVERSHOOT_US of its
+ * deadline, whether it is queued or running, while the other jobs, without timeout, are all done.
+ */
+
+static bool microej_async_worker_bench_timeout(bool gate)
+{
+	uint32_t errors = 0;
+	uint32_t timeouts = 0;
+	uint32_t late_timeouts = 0;
+	uint32_t threads = MICROEJ_ASYNC_WORKER_BENCH_TIMEOUT_THREADS;
+	microej_async_worker_bench_run(threads, MICROEJ_ASYNC_WORKER_BENCH_TIMEOUT_JOBS, 0, 2, &errors, &timeouts, &late_timeouts);
+	printf("  %-28s %8lu timed out  max overshoot %lu us  late %lu  errors %lu\n", "slow jobs",
+	       (unsigned long)timeouts, (unsigned long)microej_async_worker_bench_max_overshoot, (unsigned long)late_timeouts, (unsigned long)errors);
+	// The slow jobs still running are done meanwhile: wait for them before the next benchmark
+	OSAL_sleep(MICROEJ_ASYNC_WORKER_BENCH_SLOW_JOB_MS * 2);
+	bool ok = osal_bench_check(gate, errors == 0, "slow job not timed out or wrong job result");
+	return osal_bench_check(gate, late_timeouts == 0, "timeout early or above MICROEJ_ASYNC_WORKER_BENCH_MAX_OVERSHOOT_US") && ok;
+}
+
+/*
+ * Wakeups: 8 Java threads executing short jobs. Counts the wakeups of the virtual machine task per job done, for
+ * several coalescing windows of the completion ring. A job done while the virtual machine task is running must not
+ * wake it up: with the window 0, there is at most one wakeup per job, as with the direct resumes.
+ */
+
+static bool microej_async_worker_bench_wakeups(bool gate)
+{
+#ifdef MICROEJ_ASYNC_WORKER_COMPLETION_RING_SIZE
+	static const uint32_t windows[] = {0, 1, 2, 5};
+#else
+	static const uint32_t windows[] = {0};
+#endif
+	bool ok = true;
+	for (uint32_t w = 0; w < sizeof(windows) / sizeof(windows[0]); w++)
+	{
+		uint32_t errors = 0;
+		uint32_t timeouts = 0;
+		uint32_t late_timeouts = 0;
+		uint32_t threads = MICROEJ_ASYNC_WORKER_BENCH_WAKEUP_THREADS;
+		uint32_t jobs = MICROEJ_ASYNC_WORKER_BENCH_JOBS / threads;
+		MICROEJ_ASYNC_WORKER_set_completion_window(windows[w]);
+		uint32_t elapsed = microej_async_worker_bench_run(threads, jobs, MICROEJ_ASYNC_WORKER_BENCH_WAKEUP_WORK_US, 0, &errors, &timeouts, &late_timeouts);
+		uint32_t wakeups = SNI_STUB_get_wakeups();
+		char name[32];
+#ifdef MICROEJ_ASYNC_WORKER_COMPLETION_RING_SIZE
+		snprintf(name, sizeof(name), "ring, window %lu ms", (unsigned long)windows[w]);
+#else
+		snprintf(name, sizeof(name), "direct resumes");
+#endif
+		printf("  %-28s %8lu jobs/s  %6lu wakeups/s  %5.2f jobs per wakeup\n", name,
+		       (unsigned long)(((uint64_t)jobs * threads * 1000000) / elapsed), (unsigned long)(((uint64_t)wakeups * 1000000) / elapsed),
+		       (double)(jobs * threads) / (wakeups == 0 ? 1 : wakeups));
+		osal_bench_report_latency("round trip", microej_async_worker_bench_samples, microej_async_worker_bench_samples_count);
+		ok = osal_bench_check(gate, errors == 0, "wrong job results") && ok;
+		if (windows[w] == 0)
+		{
+			ok = osal_bench_check(gate, wakeups <= jobs * threads, "more wakeups than jobs") && ok;
+		}
+	}
+	return ok;
+}
+
+static const osal_bench_t microej_async_worker_benchmarks[] = {
+	{"round_trip", microej_async_worker_bench_round_trip},
+	{"threads", microej_async_worker_bench_threads_scaling},
+	{"pool_exhaustion", microej_async_worker_bench_pool_exhaustion},
+	{"timeout", microej_async_worker_bench_timeout},
+	{"wakeups", microej_async_worker_bench_wakeups},
+};
+
+int main(int argc, char **argv)
+{
+	if (MICROEJ_ASYNC_WORKER_initialize(&microej_async_worker_bench_worker, (uint8_t *)"bench worker", microej_async_worker_bench_worker_stack, MICROEJ_ASYNC_WORKER_BENCH_PRIORITY) != MICROEJ_ASYNC_WORKER_OK)
+	{
+		printf("cannot initialize the worker\n");
+		return 2;
+	}
+	SNI_STUB_set_hooks(microej_async_worker_bench_idle_vm, microej_async_worker_bench_ack_wakeup);
+	OSAL_timer_handle_t tick = NULL;
+	if (OSAL_timer_create((uint8_t *)"tick", microej_async_worker_bench_tick, NULL, &tick) != OSAL_OK || OSAL_timer_start(&tick, MICROEJ_ASYNC_WORKER_BENCH_TICK_MS, MICROEJ_ASYNC_WORKER_BENCH_TICK_MS) != OSAL_OK)
+	{
+		printf("cannot start the tick timer\n");
+		return 2;
+	}
+	// The fake virtual machine runs on the benchmark task, with the priority of the worker tasks
+	return osal_bench_main(argc, argv, microej_async_worker_benchmarks, sizeof(microej_async_worker_benchmarks) / sizeof(microej_async_worker_benchmarks[0]), microej_async_worker_bench_stack, MICROEJ_ASYNC_WORKER_BENCH_PRIORITY);
+}
@@ -0,0 +1,115 @@
+/*
+ * C
+ *
+ * Copyright 2019 MicroEJ Corp. All rights reserved.
+ * This library is provided in source code for use, modification and test, subject to license terms.
+ * Any modification of the source code will break MicroEJ Corp. warranties on the whole library.
+ */
+
+/**
+ * @file
+ * @brief Host stand-in for the SNI layer of the virtual machine
+ * @author MicroEJ Developer Team
+ * @version 0.1.0
+ * @date 17 October 2026
+ *
+ * Declares the SNI functions called by the async worker and the control functions of the fake virtual machine
+ * implemented in sni_stub.c. Like the real virtual machine, the fake one runs all the Java threads on a single task:
+ * a Java thread is a sequence of native calls, and the Java code between two calls is a C function of the benchmark.
+ */
+
+#ifndef SNI_H
+#define SNI_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define SNI_OK (0)
+#define SNI_ERROR (-1)
+
+	/**
+	 * @brief Function called when a suspended Java thread is resumed. It is called with the arguments of the native
+	 * function that suspended the thread: the natives of the fake virtual machine have no argument.
+	 */
+	typedef void (*SNI_callback)(void);
+
+	/**
+	 * @brief Native function called by a Java thread of the fake virtual machine. Its result is given to the Java code
+	 * of the thread, unless the native function suspended the thread.
+	 */
+	typedef int32_t (*SNI_STUB_native_t)(void);
+
+	/**
+	 * @brief Java code of a thread of the fake virtual machine, called after each native call that returns to Java.
+	 *
+	 * @param[in] context the context given to <code>SNI_STUB_create_thread()</code>.
+	 * @param[in] result the value returned by the native function, meaningless when an exception is pending.
+	 * @param[in] exception the error code of the exception thrown by the native function, NULL if there is none.
+	 *
+	 * @return the next native function to call, NULL to terminate the thread.
+	 */
+	typedef SNI_STUB_native_t (*SNI_STUB_java_code_t)(void *context, int32_t result, const int32_t *exception);
+
+	/**
+	 * @brief Port function called by the fake virtual machine task with true before it waits for a wakeup, like
+	 * <code>LLMJVM_IMPL_idleVM()</code>, and with false once woken up.
+	 */
+	typedef void (*SNI_STUB_idle_hook_t)(bool idle);
+
+	/**
+	 * @brief Port function called by the fake virtual machine task when it handles a wakeup, like
+	 * <code>LLMJVM_IMPL_ackWakeup()</code>.
+	 */
+	typedef void (*SNI_STUB_ack_wakeup_hook_t)(void);
+
+	int32_t SNI_getCurrentJavaThreadID(void);
+	int32_t SNI_suspendCurrentJavaThreadWithCallback(int64_t timeout, SNI_callback callback, void *callback_args);
+	int32_t SNI_resumeJavaThread(int32_t java_thread_id);
+	int32_t SNI_getCallbackArgs(void **callback_args, void **unused);
+	int32_t SNI_throwNativeIOException(int32_t error_code, const char *message);
+
+	/**
+	 * @brief Creates a Java thread of the fake virtual machine. Must be called before <code>SNI_STUB_run()</code>.
+	 *
+	 * @param[in] native the first native function called by the thread.
+	 * @param[in] java_code the Java code called after each native call.
+	 * @param[in] context the context given to <code>java_code</code>.
+	 *
+	 * @return the Java thread id, <code>SNI_ERROR</code> if there are too many threads.
+	 */
+	int32_t SNI_STUB_create_thread(SNI_STUB_native_t native, SNI_STUB_java_code_t java_code, void *context);
+
+	/**
+	 * @brief Runs the fake virtual machine on the calling task until all its Java threads are terminated. The threads
+	 * are then deleted.
+	 */
+	void SNI_STUB_run(void);
+
+	/**
+	 * @brief Sets the port functions of the fake virtual machine, NULL for none. Must be called before
+	 * <code>SNI_STUB_run()</code>.
+	 */
+	void SNI_STUB_set_hooks(SNI_STUB_idle_hook_t idle_hook, SNI_STUB_ack_wakeup_hook_t ack_wakeup_hook);
+
+	/**
+	 * @brief Wakes the fake virtual machine up, like <code>LLMJVM_schedule()</code>. May be called from any task. When
+	 * the virtual machine is running, it handles the wakeup before going on and the next wait ends immediately.
+	 */
+	void SNI_STUB_wakeup(void);
+
+	/**
+	 * @brief Returns the number of times the fake virtual machine was woken up since the last call to
+	 * <code>SNI_STUB_run()</code>.
+	 */
+	uint32_t SNI_STUB_get_wakeups(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SNI_H
@@ -0,0 +1,276 @@
+/*
+ * C
+ *
+ * Copyright 2019 MicroEJ Corp. All rights reserved.
+ * This library is provided in source code for use, modification and test, subject to license terms.
+ * Any modification of the source code will break MicroEJ Corp. warranties on the whole library.
+ */
+
+/**
+ * @file
+ * @brief Host stand-in for the SNI layer of the virtual machine
+ * @author MicroEJ Developer Team
+ * @version 0.1.0
+ * @date 17 October 2026
+ *
+ * The fake virtual machine runs the Java threads one at a time on the task that calls SNI_STUB_run(). A native
+ * function that suspends its thread only records the suspension: the thread is suspended when the native function
+ * returns. A resumed thread calls its callback, which may suspend it again. When no thread can run, the virtual machine
+ * waits until a resume wakes it up or until the first suspension timeout elapses. Like the NuttX port, a wakeup
+ * requested while the virtual machine is running ends its next wait immediately.
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include "sni.h"
+#include "osal.h"
+
+#ifndef SNI_STUB_MAX_THREADS
+#define SNI_STUB_MAX_THREADS (64)
+#endif
+
+typedef struct
+{
+	SNI_STUB_native_t native; // Next native function or callback to call
+	SNI_STUB_java_code_t java_code;
+	void *context;
+	void *callback_args;
+	SNI_callback callback;
+	uint32_t deadline; // Suspension timeout in OSAL milliseconds, only when has_deadline is set
+	uint8_t resume_pending; // Set by SNI_resumeJavaThread() from any task, cleared by the suspension it ends
+	bool has_deadline;
+	bool suspended;
+	bool suspend_requested; // Set by the running native function
+	bool exception_pending;
+	int32_t exception;
+} SNI_STUB_thread_t;
+
+static SNI_STUB_thread_t SNI_STUB_threads[SNI_STUB_MAX_THREADS];
+static int32_t SNI_STUB_threads_count;
+// Thread executing a native function on the virtual machine task, NULL otherwise
+static SNI_STUB_thread_t *SNI_STUB_current;
+// Set on the virtual machine task: its resumes do not wake it up
+static __thread bool SNI_STUB_vm_task;
+static OSAL_binary_semaphore_handle_t SNI_STUB_wakeup_semaphore;
+static bool SNI_STUB_initialized;
+static uint32_t SNI_STUB_wakeups;
+// Set by SNI_STUB_wakeup(), cleared when the virtual machine task handles the wakeup
+static uint8_t SNI_STUB_wakeup_requested;
+static SNI_STUB_idle_hook_t SNI_STUB_idle_hook;
+static SNI_STUB_ack_wakeup_hook_t SNI_STUB_ack_wakeup_hook;
+
+static void SNI_STUB_initialize(void)
+{
+	if (!SNI_STUB_initialized)
+	{
+		if (OSAL_binary_semaphore_create((uint8_t *)"SNI stub", 0, &SNI_STUB_wakeup_semaphore) != OSAL_OK)
+		{
+			printf("SNI stub: cannot create the wakeup semaphore\n");
+		}
+		SNI_STUB_initialized = true;
+	}
+}
+
+int32_t SNI_getCurrentJavaThreadID(void)
+{
+	return SNI_STUB_current == NULL ? SNI_ERROR : (int32_t)(SNI_STUB_current - SNI_STUB_threads);
+}
+
+int32_t SNI_suspendCurrentJavaThreadWithCallback(int64_t timeout, SNI_callback callback, void *callback_args)
+{
+	SNI_STUB_thread_t *thread = SNI_STUB_current;
+	if (thread == NULL)
+	{
+		return SNI_ERROR;
+	}
+	thread->suspend_requested = true;
+	thread->callback = callback;
+	thread->callback_args = callback_args;
+	thread->has_deadline = (timeout > 0);
+	if (thread->has_deadline)
+	{
+		uint32_t now = 0;
+		OSAL_get_time_ms(&now);
+		thread->deadline = now + (uint32_t)timeout;
+	}
+	return SNI_OK;
+}
+
+int32_t SNI_resumeJavaThread(int32_t java_thread_id)
+{
+	if (java_thread_id < 0 || java_thread_id >= SNI_STUB_threads_count)
+	{
+		return SNI_ERROR;
+	}
+	__atomic_store_n(&SNI_STUB_threads[java_thread_id].resume_pending, 1, __ATOMIC_RELEASE);
+	if (!SNI_STUB_vm_task)
+	{
+		// Resumed by another task: the virtual machine task may be waiting
+		SNI_STUB_wakeup();
+	}
+	// else the virtual machine task checks the threads again before waiting
+	return SNI_OK;
+}
+
+int32_t SNI_getCallbackArgs(void **callback_args, void **unused)
+{
+	if (SNI_STUB_current == NULL)
+	{
+		return SNI_ERROR;
+	}
+	*callback_args = SNI_STUB_current->callback_args;
+	return SNI_OK;
+}
+
+int32_t SNI_throwNativeIOException(int32_t error_code, const char *message)
+{
+	if (SNI_STUB_current == NULL)
+	{
+		return SNI_ERROR;
+	}
+	SNI_STUB_current->exception_pending = true;
+	SNI_STUB_current->exception = error_code;
+	return SNI_OK;
+}
+
+int32_t SNI_STUB_create_thread(SNI_STUB_native_t native, SNI_STUB_java_code_t java_code, void *context)
+{
+	if (SNI_STUB_threads_count == SNI_STUB_MAX_THREADS)
+	{
+		return SNI_ERROR;
+	}
+	int32_t id = SNI_STUB_threads_count++;
+	SNI_STUB_thread_t *thread = &SNI_STUB_threads[id];
+	memset(thread, 0, sizeof(SNI_STUB_thread_t));
+	thread->native = native;
+	thread->java_code = java_code;
+	thread->context = context;
+	return id;
+}
+
+void SNI_STUB_set_hooks(SNI_STUB_idle_hook_t idle_hook, SNI_STUB_ack_wakeup_hook_t ack_wakeup_hook)
+{
+	SNI_STUB_idle_hook = idle_hook;
+	SNI_STUB_ack_wakeup_hook = ack_wakeup_hook;
+}
+
+void SNI_STUB_wakeup(void)
+{
+	__atomic_store_n(&SNI_STUB_wakeup_requested, 1, __ATOMIC_SEQ_CST);
+	OSAL_binary_semaphore_give(&SNI_STUB_wakeup_semaphore);
+}
+
+// Returns true if a suspended thread has been resumed since the last scan of the threads.
+static bool SNI_STUB_resume_pending(void)
+{
+	for (int32_t i = 0; i < SNI_STUB_threads_count; i++)
+	{
+		SNI_STUB_thread_t *thread = &SNI_STUB_threads[i];
+		if (thread->native != NULL && thread->suspended && __atomic_load_n(&thread->resume_pending, __ATOMIC_ACQUIRE) != 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+uint32_t SNI_STUB_get_wakeups(void)
+{
+	return SNI_STUB_wakeups;
+}
+
+// Calls the next native function of the given runnable thread and gives its result to the Java code.
+// Returns false when the thread is terminated.
+static bool SNI_STUB_step(SNI_STUB_thread_t *thread)
+{
+	thread->suspend_requested = false;
+	thread->exception_pending = false;
+	SNI_STUB_current = thread;
+	int32_t result = thread->native();
+	SNI_STUB_current = NULL;
+	if (thread->suspend_requested)
+	{
+		// The callback is called with the arguments of the native function, none here
+		thread->suspended = true;
+		thread->native = (SNI_STUB_native_t)thread->callback;
+		return true;
+	}
+	thread->native = thread->java_code(thread->context, result, thread->exception_pending ? &thread->exception : NULL);
+	return thread->native != NULL;
+}
+
+void SNI_STUB_run(void)
+{
+	SNI_STUB_initialize();
+	SNI_STUB_vm_task = true;
+	SNI_STUB_wakeups = 0;
+	int32_t alive = SNI_STUB_threads_count;
+	while (alive > 0)
+	{
+		if (__atomic_exchange_n(&SNI_STUB_wakeup_requested, 0, __ATOMIC_SEQ_CST) != 0 && SNI_STUB_ack_wakeup_hook != NULL)
+		{
+			SNI_STUB_ack_wakeup_hook();
+		}
+
+		bool ran = false;
+		bool has_deadline = false;
+		uint32_t deadline = 0;
+		uint32_t now = 0;
+		OSAL_get_time_ms(&now);
+		for (int32_t i = 0; i < SNI_STUB_threads_count; i++)
+		{
+			SNI_STUB_thread_t *thread = &SNI_STUB_threads[i];
+			if (thread->native == NULL)
+			{
+				continue; // Terminated
+			}
+			if (thread->suspended)
+			{
+				if (__atomic_exchange_n(&thread->resume_pending, 0, __ATOMIC_ACQUIRE) == 0)
+				{
+					if (!thread->has_deadline || (int32_t)(thread->deadline - now) > 0)
+					{
+						if (thread->has_deadline && (!has_deadline || (int32_t)(thread->deadline - deadline) < 0))
+						{
+							deadline = thread->deadline;
+							has_deadline = true;
+						}
+						continue; // Still suspended
+					}
+					// else the suspension timed out
+				}
+				thread->suspended = false;
+			}
+			ran = true;
+			if (!SNI_STUB_step(thread))
+			{
+				alive--;
+			}
+		}
+
+		if (!ran)
+		{
+			// All the threads are suspended: wait for a resume or for the first timeout
+			if (SNI_STUB_idle_hook != NULL)
+			{
+				SNI_STUB_idle_hook(true);
+			}
+			// The idle hook may have resumed threads
+			if (!SNI_STUB_resume_pending())
+			{
+				uint32_t timeout = has_deadline ? (deadline - now) : OSAL_INFINITE_TIME;
+				if (OSAL_binary_semaphore_take(&SNI_STUB_wakeup_semaphore, timeout) == OSAL_OK)
+				{
+					SNI_STUB_wakeups++;
+				}
+			}
+			if (SNI_STUB_idle_hook != NULL)
+			{
+				SNI_STUB_idle_hook(false);
+			}
+		}
+	}
+	SNI_STUB_vm_task = false;
+	SNI_STUB_threads_count = 0;
+}
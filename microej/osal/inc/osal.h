@@ -22,6 +22,9 @@
 /** @brief define an infinite time */
 #define OSAL_INFINITE_TIME	0xFFFFFFFF
 
+/** @brief maximum number of queues waited by one OSAL_queue_select() call */
+#define OSAL_QUEUE_SELECT_MAX	8
+
 /** @brief return code list */
 typedef enum {
 	OSAL_OK,
@@ -40,6 +43,20 @@ typedef void* OSAL_task_handle_t;
 /** @brief OS queue handle */
 typedef void* OSAL_queue_handle_t;
 
+/** @brief OS priority queue handle */
+typedef void* OSAL_prio_queue_handle_t;
+
+/** @brief maximum number of priority levels of an OS priority queue */
+#define OSAL_PRIO_QUEUE_MAX_LEVELS	8
+
+/**
+ * @brief Link embedded in the messages posted to an OS priority queue, so that posting does not allocate memory.
+ * The fields are internal data and must not be accessed.
+ */
+typedef struct OSAL_prio_queue_node_s {
+	struct OSAL_prio_queue_node_s* next;
+} OSAL_prio_queue_node_t;
+
 /** @brief OS counter semaphore handle */
 typedef void* OSAL_counter_semaphore_handle_t;
 
@@ -49,6 +66,87 @@ typedef void* OSAL_binary_semaphore_handle_t;
 /** @brief OS mutex handle */
 typedef void* OSAL_mutex_handle_t;
 
+/** @brief OS reader-writer lock handle */
+typedef void* OSAL_rwlock_handle_t;
+
+/** @brief OS event group handle */
+typedef void* OSAL_event_group_handle_t;
+
+/** @brief OS event group wait options, may be combined */
+typedef enum {
+	OSAL_EVENT_GROUP_WAIT_ANY = 0x0, // wait until one of the bits is set
+	OSAL_EVENT_GROUP_WAIT_ALL = 0x1, // wait until all the bits are set
+	OSAL_EVENT_GROUP_CLEAR_ON_EXIT = 0x2 // clear the waited bits when the wait condition is met
+} OSAL_event_group_options_t;
+
+/** @brief Lock-free ring queue handle */
+typedef void* OSAL_ringqueue_handle_t;
+
+/** @brief OS timer handle */
+typedef void* OSAL_timer_handle_t;
+
+/**
+ * @brief Spinlock protecting a short critical section shared between tasks that may run on different CPUs.
+ * Must be initialized with OSAL_SPINLOCK_INITIALIZER. The fields are internal data and must not be accessed.
+ */
+typedef struct {
+	uint8_t locked;
+	uint32_t irq_state; // interrupt state of the holder CPU, restored on release
+	uint32_t start; // take time of the holder, used by the OSAL_CRITICAL_SECTION_MAX_US check
+} OSAL_spinlock_t;
+
+/** @brief initial value of an OSAL_spinlock_t */
+#define OSAL_SPINLOCK_INITIALIZER	{ 0, 0, 0 }
+
+/** @brief Fixed-block memory pool handle */
+typedef void* OSAL_pool_handle_t;
+
+/** @brief Usage statistics of a fixed-block memory pool */
+typedef struct {
+	uint32_t block_size; // size of a block in bytes, rounded up to OSAL_POOL_BLOCK_SIZE()
+	uint32_t count; // number of blocks
+	uint32_t used; // number of blocks currently allocated
+	uint32_t high_water; // maximum number of blocks allocated at the same time
+	uint32_t failures; // allocations that failed because the pool was empty
+} OSAL_pool_stats_t;
+
+/** @brief timer function called on the timer service task when a timer expires */
+typedef void ( *OSAL_timer_callback_t)( void *arg);
+
+/** @brief Lock-free ring queue producer/consumer model */
+typedef enum {
+	OSAL_RINGQUEUE_MPSC,	// several producers, one consumer
+	OSAL_RINGQUEUE_SPSC	// one producer, one consumer
+} OSAL_ringqueue_type_t;
+
+/** @brief number of buckets of the instrumentation histograms */
+#define OSAL_STATS_HISTOGRAM_SIZE	16
+
+/** @brief kind of primitive an instrumentation record belongs to */
+typedef enum {
+	OSAL_STATS_QUEUE,
+	OSAL_STATS_SEMAPHORE,
+	OSAL_STATS_MUTEX
+} OSAL_stats_type_t;
+
+/**
+ * @brief Instrumentation record of a named primitive. Filled only when OSAL_INSTRUMENTATION is defined.
+ *
+ * Bucket 0 of a histogram counts the durations under 1 microsecond, bucket i counts the durations
+ * in [2^(i-1), 2^i[ microseconds. The last bucket also counts all the longer durations.
+ */
+typedef struct OSAL_stats_s {
+	struct OSAL_stats_s* next; // internal link of the instrumentation registry
+	uint8_t* name;
+	OSAL_stats_type_t type;
+	uint32_t acquisitions; // successful takes or fetches
+	uint32_t contended; // acquisitions that had to wait
+	uint32_t wait_histogram[OSAL_STATS_HISTOGRAM_SIZE]; // time spent waiting by the contended acquisitions
+	uint32_t hold_histogram[OSAL_STATS_HISTOGRAM_SIZE]; // time between take and give, mutexes only
+	uint32_t hold_start; // internal, time of the last mutex take
+	int32_t high_water; // maximum number of messages stored, queues only
+} OSAL_stats_t;
+
 /*
  * Each OSAL port has a unique osal_portmacro.h header file.
  *
@@ -59,8 +157,28 @@ typedef void* OSAL_mutex_handle_t;
  * 		@param[in] _size size of the stack in bytes. _size must be compile time constant value.
  * 		OSAL_task_stack_declare(_name, _size);
  *
- * This file must declare the following type:
+ * - OSAL_CACHE_LINE_SIZE:
+ * 		@brief Size in bytes of a data cache line, used to pad data shared between cores.
+ *
+ * - OSAL_queue_storage_declare, OSAL_prio_queue_storage_declare, OSAL_counter_semaphore_storage_declare,
+ *   OSAL_binary_semaphore_storage_declare, OSAL_mutex_storage_declare, OSAL_rwlock_storage_declare, OSAL_event_group_storage_declare:
+ * 		@brief Declare the storage given to the matching _static creation function.
+ * 		OSAL_queue_storage_declare(_name, _size);
+ * 		OSAL_prio_queue_storage_declare(_name);
+ * 		OSAL_counter_semaphore_storage_declare(_name);
+ * 		OSAL_binary_semaphore_storage_declare(_name);
+ * 		OSAL_mutex_storage_declare(_name);
+ * 		OSAL_rwlock_storage_declare(_name);
+ * 		OSAL_event_group_storage_declare(_name);
+ *
+ * This file must declare the following types:
  * - OSAL_task_stack_t: OS task stack
+ * - OSAL_queue_storage_t: OS queue storage
+ * - OSAL_prio_queue_storage_t: OS priority queue storage
+ * - OSAL_semaphore_storage_t: OS counter and binary semaphore storage
+ * - OSAL_mutex_storage_t: OS mutex storage
+ * - OSAL_rwlock_storage_t: OS reader-writer lock storage
+ * - OSAL_event_group_storage_t: OS event group storage
  */
 #include "osal_portmacro.h"
 
@@ -68,13 +186,102 @@ typedef void* OSAL_mutex_handle_t;
 	#error "osal_portmacro.h doesn't define OSAL_task_stack_declare() macro."
 #endif
 
+#ifndef  OSAL_CACHE_LINE_SIZE
+	#error "osal_portmacro.h doesn't define OSAL_CACHE_LINE_SIZE macro."
+#endif
+
+#if !defined(OSAL_queue_storage_declare) || !defined(OSAL_prio_queue_storage_declare) || !defined(OSAL_counter_semaphore_storage_declare) || !defined(OSAL_binary_semaphore_storage_declare) || !defined(OSAL_mutex_storage_declare) || !defined(OSAL_rwlock_storage_declare) || !defined(OSAL_event_group_storage_declare)
+	#error "osal_portmacro.h doesn't define the OSAL storage declaration macros."
+#endif
+
+/*
+ * When OSAL_NO_DYNAMIC_ALLOCATION is defined, the creation functions that allocate memory are not available and any
+ * OSAL source reaching the heap fails to compile. Only the _static creation functions can be used.
+ */
+
+/** @brief Lock-free ring queue slot. The fields are internal data and must not be accessed. */
+typedef struct {
+	uint32_t sequence;
+	void* msg;
+} OSAL_ringqueue_slot_t;
+
+/** @brief Lock-free ring queue storage. The fields are internal data and must not be accessed. */
+typedef struct {
+	uint32_t tail; // next slot to write, updated by the producers
+	uint8_t tail_padding[OSAL_CACHE_LINE_SIZE - sizeof(uint32_t)];
+	uint32_t head; // next slot to read, updated by the consumer
+	uint8_t head_padding[OSAL_CACHE_LINE_SIZE - sizeof(uint32_t)];
+	uint32_t mask; // number of slots - 1
+	OSAL_ringqueue_type_t type;
+	uint8_t* name;
+	OSAL_ringqueue_slot_t* slots; // stored right after this structure
+	uint8_t is_static; // storage provided by the caller, not freed on deletion
+} OSAL_ringqueue_storage_t;
+
+/**
+ * @brief Declare the storage of a lock-free ring queue and of its message slots.
+ * The ring queue storage given to OSAL_ringqueue_create_static() is <code>&_name.ringqueue</code>.
+ *
+ * @param[in] _name name of the variable that defines the storage.
+ * @param[in] _size number of message slots. _size must be compile time constant value.
+ */
+#define OSAL_ringqueue_storage_declare(_name, _size) struct { OSAL_ringqueue_storage_t ringqueue; OSAL_ringqueue_slot_t slots[_size]; } _name
+
+/** @brief OS timer storage. The fields are internal data and must not be accessed. */
+typedef struct OSAL_timer_storage_s {
+	struct OSAL_timer_storage_s* next;
+	struct OSAL_timer_storage_s** pprev; // link pointing to this timer, NULL when the timer is not armed
+	uint32_t expiry; // absolute expiration tick
+	uint32_t period; // period in ticks, 0 for a one-shot timer
+	OSAL_timer_callback_t callback;
+	void* arg;
+	uint8_t* name;
+	uint8_t delete_pending; // deleted by its own callback, released by the timer task
+	uint8_t is_static; // storage provided by the caller, not freed on deletion
+} OSAL_timer_storage_t;
+
+/**
+ * @brief Declare the storage of an OS timer.
+ *
+ * @param[in] _name name of the variable that defines the storage.
+ */
+#define OSAL_timer_storage_declare(_name) OSAL_timer_storage_t _name
+
+/** @brief Fixed-block memory pool storage. The fields are internal data and must not be accessed. */
+typedef struct {
+	uint32_t head; // free list head: modification tag in the 16 high bits, first free block index in the 16 low bits
+	uint32_t block_size;
+	uint32_t count;
+	uint8_t* name;
+	uint8_t* blocks; // stored right after this structure
+	uint32_t used;
+	uint32_t high_water;
+	uint32_t failures;
+} OSAL_pool_storage_t;
+
+/** @brief Maximum number of blocks of a fixed-block memory pool */
+#define OSAL_POOL_MAX_COUNT	0xFFFF
+
+/** @brief Size of a fixed-block memory pool block: the requested size rounded up to a multiple of 8 bytes */
+#define OSAL_POOL_BLOCK_SIZE(_block_size) ((((_block_size) + sizeof(uint64_t) - 1) / sizeof(uint64_t)) * sizeof(uint64_t))
+
+/**
+ * @brief Declare the storage of a fixed-block memory pool and of its blocks.
+ * The pool storage given to OSAL_pool_create() is <code>&_name.pool</code>.
+ *
+ * @param[in] _name name of the variable that defines the storage.
+ * @param[in] _block_size size of a block in bytes. _block_size must be compile time constant value.
+ * @param[in] _count number of blocks. _count must be compile time constant value.
+ */
+#define OSAL_pool_storage_declare(_name, _block_size, _count) struct { OSAL_pool_storage_t pool; uint64_t blocks[(OSAL_POOL_BLOCK_SIZE(_block_size) / sizeof(uint64_t)) * (_count)]; } _name
+
 /**
  * @brief Create an OS task and start it.
  *
  * @param[in] entry_point function called at task startup
  * @param[in] name the task name
  * @param[in] stack task stack declared using OSAL_task_stack_declare() macro
- * @param[in] priority task priority
+ * @param[in] priority task priority. The POSIX port clamps it to the priority range of its real-time scheduling policy.
  * @param[in] parameters task entry parameters. NULL if no entry parameters
  * @param[in,out] handle pointer on a task handle
  *
@@ -91,14 +298,42 @@ OSAL_status_t OSAL_task_create(OSAL_task_entry_point_t entry_point, uint8_t* nam
  */
 OSAL_status_t OSAL_task_delete(OSAL_task_handle_t* handle);
 
+/**
+ * @brief Restrict the CPUs an OS task may run on.
+ *
+ * @param[in] handle pointer on the task handle
+ * @param[in] cpu_mask bit i set allows the task to run on CPU i. Must not be 0.
+ *
+ * @return operation status (@see OSAL_status_t), OSAL_NOT_IMPLEMENTED if the OS does not support CPU affinity
+ */
+OSAL_status_t OSAL_task_set_affinity(OSAL_task_handle_t* handle, uint32_t cpu_mask);
+
+#ifndef OSAL_NO_DYNAMIC_ALLOCATION
 /**
  * @brief Create an OS queue with a predefined queue size.
  *
+ * All the message slots are allocated at creation time: posting and fetching messages never allocate memory.
+ *
+ * @param[in] name queue name
+ * @param[in] size maximum number of messages that the queue can hold. Must be greater than 0.
  * @param[in,out] handle pointer on a queue handle
  *
  * @return operation status (@see OSAL_status_t)
  */
 OSAL_status_t OSAL_queue_create(uint8_t* name, uint32_t size, OSAL_queue_handle_t* handle);
+#endif
+
+/**
+ * @brief Create an OS queue in a storage declared with OSAL_queue_storage_declare(). Does not allocate memory.
+ *
+ * @param[in] name queue name. Not copied: must remain valid until the queue is deleted.
+ * @param[in] size maximum number of messages that the queue can hold. Must be the size given to OSAL_queue_storage_declare().
+ * @param[in] storage queue storage, <code>&_name.queue</code> where <code>_name</code> is the storage declared with OSAL_queue_storage_declare()
+ * @param[in,out] handle pointer on a queue handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_queue_create_static(uint8_t* name, uint32_t size, OSAL_queue_storage_t* storage, OSAL_queue_handle_t* handle);
 
 /**
  * @brief Delete an OS queue.
@@ -115,7 +350,7 @@ OSAL_status_t OSAL_queue_delete(OSAL_queue_handle_t* handle);
  * @param[in] handle pointer on the queue handle
  * @param[in] msg message to post in the message queue
  *
- * @return operation status (@see OSAL_status_t)
+ * @return operation status (@see OSAL_status_t), OSAL_NOMEM if the queue already holds <code>size</code> messages
  */
 OSAL_status_t OSAL_queue_post(OSAL_queue_handle_t* handle, void* msg);
 
@@ -130,6 +365,128 @@ OSAL_status_t OSAL_queue_post(OSAL_queue_handle_t* handle, void* msg);
  */
 OSAL_status_t OSAL_queue_fetch(OSAL_queue_handle_t* handle, void** msg, uint32_t timeout);
 
+/**
+ * @brief Post several messages in an OS queue in one critical section. Messages are posted in array order
+ * until the queue is full.
+ *
+ * @param[in] handle pointer on the queue handle
+ * @param[in] msgs messages to post in the message queue
+ * @param[in] count number of messages in <code>msgs</code>
+ * @param[out] posted number of messages actually posted. May be NULL.
+ *
+ * @return operation status (@see OSAL_status_t), OSAL_NOMEM if the queue became full before all the messages were posted
+ */
+OSAL_status_t OSAL_queue_post_many(OSAL_queue_handle_t* handle, void** msgs, uint32_t count, uint32_t* posted);
+
+/**
+ * @brief Fetch several messages from an OS queue in one critical section. Blocks until at least one message
+ * arrived or a timeout occurred, then fetches all the available messages up to <code>max</code>.
+ *
+ * @param[in] handle pointer on the queue handle
+ * @param[in,out] msgs array filled with the fetched messages, oldest first
+ * @param[in] max length of <code>msgs</code>. Must be greater than 0.
+ * @param[out] count number of messages fetched
+ * @param[in] timeout maximum time to wait for message arrival, OSAL_INFINITE_TIME for infinite timeout
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_queue_fetch_many(OSAL_queue_handle_t* handle, void** msgs, uint32_t max, uint32_t* count, uint32_t timeout);
+
+/**
+ * @brief Fetch a message from the first of several OS queues that holds one. Blocks until a message arrived in one
+ * of the queues or a timeout occurred. This allows one task to serve several queues.
+ *
+ * The queues are checked in array order: when several queues hold messages, the lowest index is served first.
+ *
+ * @param[in] handles array of queue handles
+ * @param[in] count number of queues in <code>handles</code>, from 1 to OSAL_QUEUE_SELECT_MAX
+ * @param[out] index index in <code>handles</code> of the queue the message was fetched from
+ * @param[in,out] msg message fetched
+ * @param[in] timeout maximum time to wait for message arrival, OSAL_INFINITE_TIME for infinite timeout
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_queue_select(OSAL_queue_handle_t* handles, uint32_t count, uint32_t* index, void** msg, uint32_t timeout);
+
+#ifndef OSAL_NO_DYNAMIC_ALLOCATION
+/**
+ * @brief Create an OS priority queue. The messages are fetched by decreasing priority, and in posting order within a priority.
+ *
+ * @param[in] name priority queue name
+ * @param[in] levels number of priority levels, from 1 to OSAL_PRIO_QUEUE_MAX_LEVELS
+ * @param[in,out] handle pointer on a priority queue handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_prio_queue_create(uint8_t* name, uint32_t levels, OSAL_prio_queue_handle_t* handle);
+#endif
+
+/**
+ * @brief Create an OS priority queue in a storage declared with OSAL_prio_queue_storage_declare(). Does not allocate memory.
+ *
+ * @param[in] name priority queue name
+ * @param[in] levels number of priority levels, from 1 to OSAL_PRIO_QUEUE_MAX_LEVELS
+ * @param[in] storage priority queue storage
+ * @param[in,out] handle pointer on a priority queue handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_prio_queue_create_static(uint8_t* name, uint32_t levels, OSAL_prio_queue_storage_t* storage, OSAL_prio_queue_handle_t* handle);
+
+/**
+ * @brief Delete an OS priority queue. The pending messages are discarded.
+ *
+ * @param[in] handle pointer on the priority queue handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_prio_queue_delete(OSAL_prio_queue_handle_t* handle);
+
+/**
+ * @brief Post a message in an OS priority queue. Never blocks and never fails for lack of room.
+ *
+ * @param[in] handle pointer on the priority queue handle
+ * @param[in] msg link embedded in the message. A message must not be posted again before it is fetched.
+ * @param[in] prio message priority, from 0 (lowest) to the number of levels - 1 (highest)
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_prio_queue_post(OSAL_prio_queue_handle_t* handle, OSAL_prio_queue_node_t* msg, uint32_t prio);
+
+/**
+ * @brief Fetch the oldest message of the highest priority from an OS priority queue.
+ *
+ * @param[in] handle pointer on the priority queue handle
+ * @param[in,out] msg link embedded in the fetched message
+ * @param[in] timeout maximum time to wait for a message, OSAL_INFINITE_TIME for infinite timeout
+ *
+ * @return operation status (@see OSAL_status_t), OSAL_ERROR on timeout
+ */
+OSAL_status_t OSAL_prio_queue_fetch(OSAL_prio_queue_handle_t* handle, OSAL_prio_queue_node_t** msg, uint32_t timeout);
+
+/**
+ * @brief Remove a message that has not been fetched yet from an OS priority queue.
+ *
+ * @param[in] handle pointer on the priority queue handle
+ * @param[in] msg link embedded in the message
+ *
+ * @return operation status (@see OSAL_status_t), OSAL_ERROR if the message is not in the priority queue
+ */
+OSAL_status_t OSAL_prio_queue_remove(OSAL_prio_queue_handle_t* handle, OSAL_prio_queue_node_t* msg);
+
+/**
+ * @brief Set the fairness guard of an OS priority queue. Once a waiting level has been skipped <code>limit</code> times
+ * in favor of higher levels, its oldest message is fetched next. By default the limit is 0: strict priority, the lower
+ * levels may starve.
+ *
+ * @param[in] handle pointer on the priority queue handle
+ * @param[in] limit number of fetches a waiting level may be skipped, 0 to disable the guard
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_prio_queue_set_fairness(OSAL_prio_queue_handle_t* handle, uint32_t limit);
+
+#ifndef OSAL_NO_DYNAMIC_ALLOCATION
 /**
  * @brief Create an OS counter semaphore with a semaphore count initial value.
  *
@@ -141,6 +498,20 @@ OSAL_status_t OSAL_queue_fetch(OSAL_queue_handle_t* handle, void** msg, uint32_t
  * @return operation status (@see OSAL_status_t)
  */
 OSAL_status_t OSAL_counter_semaphore_create(uint8_t* name, uint32_t initial_count, uint32_t max_count, OSAL_counter_semaphore_handle_t* handle);
+#endif
+
+/**
+ * @brief Create an OS counter semaphore in a storage declared with OSAL_counter_semaphore_storage_declare(). Does not allocate memory.
+ *
+ * @param[in] name counter semaphore name
+ * @param[in] initial_count counter semaphore initial count value
+ * @param[in] max_count counter semaphore maximum count value
+ * @param[in] storage counter semaphore storage
+ * @param[in,out] handle pointer on a counter semaphore handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_counter_semaphore_create_static(uint8_t* name, uint32_t initial_count, uint32_t max_count, OSAL_semaphore_storage_t* storage, OSAL_counter_semaphore_handle_t* handle);
 
 /**
  * @brief Delete an OS counter semaphore.
@@ -173,6 +544,7 @@ OSAL_status_t OSAL_counter_semaphore_take(OSAL_counter_semaphore_handle_t* handl
  */
 OSAL_status_t OSAL_counter_semaphore_give(OSAL_counter_semaphore_handle_t* handle);
 
+#ifndef OSAL_NO_DYNAMIC_ALLOCATION
 /**
  * @brief Create an OS binary semaphore with a semaphore count initial value (0 or 1).
  *
@@ -183,6 +555,19 @@ OSAL_status_t OSAL_counter_semaphore_give(OSAL_counter_semaphore_handle_t* handl
  * @return operation status (@see OSAL_status_t)
  */
 OSAL_status_t OSAL_binary_semaphore_create(uint8_t* name, uint32_t initial_count, OSAL_binary_semaphore_handle_t* handle);
+#endif
+
+/**
+ * @brief Create an OS binary semaphore in a storage declared with OSAL_binary_semaphore_storage_declare(). Does not allocate memory.
+ *
+ * @param[in] name binary semaphore name
+ * @param[in] initial_count binary semaphore initial count value
+ * @param[in] storage binary semaphore storage
+ * @param[in,out] handle pointer on a binary semaphore handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_binary_semaphore_create_static(uint8_t* name, uint32_t initial_count, OSAL_semaphore_storage_t* storage, OSAL_binary_semaphore_handle_t* handle);
 
 /**
  * @brief Delete an OS binary semaphore.
@@ -215,6 +600,19 @@ OSAL_status_t OSAL_binary_semaphore_take(OSAL_binary_semaphore_handle_t* handle,
  */
 OSAL_status_t OSAL_binary_semaphore_give(OSAL_binary_semaphore_handle_t* handle);
 
+/**
+ * @brief Make the takes of an OS binary semaphore busy-wait for the semaphore before blocking, retrying with an
+ * exponential backoff. Spinning avoids a sleep and wake-up cycle when the semaphore is given by a task running on
+ * another CPU within a few microseconds.
+ *
+ * @param[in] handle pointer on the binary semaphore handle
+ * @param[in] spin_budget number of busy-wait iterations before blocking, 0 to block immediately (default OSAL_SPIN_BUDGET_DEFAULT)
+ *
+ * @return operation status (@see OSAL_status_t), OSAL_NOT_IMPLEMENTED on single CPU builds where spinning cannot help
+ */
+OSAL_status_t OSAL_binary_semaphore_set_spin_budget(OSAL_binary_semaphore_handle_t* handle, uint32_t spin_budget);
+
+#ifndef OSAL_NO_DYNAMIC_ALLOCATION
 /**
  * @brief Create an OS mutex.
  *
@@ -224,6 +622,18 @@ OSAL_status_t OSAL_binary_semaphore_give(OSAL_binary_semaphore_handle_t* handle)
  * @return operation status (@see OSAL_status_t)
  */
 OSAL_status_t OSAL_mutex_create(uint8_t* name, OSAL_mutex_handle_t* handle);
+#endif
+
+/**
+ * @brief Create an OS mutex in a storage declared with OSAL_mutex_storage_declare(). Does not allocate memory.
+ *
+ * @param[in] name mutex name
+ * @param[in] storage mutex storage
+ * @param[in,out] handle pointer on a mutex handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_mutex_create_static(uint8_t* name, OSAL_mutex_storage_t* storage, OSAL_mutex_handle_t* handle);
 
 /**
  * @brief Delete an OS mutex.
@@ -254,23 +664,390 @@ OSAL_status_t OSAL_mutex_take(OSAL_mutex_handle_t* handle, uint32_t timeout);
 OSAL_status_t OSAL_mutex_give(OSAL_mutex_handle_t* handle);
 
 /**
- * @brief Disable the OS scheduler context switching. Prevent the OS from
- * scheduling the current thread calling #OSAL_disable_context_switching while
- * the OS scheduling is already disable has an undefined behavior. This method
- * may be called from an interrupt.
+ * @brief Make the takes of an OS mutex busy-wait for the mutex before blocking, retrying with an exponential backoff.
+ * Spinning avoids a sleep and wake-up cycle when the mutex is held by a task running on another CPU for a few microseconds.
+ *
+ * @param[in] handle pointer on the mutex handle
+ * @param[in] spin_budget number of busy-wait iterations before blocking, 0 to block immediately (default OSAL_SPIN_BUDGET_DEFAULT)
+ *
+ * @return operation status (@see OSAL_status_t), OSAL_NOT_IMPLEMENTED on single CPU builds where spinning cannot help
+ */
+OSAL_status_t OSAL_mutex_set_spin_budget(OSAL_mutex_handle_t* handle, uint32_t spin_budget);
+
+#ifndef OSAL_NO_DYNAMIC_ALLOCATION
+/**
+ * @brief Create an OS reader-writer lock. Several readers may hold the lock at the same time, a writer holds it alone.
+ *
+ * @param[in] name reader-writer lock name
+ * @param[in,out] handle pointer on a reader-writer lock handle
  *
  * @return operation status (@see OSAL_status_t)
  */
+OSAL_status_t OSAL_rwlock_create(uint8_t* name, OSAL_rwlock_handle_t* handle);
+#endif
+
+/**
+ * @brief Create an OS reader-writer lock in a storage declared with OSAL_rwlock_storage_declare(). Does not allocate memory.
+ *
+ * @param[in] name reader-writer lock name
+ * @param[in] storage reader-writer lock storage
+ * @param[in,out] handle pointer on a reader-writer lock handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_rwlock_create_static(uint8_t* name, OSAL_rwlock_storage_t* storage, OSAL_rwlock_handle_t* handle);
+
+/**
+ * @brief Delete an OS reader-writer lock.
+ *
+ * @param[in] handle pointer on the reader-writer lock handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_rwlock_delete(OSAL_rwlock_handle_t* handle);
+
+/**
+ * @brief Take an OS reader-writer lock for reading. Does not wait for the other readers, only for a writer.
+ *
+ * @param[in] handle pointer on the reader-writer lock handle
+ * @param[in] timeout maximum time to wait until the lock become available, OSAL_INFINITE_TIME for infinite timeout
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_rwlock_read_take(OSAL_rwlock_handle_t* handle, uint32_t timeout);
+
+/**
+ * @brief Take an OS reader-writer lock for writing. Waits until there is no reader and no writer.
+ *
+ * @param[in] handle pointer on the reader-writer lock handle
+ * @param[in] timeout maximum time to wait until the lock become available, OSAL_INFINITE_TIME for infinite timeout
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_rwlock_write_take(OSAL_rwlock_handle_t* handle, uint32_t timeout);
+
+/**
+ * @brief Give an OS reader-writer lock taken for reading or for writing.
+ *
+ * @param[in] handle pointer on the reader-writer lock handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_rwlock_give(OSAL_rwlock_handle_t* handle);
+
+#ifndef OSAL_NO_DYNAMIC_ALLOCATION
+/**
+ * @brief Create an OS event group. All the event bits are cleared.
+ *
+ * @param[in] name event group name
+ * @param[in,out] handle pointer on an event group handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_event_group_create(uint8_t* name, OSAL_event_group_handle_t* handle);
+#endif
+
+/**
+ * @brief Create an OS event group in a storage declared with OSAL_event_group_storage_declare(). Does not allocate memory.
+ * All the event bits are cleared.
+ *
+ * @param[in] name event group name
+ * @param[in] storage event group storage
+ * @param[in,out] handle pointer on an event group handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_event_group_create_static(uint8_t* name, OSAL_event_group_storage_t* storage, OSAL_event_group_handle_t* handle);
+
+/**
+ * @brief Delete an OS event group.
+ *
+ * @param[in] handle pointer on the event group handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_event_group_delete(OSAL_event_group_handle_t* handle);
+
+/**
+ * @brief Set event bits and wake up the tasks whose wait condition is met.
+ *
+ * @param[in] handle pointer on the event group handle
+ * @param[in] bits bits to set
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_event_group_set(OSAL_event_group_handle_t* handle, uint32_t bits);
+
+/**
+ * @brief Clear event bits.
+ *
+ * @param[in] handle pointer on the event group handle
+ * @param[in] bits bits to clear
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_event_group_clear(OSAL_event_group_handle_t* handle, uint32_t bits);
+
+/**
+ * @brief Block the current task until one (OSAL_EVENT_GROUP_WAIT_ANY) or all (OSAL_EVENT_GROUP_WAIT_ALL) of the given
+ * bits are set, or a timeout occurred.
+ *
+ * @param[in] handle pointer on the event group handle
+ * @param[in] bits bits to wait for. Must not be 0.
+ * @param[in] options combination of OSAL_event_group_options_t values
+ * @param[out] set_bits event bits when the wait ended, before they are cleared by OSAL_EVENT_GROUP_CLEAR_ON_EXIT. May be NULL.
+ * @param[in] timeout maximum time to wait, OSAL_INFINITE_TIME for infinite timeout
+ *
+ * @return operation status (@see OSAL_status_t), OSAL_ERROR on timeout
+ */
+OSAL_status_t OSAL_event_group_wait(OSAL_event_group_handle_t* handle, uint32_t bits, uint32_t options, uint32_t* set_bits, uint32_t timeout);
+
+/**
+ * @brief Disable the OS scheduler context switching. Prevent the OS from
+ * scheduling other tasks than the current one until #OSAL_enable_context_switching is called.
+ * Calls may be nested by the same task: the context switching is enabled again by its outermost
+ * #OSAL_enable_context_switching. Interrupts are still served. Must not be called from an interrupt.
+ *
+ * @return operation status (@see OSAL_status_t), OSAL_ERROR if called from an interrupt
+ */
 OSAL_status_t OSAL_disable_context_switching(void);
 
 /**
  * @brief Reenable the OS scheduling that was disabled by #OSAL_disable_context_switching.
- * This method may be called from an interrupt.
+ * Must be called by the task that disabled it, not from an interrupt.
  *
- * @return operation status (@see OSAL_status_t)
+ * @return operation status (@see OSAL_status_t), OSAL_ERROR if the context switching is not disabled by the current
+ * task
  */
 OSAL_status_t OSAL_enable_context_switching(void);
 
+/**
+ * @brief Enter a critical section protected by a spinlock. The interrupts of the current CPU are disabled until
+ * #OSAL_spinlock_give is called, and the tasks running on the other CPUs busy-wait to take the same spinlock.
+ * Must only protect a few instructions. Spinlocks must not be nested.
+ *
+ * @param[in] lock spinlock initialized with OSAL_SPINLOCK_INITIALIZER
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_spinlock_take(OSAL_spinlock_t* lock);
+
+/**
+ * @brief Leave a critical section entered with #OSAL_spinlock_take.
+ *
+ * @param[in] lock spinlock taken by the current task
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_spinlock_give(OSAL_spinlock_t* lock);
+
+/**
+ * @brief Get the critical sections, context switching disabled or spinlock held, that lasted longer than
+ * OSAL_CRITICAL_SECTION_MAX_US since the startup. They are only counted: nothing is printed when a critical section
+ * ends.
+ *
+ * @param[out] overruns number of critical sections longer than OSAL_CRITICAL_SECTION_MAX_US
+ * @param[out] max_duration_us duration of the longest of them in microseconds
+ *
+ * @return operation status (@see OSAL_status_t), OSAL_NOT_IMPLEMENTED if OSAL_CRITICAL_SECTION_MAX_US is not defined
+ */
+OSAL_status_t OSAL_get_critical_section_overruns(uint32_t* overruns, uint32_t* max_duration_us);
+
+#ifndef OSAL_NO_DYNAMIC_ALLOCATION
+/**
+ * @brief Create a lock-free ring queue with a fixed number of message slots.
+ *
+ * Posting and fetching messages never block, never allocate memory and never take an OS lock, so a ring queue
+ * can be fed from a signal handler, an interrupt or a high rate native thread. Fetching does not wait for a message:
+ * when the consumer must sleep until data arrives, the producer typically gives a semaphore after a successful post.
+ *
+ * @param[in] name ring queue name
+ * @param[in] size number of message slots. Must be a power of 2 greater than 1.
+ * @param[in] type producer/consumer model. With OSAL_RINGQUEUE_SPSC, only one task may post and only one task may fetch.
+ * With OSAL_RINGQUEUE_MPSC, any number of tasks may post and only one task may fetch.
+ * @param[in,out] handle pointer on a ring queue handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_ringqueue_create(uint8_t* name, uint32_t size, OSAL_ringqueue_type_t type, OSAL_ringqueue_handle_t* handle);
+#endif
+
+/**
+ * @brief Create a lock-free ring queue in a storage declared with OSAL_ringqueue_storage_declare(). Does not allocate memory.
+ *
+ * @param[in] name ring queue name
+ * @param[in] size number of message slots. Must be the size given to OSAL_ringqueue_storage_declare(), a power of 2 greater than 1.
+ * @param[in] type producer/consumer model
+ * @param[in] storage ring queue storage, <code>&_name.ringqueue</code> where <code>_name</code> is the storage declared with OSAL_ringqueue_storage_declare()
+ * @param[in,out] handle pointer on a ring queue handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_ringqueue_create_static(uint8_t* name, uint32_t size, OSAL_ringqueue_type_t type, OSAL_ringqueue_storage_t* storage, OSAL_ringqueue_handle_t* handle);
+
+/**
+ * @brief Delete a lock-free ring queue. The pending messages are discarded.
+ *
+ * @param[in] handle pointer on the ring queue handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_ringqueue_delete(OSAL_ringqueue_handle_t* handle);
+
+/**
+ * @brief Post a message in a lock-free ring queue. Never blocks. This method may be called from an interrupt or a signal handler.
+ *
+ * @param[in] handle pointer on the ring queue handle
+ * @param[in] msg message to post in the ring queue
+ *
+ * @return operation status (@see OSAL_status_t), OSAL_NOMEM if all the slots are used
+ */
+OSAL_status_t OSAL_ringqueue_post(OSAL_ringqueue_handle_t* handle, void* msg);
+
+/**
+ * @brief Fetch the oldest message from a lock-free ring queue. Never blocks.
+ *
+ * @param[in] handle pointer on the ring queue handle
+ * @param[in,out] msg message fetched in the ring queue
+ *
+ * @return operation status (@see OSAL_status_t), OSAL_ERROR if the ring queue is empty
+ */
+OSAL_status_t OSAL_ringqueue_fetch(OSAL_ringqueue_handle_t* handle, void** msg);
+
+/**
+ * @brief Create a fixed-block memory pool in a storage declared with OSAL_pool_storage_declare(). Does not allocate memory.
+ * The blocks are allocated and freed without lock and may be used from any task.
+ *
+ * @param[in] name pool name
+ * @param[in] block_size size of a block in bytes. Must be the size given to OSAL_pool_storage_declare().
+ * @param[in] count number of blocks, from 1 to OSAL_POOL_MAX_COUNT. Must be the count given to OSAL_pool_storage_declare().
+ * @param[in] storage pool storage, <code>&_name.pool</code> where <code>_name</code> is the storage declared with OSAL_pool_storage_declare()
+ * @param[in,out] handle pointer on a pool handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_pool_create(uint8_t* name, uint32_t block_size, uint32_t count, OSAL_pool_storage_t* storage, OSAL_pool_handle_t* handle);
+
+/**
+ * @brief Allocate a block from a fixed-block memory pool. Never blocks.
+ *
+ * @param[in] handle pointer on the pool handle
+ * @param[in,out] block allocated block, aligned on 8 bytes
+ *
+ * @return operation status (@see OSAL_status_t), OSAL_NOMEM if all the blocks are allocated
+ */
+OSAL_status_t OSAL_pool_alloc(OSAL_pool_handle_t* handle, void** block);
+
+/**
+ * @brief Give a block back to the fixed-block memory pool it was allocated from. Never blocks.
+ * While the block is free, its first 4 bytes are used by the pool and the rest of its content is kept.
+ *
+ * @param[in] handle pointer on the pool handle
+ * @param[in] block block allocated with OSAL_pool_alloc()
+ *
+ * @return operation status (@see OSAL_status_t), OSAL_WRONG_ARGS if the block does not belong to the pool
+ */
+OSAL_status_t OSAL_pool_free(OSAL_pool_handle_t* handle, void* block);
+
+/**
+ * @brief Get the usage statistics of a fixed-block memory pool.
+ *
+ * @param[in] handle pointer on the pool handle
+ * @param[in,out] stats pool statistics
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_pool_get_stats(OSAL_pool_handle_t* handle, OSAL_pool_stats_t* stats);
+
+#ifndef OSAL_NO_DYNAMIC_ALLOCATION
+/**
+ * @brief Create an OS timer. The timer is created stopped.
+ *
+ * All the timers are served by one timer service task, started with the first timer creation. The callbacks are called
+ * on this task: they must be short and must not block.
+ *
+ * @param[in] name timer name
+ * @param[in] callback function called each time the timer expires
+ * @param[in] arg argument given to the callback
+ * @param[in,out] handle pointer on a timer handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_timer_create(uint8_t* name, OSAL_timer_callback_t callback, void* arg, OSAL_timer_handle_t* handle);
+#endif
+
+/**
+ * @brief Create an OS timer in a storage declared with OSAL_timer_storage_declare(). Does not allocate memory.
+ * The timer is created stopped.
+ *
+ * @param[in] name timer name
+ * @param[in] callback function called each time the timer expires
+ * @param[in] arg argument given to the callback
+ * @param[in] storage timer storage
+ * @param[in,out] handle pointer on a timer handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_timer_create_static(uint8_t* name, OSAL_timer_callback_t callback, void* arg, OSAL_timer_storage_t* storage, OSAL_timer_handle_t* handle);
+
+/**
+ * @brief Delete an OS timer. When this function returns, the timer callback is not running and will not be called anymore.
+ * A timer may delete itself from its own callback.
+ *
+ * @param[in] handle pointer on the timer handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_timer_delete(OSAL_timer_handle_t* handle);
+
+/**
+ * @brief Start an OS timer. Starting a running timer restarts it with the new delay and period.
+ * The deadlines are computed on a monotonic clock.
+ *
+ * @param[in] handle pointer on the timer handle
+ * @param[in] delay_ms delay before the first expiration, in milliseconds
+ * @param[in] period_ms period of the next expirations in milliseconds, 0 for a one-shot timer
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_timer_start(OSAL_timer_handle_t* handle, uint32_t delay_ms, uint32_t period_ms);
+
+/**
+ * @brief Stop an OS timer. Stopping a stopped timer has no effect.
+ *
+ * @param[in] handle pointer on the timer handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_timer_stop(OSAL_timer_handle_t* handle);
+
+/**
+ * @brief Copy the instrumentation records of all the existing queues, semaphores and mutexes.
+ * The counters are updated concurrently: each record is consistent only to within the operations in progress.
+ *
+ * @param[in,out] records array filled with the records. Their <code>next</code> field is set to NULL.
+ * @param[in] max length of <code>records</code>
+ * @param[out] count number of records copied
+ *
+ * @return operation status (@see OSAL_status_t), OSAL_NOMEM if there are more than <code>max</code> records,
+ * OSAL_NOT_IMPLEMENTED if OSAL_INSTRUMENTATION is not defined
+ */
+OSAL_status_t OSAL_stats_snapshot(OSAL_stats_t* records, uint32_t max, uint32_t* count);
+
+/**
+ * @brief Print the instrumentation records of all the existing queues, semaphores and mutexes on the console.
+ *
+ * @return operation status (@see OSAL_status_t), OSAL_NOT_IMPLEMENTED if OSAL_INSTRUMENTATION is not defined
+ */
+OSAL_status_t OSAL_stats_dump(void);
+
+/**
+ * @brief Reset the counters and histograms of all the instrumentation records.
+ *
+ * @return operation status (@see OSAL_status_t), OSAL_NOT_IMPLEMENTED if OSAL_INSTRUMENTATION is not defined
+ */
+OSAL_status_t OSAL_stats_reset(void);
+
 /**
  * @brief Asleep the current task during specified number of milliseconds.
  *
@@ -280,4 +1057,24 @@ OSAL_status_t OSAL_enable_context_switching(void);
  */
 OSAL_status_t OSAL_sleep(uint32_t milliseconds);
 
+/**
+ * @brief Get the time elapsed since an unspecified origin, not affected by the changes of the system date.
+ * The value wraps around every 49 days: compare two times by the sign of their difference.
+ *
+ * @param[out] milliseconds the current time in milliseconds
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_get_time_ms(uint32_t* milliseconds);
+
+/**
+ * @brief Get the time elapsed since an unspecified origin, with a microsecond resolution, to measure short durations.
+ * The value wraps around every 71 minutes: compare two times by the sign of their difference.
+ *
+ * @param[out] microseconds the current time in microseconds
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_get_time_us(uint32_t* microseconds);
+
 #endif // OSAL_H
@@ -17,6 +17,8 @@
  * @date 11 April 2018
  */
 #include <stdint.h>
+#include <pthread.h>
+#include <semaphore.h>
 
 /** @brief OS task stack */
 typedef int32_t OSAL_task_stack_t;
@@ -29,5 +31,129 @@ typedef int32_t OSAL_task_stack_t;
  */
 #define OSAL_task_stack_declare(_name, _size) OSAL_task_stack_t _name = _size
 
+/** @brief Size in bytes of a data cache line */
+#define OSAL_CACHE_LINE_SIZE (32)
+
+/** @brief OS queue storage. The fields are internal data and must not be accessed. */
+typedef struct
+{
+    pthread_cond_t condition;
+    pthread_mutex_t mutex;
+    struct osal_queue_select_node_s *selectors; // tasks selecting this queue, notified on each post
+    uint8_t *name;
+    int32_t size;     // maximum number of messages (number of slots)
+    int32_t count;    // number of messages currently stored
+    int32_t head;     // slot of the oldest message
+    void **messages;  // circular buffer of size slots, stored right after this structure
+    uint8_t is_static; // storage provided by the caller, not freed on deletion
+#ifdef OSAL_INSTRUMENTATION
+    OSAL_stats_t stats;
+#endif
+} OSAL_queue_storage_t;
+
+/** @brief OS priority queue storage. The fields are internal data and must not be accessed. */
+typedef struct
+{
+    pthread_cond_t condition;
+    pthread_mutex_t mutex;
+    OSAL_prio_queue_node_t *heads[OSAL_PRIO_QUEUE_MAX_LEVELS]; // oldest message of each level
+    OSAL_prio_queue_node_t *tails[OSAL_PRIO_QUEUE_MAX_LEVELS]; // newest message of each level
+    uint32_t non_empty_levels; // bit i set when level i holds messages
+    uint32_t skipped[OSAL_PRIO_QUEUE_MAX_LEVELS]; // fetches served to higher levels while level i was waiting
+    uint32_t fairness_limit; // 0 for strict priority, see OSAL_prio_queue_set_fairness()
+    uint32_t levels;
+    uint8_t *name;
+    uint8_t is_static;
+} OSAL_prio_queue_storage_t;
+
+/** @brief OS counter or binary semaphore storage. The fields are internal data and must not be accessed. */
+typedef struct
+{
+    sem_t sem;
+    uint32_t spin_budget; // busy-wait iterations before blocking on a take
+    uint8_t is_static;
+#ifdef OSAL_INSTRUMENTATION
+    OSAL_stats_t stats;
+#endif
+} OSAL_semaphore_storage_t;
+
+/** @brief OS mutex storage. The fields are internal data and must not be accessed. */
+typedef struct
+{
+    pthread_mutex_t mutex;
+    uint32_t spin_budget; // busy-wait iterations before blocking on a take
+    uint8_t is_static;
+#ifdef OSAL_INSTRUMENTATION
+    OSAL_stats_t stats;
+#endif
+} OSAL_mutex_storage_t;
+
+/** @brief OS reader-writer lock storage. The fields are internal data and must not be accessed. */
+typedef struct
+{
+    pthread_rwlock_t rwlock;
+    uint8_t is_static;
+} OSAL_rwlock_storage_t;
+
+/** @brief OS event group storage. The fields are internal data and must not be accessed. */
+typedef struct
+{
+    pthread_cond_t condition;
+    pthread_mutex_t mutex;
+    uint32_t bits;
+    uint8_t is_static;
+} OSAL_event_group_storage_t;
+
+/*
+ * @brief Declare the storage of a queue and of its message slots.
+ * The queue storage given to OSAL_queue_create_static() is <code>&_name.queue</code>.
+ *
+ * @param[in] _name name of the variable that defines the storage.
+ * @param[in] _size maximum number of messages. _size must be compile time constant value.
+ */
+#define OSAL_queue_storage_declare(_name, _size) struct { OSAL_queue_storage_t queue; void *messages[_size]; } _name
+
+/*
+ * @brief Declare the storage of a priority queue.
+ *
+ * @param[in] _name name of the variable that defines the storage.
+ */
+#define OSAL_prio_queue_storage_declare(_name) OSAL_prio_queue_storage_t _name
+
+/*
+ * @brief Declare the storage of a counter semaphore.
+ *
+ * @param[in] _name name of the variable that defines the storage.
+ */
+#define OSAL_counter_semaphore_storage_declare(_name) OSAL_semaphore_storage_t _name
+
+/*
+ * @brief Declare the storage of a binary semaphore.
+ *
+ * @param[in] _name name of the variable that defines the storage.
+ */
+#define OSAL_binary_semaphore_storage_declare(_name) OSAL_semaphore_storage_t _name
+
+/*
+ * @brief Declare the storage of a mutex.
+ *
+ * @param[in] _name name of the variable that defines the storage.
+ */
+#define OSAL_mutex_storage_declare(_name) OSAL_mutex_storage_t _name
+
+/*
+ * @brief Declare the storage of a reader-writer lock.
+ *
+ * @param[in] _name name of the variable that defines the storage.
+ */
+#define OSAL_rwlock_storage_declare(_name) OSAL_rwlock_storage_t _name
+
+/*
+ * @brief Declare the storage of an event group.
+ *
+ * @param[in] _name name of the variable that defines the storage.
+ */
+#define OSAL_event_group_storage_declare(_name) OSAL_event_group_storage_t _name
+
 
 #endif // OSAL_PORTMACRO_H
@@ -0,0 +1,53 @@
+/*
+ * C
+ *
+ * Copyright 2019 IS2T. All rights reserved
+ * This library is provided in source code for use, modification and test, subject to license terms
+ * Any modification of the source code will break IS2T warranties on the whole library
+ */
+
+#ifndef OSAL_STATS_H
+#define OSAL_STATS_H
+
+/**
+ * @file
+ * @brief OS Abstraction Layer instrumentation hooks, internal to the OSAL implementation.
+ * The hooks only exist when OSAL_INSTRUMENTATION is defined.
+ * @author MicroEJ Developer Team
+ * @version 0.1.0
+ * @date 11 April 2018
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "osal.h"
+
+#ifdef OSAL_INSTRUMENTATION
+
+/** @brief Add a record to the instrumentation registry. */
+void OSAL_stats_register(OSAL_stats_t* stats, uint8_t* name, OSAL_stats_type_t type);
+
+/** @brief Remove a record from the instrumentation registry. */
+void OSAL_stats_unregister(OSAL_stats_t* stats);
+
+/** @brief Monotonic time in microseconds used to measure the wait and hold times. Wraps around. */
+uint32_t OSAL_stats_time_us(void);
+
+/**
+ * @brief Record a successful acquisition.
+ *
+ * @param[in] stats record of the primitive
+ * @param[in] wait_start_us time returned by OSAL_stats_time_us() before waiting
+ * @param[in] contended true if the caller had to wait
+ */
+void OSAL_stats_acquired(OSAL_stats_t* stats, uint32_t wait_start_us, bool contended);
+
+/** @brief Record the release of a mutex acquired with OSAL_stats_acquired(). Must be called by the mutex holder. */
+void OSAL_stats_released(OSAL_stats_t* stats);
+
+/** @brief Record the number of messages of a queue after a post. Must be called with the queue locked. */
+void OSAL_stats_queue_level(OSAL_stats_t* stats, int32_t count);
+
+#endif // OSAL_INSTRUMENTATION
+
+#endif // OSAL_STATS_H
@@ -0,0 +1,228 @@
+/*
+ * C
+ *
+ * Copyright 2019 IS2T. All rights reserved
+ * This library is provided in source code for use, modification and test, subject to license terms
+ * Any modification of the source code will break IS2T warranties on the whole library
+ */
+
+/**
+ * @file
+ * @brief OS Abstraction Layer lock-free fixed-block memory pool implementation
+ * @author MicroEJ Developer Team
+ * @version 0.1.0
+ * @date 11 April 2018
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "osal.h"
+
+/*
+ * The free blocks are linked in a LIFO list: the first word of a free block holds the index of the next free block.
+ * The list head packs the index of the first free block with a tag incremented on each update, so that a
+ * compare-and-swap based on a stale head fails even if the same block went back on top of the list meanwhile (ABA).
+ * Head and links fit in 32 bits to stay lock-free on cores without 64-bit compare-and-swap.
+ */
+
+#define OSAL_POOL_INDEX_MASK	0xFFFFu
+#define OSAL_POOL_EMPTY	0xFFFFu
+#define OSAL_POOL_TAG_INCREMENT	0x10000u
+
+typedef OSAL_pool_storage_t osal_pool_t;
+
+// layout of the storage declared with OSAL_pool_storage_declare(), gives the offset of the blocks
+typedef struct {
+    OSAL_pool_storage_t pool;
+    uint64_t blocks[1];
+} osal_pool_layout_t;
+
+static inline uint32_t *OSAL_pool_link(osal_pool_t *pool, uint32_t index)
+{
+    return (uint32_t *)(pool->blocks + (index * pool->block_size));
+}
+
+/**
+ * @brief Create a fixed-block memory pool in a storage declared with OSAL_pool_storage_declare(). Does not allocate memory.
+ * The blocks are allocated and freed without lock and may be used from any task.
+ *
+ * @param[in] name pool name
+ * @param[in] block_size size of a block in bytes. Must be the size given to OSAL_pool_storage_declare().
+ * @param[in] count number of blocks, from 1 to OSAL_POOL_MAX_COUNT. Must be the count given to OSAL_pool_storage_declare().
+ * @param[in] storage pool storage, <code>&_name.pool</code> where <code>_name</code> is the storage declared with OSAL_pool_storage_declare()
+ * @param[in,out] handle pointer on a pool handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_pool_create(uint8_t *name, uint32_t block_size, uint32_t count, OSAL_pool_storage_t *storage, OSAL_pool_handle_t *handle)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    if ((NULL == handle) || (NULL == storage) || (0 == block_size) || (0 == count) || (count > OSAL_POOL_MAX_COUNT))
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        osal_pool_t *pool = storage;
+        pool->block_size = OSAL_POOL_BLOCK_SIZE(block_size);
+        pool->count = count;
+        pool->name = name;
+        pool->blocks = (uint8_t *)storage + offsetof(osal_pool_layout_t, blocks);
+        pool->used = 0;
+        pool->high_water = 0;
+        pool->failures = 0;
+
+        for (uint32_t i = 0; i < (count - 1); i++)
+        {
+            *OSAL_pool_link(pool, i) = i + 1;
+        }
+        *OSAL_pool_link(pool, count - 1) = OSAL_POOL_EMPTY;
+        pool->head = 0;
+
+        // make the initialized free list visible before the handle
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        *handle = (OSAL_pool_handle_t)pool;
+        result = OSAL_OK;
+    }
+
+    return result;
+}
+
+/**
+ * @brief Allocate a block from a fixed-block memory pool. Never blocks.
+ *
+ * @param[in] handle pointer on the pool handle
+ * @param[in,out] block allocated block, aligned on 8 bytes
+ *
+ * @return operation status (@see OSAL_status_t), OSAL_NOMEM if all the blocks are allocated
+ */
+OSAL_status_t OSAL_pool_alloc(OSAL_pool_handle_t *handle, void **block)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    if ((NULL == handle) || (NULL == block))
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        osal_pool_t *pool = (osal_pool_t *)*handle;
+        uint32_t head = __atomic_load_n(&pool->head, __ATOMIC_ACQUIRE);
+        uint32_t index;
+
+        do
+        {
+            index = head & OSAL_POOL_INDEX_MASK;
+            if (OSAL_POOL_EMPTY == index)
+            {
+                break;
+            }
+            // the block may be allocated and overwritten meanwhile: the tag makes the compare-and-swap fail in that case
+            uint32_t next = __atomic_load_n(OSAL_pool_link(pool, index), __ATOMIC_RELAXED);
+            uint32_t new_head = ((head & ~OSAL_POOL_INDEX_MASK) + OSAL_POOL_TAG_INCREMENT) | next;
+            if (__atomic_compare_exchange_n(&pool->head, &head, new_head, true, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE))
+            {
+                break;
+            }
+        } while (1);
+
+        if (OSAL_POOL_EMPTY == index)
+        {
+            __atomic_fetch_add(&pool->failures, 1, __ATOMIC_RELAXED);
+            result = OSAL_NOMEM;
+        }
+        else
+        {
+            uint32_t used = __atomic_add_fetch(&pool->used, 1, __ATOMIC_RELAXED);
+            uint32_t high_water = __atomic_load_n(&pool->high_water, __ATOMIC_RELAXED);
+            while ((used > high_water) && !__atomic_compare_exchange_n(&pool->high_water, &high_water, used, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            {
+                // high_water reloaded by the failed compare-and-swap
+            }
+
+            *block = (void *)OSAL_pool_link(pool, index);
+            result = OSAL_OK;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Give a block back to the fixed-block memory pool it was allocated from. Never blocks.
+ * While the block is free, its first 4 bytes are used by the pool and the rest of its content is kept.
+ *
+ * @param[in] handle pointer on the pool handle
+ * @param[in] block block allocated with OSAL_pool_alloc()
+ *
+ * @return operation status (@see OSAL_status_t), OSAL_WRONG_ARGS if the block does not belong to the pool
+ */
+OSAL_status_t OSAL_pool_free(OSAL_pool_handle_t *handle, void *block)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    if ((NULL == handle) || (NULL == block))
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        osal_pool_t *pool = (osal_pool_t *)*handle;
+        uintptr_t offset = (uintptr_t)block - (uintptr_t)pool->blocks;
+
+        if (((uintptr_t)block < (uintptr_t)pool->blocks) || (offset >= ((uintptr_t)pool->count * pool->block_size)) || (0 != (offset % pool->block_size)))
+        {
+            result = OSAL_WRONG_ARGS;
+        }
+        else
+        {
+            uint32_t index = (uint32_t)(offset / pool->block_size);
+            uint32_t head = __atomic_load_n(&pool->head, __ATOMIC_RELAXED);
+            uint32_t new_head;
+
+            // accounted before the block is visible to the allocators, so that used never exceeds count
+            __atomic_fetch_sub(&pool->used, 1, __ATOMIC_RELAXED);
+            do
+            {
+                __atomic_store_n(OSAL_pool_link(pool, index), head & OSAL_POOL_INDEX_MASK, __ATOMIC_RELAXED);
+                new_head = ((head & ~OSAL_POOL_INDEX_MASK) + OSAL_POOL_TAG_INCREMENT) | index;
+            } while (!__atomic_compare_exchange_n(&pool->head, &head, new_head, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+            result = OSAL_OK;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Get the usage statistics of a fixed-block memory pool.
+ *
+ * @param[in] handle pointer on the pool handle
+ * @param[in,out] stats pool statistics
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_pool_get_stats(OSAL_pool_handle_t *handle, OSAL_pool_stats_t *stats)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    if ((NULL == handle) || (NULL == stats))
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        osal_pool_t *pool = (osal_pool_t *)*handle;
+        stats->block_size = pool->block_size;
+        stats->count = pool->count;
+        stats->used = __atomic_load_n(&pool->used, __ATOMIC_RELAXED);
+        stats->high_water = __atomic_load_n(&pool->high_water, __ATOMIC_RELAXED);
+        stats->failures = __atomic_load_n(&pool->failures, __ATOMIC_RELAXED);
+        result = OSAL_OK;
+    }
+
+    return result;
+}
@@ -14,9 +14,16 @@
  * @date 11 April 2018
  */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+// cpu_set_t, pthread_setaffinity_np() and pthread_setname_np() on Linux host builds
+#define _GNU_SOURCE
+#endif
+
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
 #include <pthread.h>
+#include <sched.h>
 #include <semaphore.h>
 #include <time.h>
 #include <errno.h>
@@ -26,7 +33,19 @@
 #include <mqueue.h>
 #include <fcntl.h>
 #include "osal.h"
+#ifdef __NuttX__
 #include "pthread_mutex_timedlock.h"
+#endif
+#include "osal_stats.h"
+#ifdef __NuttX__
+#include <nuttx/irq.h>
+#include <nuttx/arch.h>
+#endif
+
+#ifdef OSAL_NO_DYNAMIC_ALLOCATION
+// any path reaching the heap fails to compile
+#pragma GCC poison malloc free
+#endif
 
 typedef struct
 {
@@ -35,40 +54,105 @@ typedef struct
     int value;
 } osal_binary_semaphore_t;
 
-typedef struct osal_linked_list_node
-{
-    void *data;
-    struct osal_linked_list_node *next;
-} osal_linked_list_node_t;
-
-typedef struct
-{
-    int32_t size;
-    osal_linked_list_node_t *node;
-} osal_linked_list_t;
-
-typedef struct
+// Registration of a task waiting in OSAL_queue_select() on a queue
+typedef struct osal_queue_select_node_s
 {
-    pthread_cond_t condition;
-    pthread_mutex_t mutex;
-    uint8_t *name;
-    int32_t size;
-    osal_linked_list_t waiting_msg;
-} osal_queue_t;
-
-static OSAL_status_t OSAL_linked_list_initialize(osal_linked_list_t *linked_list);
-static OSAL_status_t OSAL_linked_list_add(osal_linked_list_t *linked_list, void *data);
-static OSAL_status_t OSAL_linked_list_get(osal_linked_list_t *linked_list, void **data);
-static OSAL_status_t OSAL_linked_list_size(osal_linked_list_t *linked_list, int32_t *size);
+    struct osal_queue_select_node_s *next;
+    sem_t *wakeup;
+} osal_queue_select_node_t;
+
+typedef OSAL_queue_storage_t osal_queue_t;
+
+static OSAL_status_t OSAL_queue_init(osal_queue_t *queue, uint8_t *name, uint32_t size, uint8_t is_static, OSAL_queue_handle_t *handle);
+static OSAL_status_t OSAL_prio_queue_init(OSAL_prio_queue_storage_t *prio_queue, uint8_t *name, uint32_t levels, OSAL_prio_queue_handle_t *handle);
+static uint32_t OSAL_prio_queue_fair_level(OSAL_prio_queue_storage_t *prio_queue, uint32_t highest);
+static OSAL_status_t OSAL_semaphore_init(OSAL_semaphore_storage_t *semaphore, uint8_t *name, uint32_t initial_count, uint8_t is_static, void **handle);
+static OSAL_status_t OSAL_mutex_init(OSAL_mutex_storage_t *mutex, uint8_t *name, uint8_t is_static, OSAL_mutex_handle_t *handle);
+static OSAL_status_t OSAL_rwlock_init(OSAL_rwlock_storage_t *rwlock, OSAL_rwlock_handle_t *handle);
+static OSAL_status_t OSAL_event_group_init(OSAL_event_group_storage_t *event_group, uint8_t is_static, OSAL_event_group_handle_t *handle);
+static void OSAL_queue_buffer_put(osal_queue_t *queue, void *msg);
+static void *OSAL_queue_buffer_get(osal_queue_t *queue);
+static void OSAL_queue_notify_selectors(osal_queue_t *queue);
+static void OSAL_queue_select_register(osal_queue_t *queue, osal_queue_select_node_t *node);
+static void OSAL_queue_select_unregister(osal_queue_t *queue, osal_queue_select_node_t *node);
 
 #define NANOSECONDS_IN_SECONDS 1000000000
 #define NANOSECONDS_IN_MILLISECONDS 1000000
 #define MILLISECONDS_IN_SECONDS 1000
-
+#define MICROSECONDS_IN_SECONDS 1000000
+#define NANOSECONDS_IN_MICROSECONDS 1000
+
+#ifndef OSAL_SPIN_BUDGET_DEFAULT
+// Busy-wait iterations of the mutex and binary semaphore takes before blocking, see OSAL_mutex_set_spin_budget()
+#define OSAL_SPIN_BUDGET_DEFAULT 0
+#endif
+
+#ifndef OSAL_SPIN_MAX_BACKOFF
+// Maximum number of busy-wait iterations between two attempts of an adaptive take
+#define OSAL_SPIN_MAX_BACKOFF 64
+#endif
+
+#if !defined(__NuttX__) || defined(CONFIG_SMP)
+// a lock holder may run on another CPU while the taker spins
+#define OSAL_SPIN_SUPPORTED
+#endif
+
+#ifndef OSAL_TASK_SCHED_POLICY
+// Scheduling policy of the tasks created by OSAL_task_create(): SCHED_FIFO or SCHED_RR
+#define OSAL_TASK_SCHED_POLICY SCHED_FIFO
+#endif
+
+static void OSAL_task_set_sched_attr(pthread_attr_t *attr, int32_t priority);
 static OSAL_status_t OSAL_posix_current_time(struct timespec *time);
 static OSAL_status_t OSAL_posix_time_add(struct timespec t1, struct timespec t2, struct timespec *time);
 static OSAL_status_t OSAL_milliseconds_to_posix_time(struct timespec *time, uint32_t ms);
 static OSAL_status_t OSAL_add_milliseconds_to_posix_current_time(uint32_t ms, struct timespec *time);
+#ifdef OSAL_SPIN_SUPPORTED
+static bool OSAL_spin_try(int (*try_take)(void *), void *primitive, uint32_t spin_budget);
+static int OSAL_spin_try_mutex(void *mutex);
+static int OSAL_spin_try_semaphore(void *sem);
+#endif
+#ifdef OSAL_CRITICAL_SECTION_MAX_US
+static uint32_t OSAL_critical_section_time_us(void);
+static void OSAL_critical_section_end(uint32_t duration);
+#endif
+#ifdef OSAL_CRITICAL_SECTION_MAX_US
+// critical sections longer than OSAL_CRITICAL_SECTION_MAX_US, see OSAL_get_critical_section_overruns()
+static uint32_t OSAL_critical_section_overruns;
+static uint32_t OSAL_critical_section_max_duration;
+#endif
+
+#ifdef __NuttX__
+// the nesting count of OSAL_disable_context_switching() is the lock count of the current task, see sched_lockcount()
+#ifdef OSAL_CRITICAL_SECTION_MAX_US
+#ifdef CONFIG_SMP
+#define OSAL_CPU_COUNT CONFIG_SMP_NCPUS
+#define OSAL_CPU_INDEX() up_cpu_index()
+#else
+#define OSAL_CPU_COUNT 1
+#define OSAL_CPU_INDEX() 0
+#endif
+// start of the outermost section of the task holding the scheduler lock of each CPU: it cannot leave its CPU
+static uint32_t OSAL_context_switching_disable_start[OSAL_CPU_COUNT];
+#endif
+#else
+// nesting count of OSAL_disable_context_switching() for the current task
+static __thread int32_t OSAL_context_switching_disable_count = 0;
+#ifdef OSAL_CRITICAL_SECTION_MAX_US
+static __thread uint32_t OSAL_context_switching_disable_start;
+#endif
+static pthread_once_t OSAL_context_switching_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t OSAL_context_switching_host_mutex;
+
+static void OSAL_context_switching_host_init(void)
+{
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&OSAL_context_switching_host_mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+#endif
 
 /**
  * @brief Create an OS task and start it.
@@ -76,7 +160,7 @@ static OSAL_status_t OSAL_add_milliseconds_to_posix_current_time(uint32_t ms, st
  * @param[in] entry_point function called at task startup
  * @param[in] name the task name
  * @param[in] stack task stack declared using OSAL_task_stack_declare() macro
- * @param[in] priority task priority
+ * @param[in] priority task priority, clamped to the priority range of the OSAL_TASK_SCHED_POLICY scheduling policy
  * @param[in] parameters task entry parameters. NULL if no entry parameters
  * @param[in,out] handle pointer on a task handle
  *
@@ -104,7 +188,15 @@ OSAL_status_t OSAL_task_create(OSAL_task_entry_point_t entry_point, uint8_t *nam
                 pthread_result = pthread_attr_setstacksize(&attr, stack_size);
                 if (0 == pthread_result)
                 {
+                    OSAL_task_set_sched_attr(&attr, priority);
                     int32_t create_result = pthread_create((pthread_t *)handle, &attr, entry_point, parameters);
+                    if (EPERM == create_result)
+                    {
+                        // real-time scheduling not allowed (host build without privileges): inherit the creator scheduling
+                        printf("[WARNING] OSAL task %s: priority %d not applied\n", (const char *)name, (int)priority);
+                        pthread_attr_setinheritsched(&attr, PTHREAD_INHERIT_SCHED);
+                        create_result = pthread_create((pthread_t *)handle, &attr, entry_point, parameters);
+                    }
                     if (0 == create_result)
                     {
                         if (0 == pthread_setname_np((pthread_t)*handle, (const char *)name))
@@ -114,6 +206,7 @@ OSAL_status_t OSAL_task_create(OSAL_task_entry_point_t entry_point, uint8_t *nam
                     }
                 }
             }
+            pthread_attr_destroy(&attr);
         }
     }
 
@@ -134,9 +227,60 @@ OSAL_status_t OSAL_task_delete(OSAL_task_handle_t *handle)
     return OSAL_OK;
 }
 
+/**
+ * @brief Restrict the CPUs an OS task may run on. Only available on SMP NuttX and Linux host builds.
+ *
+ * @param[in] handle pointer on the task handle
+ * @param[in] cpu_mask bit i set allows the task to run on CPU i. Must not be 0.
+ *
+ * @return operation status (@see OSAL_status_t), OSAL_NOT_IMPLEMENTED if the OS does not support CPU affinity
+ */
+OSAL_status_t OSAL_task_set_affinity(OSAL_task_handle_t *handle, uint32_t cpu_mask)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    if ((NULL == handle) || (0 == cpu_mask))
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+#if defined(CONFIG_SMP) || defined(__linux__)
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        for (int32_t cpu = 0; cpu < 32; cpu++)
+        {
+            if (0 != (cpu_mask & (1u << cpu)))
+            {
+                CPU_SET(cpu, &cpu_set);
+            }
+        }
+
+        int32_t affinity_result = pthread_setaffinity_np(*(pthread_t *)handle, sizeof(cpu_set_t), &cpu_set);
+        if (0 == affinity_result)
+        {
+            result = OSAL_OK;
+        }
+        else
+        {
+            printf("[ERROR] failed to set OSAL task affinity (err: %s)\n", strerror(affinity_result));
+        }
+#else
+        result = OSAL_NOT_IMPLEMENTED;
+#endif
+    }
+
+    return result;
+}
+
+#ifndef OSAL_NO_DYNAMIC_ALLOCATION
 /**
  * @brief Create an OS queue with a predefined queue size.
  *
+ * All the message slots are allocated at creation time: posting and fetching messages never allocate memory.
+ *
+ * @param[in] name queue name
+ * @param[in] size maximum number of messages that the queue can hold
  * @param[in,out] handle pointer on a queue handle
  *
  * @return operation status (@see OSAL_status_t)
@@ -144,56 +288,37 @@ OSAL_status_t OSAL_task_delete(OSAL_task_handle_t *handle)
 OSAL_status_t OSAL_queue_create(uint8_t *name, uint32_t size, OSAL_queue_handle_t *handle)
 {
     OSAL_status_t result = OSAL_ERROR;
-    int32_t errnum;
 
-    if (NULL == handle)
+    if ((NULL == handle) || (NULL == name) || (0 == size) || (size > INT32_MAX / sizeof(void *)))
     {
         result = OSAL_WRONG_ARGS;
     }
     else
     {
-        osal_queue_t *queue_tmp = malloc(sizeof(osal_queue_t));
+        // the message slots are allocated right after the queue structure
+        osal_queue_t *queue_tmp = malloc(sizeof(osal_queue_t) + (size * sizeof(void *)));
         if (NULL == queue_tmp)
         {
-            errnum = errno;
-            if (ENOMEM == errnum)
-            {
-                printf("[ERROR] OSAL queue memory allocation failed\n");
-                result = OSAL_NOMEM;
-            }
+            printf("[ERROR] OSAL queue memory allocation failed\n");
+            result = OSAL_NOMEM;
         }
         else
         {
-            uint8_t *name_local = malloc(strlen((const char *)name));
+            uint8_t *name_local = malloc(strlen((const char *)name) + 1);
             if (NULL == name_local)
             {
-                errnum = errno;
-                if (ENOMEM == errnum)
-                {
-                    printf("[ERROR] OSAL queue name memory allocation failed\n");
-                    free(queue_tmp);
-                    result = OSAL_NOMEM;
-                }
+                printf("[ERROR] OSAL queue name memory allocation failed\n");
+                free(queue_tmp);
+                result = OSAL_NOMEM;
             }
             else
             {
                 strcpy((char *)name_local, (const char *)name);
-                queue_tmp->name = name_local;
-                queue_tmp->size = size;
-                result = OSAL_linked_list_initialize(&(queue_tmp->waiting_msg));
-
-                if ((result == OSAL_OK) && (0 == pthread_mutex_init((pthread_mutex_t *)&(queue_tmp->mutex), NULL)))
-                {
-                    result = OSAL_OK;
-                }
-
-                if ((result == OSAL_OK) && (0 != pthread_cond_init((pthread_cond_t *)&(queue_tmp->condition), NULL)))
-                {
-                    result = OSAL_ERROR;
-                }
-                else
+                result = OSAL_queue_init(queue_tmp, name_local, size, 0, handle);
+                if (OSAL_OK != result)
                 {
-                    *handle = (OSAL_queue_handle_t)queue_tmp;
+                    free(name_local);
+                    free(queue_tmp);
                 }
             }
         }
@@ -201,6 +326,33 @@ OSAL_status_t OSAL_queue_create(uint8_t *name, uint32_t size, OSAL_queue_handle_
 
     return result;
 }
+#endif // OSAL_NO_DYNAMIC_ALLOCATION
+
+/**
+ * @brief Create an OS queue in a storage declared with OSAL_queue_storage_declare(). Does not allocate memory.
+ *
+ * @param[in] name queue name. Not copied: must remain valid until the queue is deleted.
+ * @param[in] size maximum number of messages that the queue can hold. Must be the size given to OSAL_queue_storage_declare().
+ * @param[in] storage queue storage, <code>&_name.queue</code> where <code>_name</code> is the storage declared with OSAL_queue_storage_declare()
+ * @param[in,out] handle pointer on a queue handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_queue_create_static(uint8_t *name, uint32_t size, OSAL_queue_storage_t *storage, OSAL_queue_handle_t *handle)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    if ((NULL == handle) || (NULL == name) || (NULL == storage) || (0 == size) || (size > INT32_MAX / sizeof(void *)))
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        result = OSAL_queue_init(storage, name, size, 1, handle);
+    }
+
+    return result;
+}
 
 /**
  * @brief Delete an OS queue.
@@ -219,32 +371,31 @@ OSAL_status_t OSAL_queue_delete(OSAL_queue_handle_t *handle)
     }
     else
     {
+        osal_queue_t *queue_tmp = (osal_queue_t *)*handle;
+
+#ifdef OSAL_INSTRUMENTATION
+        OSAL_stats_unregister(&queue_tmp->stats);
+#endif
+
         // free queue mutex and condition
-        if (0 == pthread_mutex_destroy(&((osal_queue_t *)*handle)->mutex))
+        if (0 == pthread_mutex_destroy(&(queue_tmp->mutex)))
         {
             result = OSAL_OK;
         }
 
-        if ((result == OSAL_OK) && (0 != pthread_cond_destroy(&((osal_queue_t *)*handle)->condition)))
+        if ((result == OSAL_OK) && (0 != pthread_cond_destroy(&(queue_tmp->condition))))
         {
             result = OSAL_ERROR;
         }
 
-        // free the queue linked list
-        if (result == OSAL_OK)
+#ifndef OSAL_NO_DYNAMIC_ALLOCATION
+        if (0 == queue_tmp->is_static)
         {
-            osal_linked_list_node_t *linked_list_node_tmp_current = (((osal_queue_t *)*handle)->waiting_msg).node;
-            osal_linked_list_node_t *linked_list_node_tmp_next = NULL;
-            while (NULL != linked_list_node_tmp_current)
-            {
-                linked_list_node_tmp_next = linked_list_node_tmp_current->next;
-                free(linked_list_node_tmp_current);
-                linked_list_node_tmp_current = linked_list_node_tmp_next;
-            }
+            // the message slots are part of the queue allocation
+            free(queue_tmp->name);
+            free(queue_tmp);
         }
-
-        free(((osal_queue_t *)*handle)->name);
-        free(((osal_queue_t *)*handle));
+#endif
     }
 
     return result;
@@ -256,7 +407,7 @@ OSAL_status_t OSAL_queue_delete(OSAL_queue_handle_t *handle)
  * @param[in] handle pointer on the queue handle
  * @param[in] msg message to post in the message queue
  *
- * @return operation status (@see OSAL_status_t)
+ * @return operation status (@see OSAL_status_t), OSAL_NOMEM if the queue is full
  */
 OSAL_status_t OSAL_queue_post(OSAL_queue_handle_t *handle, void *msg)
 {
@@ -269,11 +420,21 @@ OSAL_status_t OSAL_queue_post(OSAL_queue_handle_t *handle, void *msg)
     else
     {
         osal_queue_t *queue_tmp = (osal_queue_t *)*handle;
-        pthread_mutex_lock(&((queue_tmp->mutex)));
+        pthread_mutex_lock(&(queue_tmp->mutex));
 
-        result = OSAL_linked_list_add(&(queue_tmp->waiting_msg), msg);
+        if (queue_tmp->count < queue_tmp->size)
+        {
+            OSAL_queue_buffer_put(queue_tmp, msg);
+            pthread_cond_signal(&(queue_tmp->condition));
+            OSAL_queue_notify_selectors(queue_tmp);
+            result = OSAL_OK;
+        }
+        else
+        {
+            // queue full
+            result = OSAL_NOMEM;
+        }
 
-        pthread_cond_signal(&(queue_tmp->condition));
         pthread_mutex_unlock(&(queue_tmp->mutex));
     }
     return result;
@@ -284,15 +445,33 @@ OSAL_status_t OSAL_queue_post(OSAL_queue_handle_t *handle, void *msg)
  *
  * @param[in] handle pointer on the queue handle
  * @param[in,out] msg message fetched in the OS queue
- * @param[in] timeout maximum time to wait for message arrival
+ * @param[in] timeout maximum time to wait for message arrival, OSAL_INFINITE_TIME for infinite timeout
  *
  * @return operation status (@see OSAL_status_t)
  */
 OSAL_status_t OSAL_queue_fetch(OSAL_queue_handle_t *handle, void **msg, uint32_t timeout)
+{
+    uint32_t count;
+    return OSAL_queue_fetch_many(handle, msg, 1, &count, timeout);
+}
+
+/**
+ * @brief Post several messages in an OS queue in one critical section. Messages are posted in array order
+ * until the queue is full.
+ *
+ * @param[in] handle pointer on the queue handle
+ * @param[in] msgs messages to post in the message queue
+ * @param[in] count number of messages in <code>msgs</code>
+ * @param[out] posted number of messages actually posted. May be NULL.
+ *
+ * @return operation status (@see OSAL_status_t), OSAL_NOMEM if the queue became full before all the messages were posted
+ */
+OSAL_status_t OSAL_queue_post_many(OSAL_queue_handle_t *handle, void **msgs, uint32_t count, uint32_t *posted)
 {
     OSAL_status_t result = OSAL_ERROR;
+    uint32_t posted_count = 0;
 
-    if ((NULL == handle) || (NULL == msg))
+    if ((NULL == handle) || ((NULL == msgs) && (0 != count)))
     {
         result = OSAL_WRONG_ARGS;
     }
@@ -300,184 +479,289 @@ OSAL_status_t OSAL_queue_fetch(OSAL_queue_handle_t *handle, void **msg, uint32_t
     {
         osal_queue_t *queue_tmp = (osal_queue_t *)*handle;
         pthread_mutex_lock(&(queue_tmp->mutex));
-        int32_t queue_size = 0;
 
-        result = OSAL_linked_list_size(&queue_tmp->waiting_msg, &queue_size);
-        if ((OSAL_OK == result) && (queue_size > 0))
+        while ((posted_count < count) && (queue_tmp->count < queue_tmp->size))
         {
-            result = OSAL_linked_list_get(&queue_tmp->waiting_msg, msg);
-            if (NULL == msg)
-            {
-                printf("[ERROR]\n");
-            }
+            OSAL_queue_buffer_put(queue_tmp, msgs[posted_count]);
+            ++posted_count;
         }
-        else
+
+        if (posted_count > 1)
         {
-            struct timespec absolute_time_result;
+            // several consumers may be waiting
+            pthread_cond_broadcast(&(queue_tmp->condition));
+        }
+        else if (posted_count == 1)
+        {
+            pthread_cond_signal(&(queue_tmp->condition));
+        }
 
-            if (OSAL_OK == OSAL_add_milliseconds_to_posix_current_time(timeout, &absolute_time_result))
-            {
-                int32_t cond_wait_result = 0;
-                if (0 == (cond_wait_result = pthread_cond_timedwait(&(queue_tmp->condition), &(queue_tmp->mutex), &absolute_time_result)))
-                {
-                    result = OSAL_linked_list_size(&queue_tmp->waiting_msg, &queue_size);
-                    if ((OSAL_OK == result) && (queue_size > 0))
-                    {
-                        result = OSAL_linked_list_get(&queue_tmp->waiting_msg, msg);
-                        if (NULL == msg)
-                        {
-                            printf("[ERROR] 2\n");
-                        }
-                        result = OSAL_OK;
-                    }
-                    else
-                    {
-                        printf("[ERROR] 3\n");
-                    }
-                }
-                else
-                {
-                    printf("[ERROR] failed to invoke pthread_cond_timedwait function (err: %s)\n", strerror(cond_wait_result));
-                }
-            }
-            else
-            {
-                printf("[ERROR] 1\n");
-            }
+        if (posted_count > 0)
+        {
+            OSAL_queue_notify_selectors(queue_tmp);
         }
+
         pthread_mutex_unlock(&(queue_tmp->mutex));
+
+        result = (posted_count == count) ? OSAL_OK : OSAL_NOMEM;
+    }
+
+    if (NULL != posted)
+    {
+        *posted = posted_count;
     }
     return result;
 }
 
 /**
- * @brief Create an OS counter semaphore with a semaphore count initial value.
+ * @brief Fetch several messages from an OS queue in one critical section. Blocks until at least one message
+ * arrived or a timeout occurred, then fetches all the available messages up to <code>max</code>.
  *
- * @param[in] name counter semaphore name
- * @param[in] initial_count counter semaphore initial count value
- * @param[in] max_count counter semaphore maximum count value
- * @param[in,out] handle pointer on a counter semaphore handle
+ * @param[in] handle pointer on the queue handle
+ * @param[in,out] msgs array filled with the fetched messages, oldest first
+ * @param[in] max length of <code>msgs</code>. Must be greater than 0.
+ * @param[out] count number of messages fetched
+ * @param[in] timeout maximum time to wait for message arrival, OSAL_INFINITE_TIME for infinite timeout
  *
  * @return operation status (@see OSAL_status_t)
  */
-OSAL_status_t OSAL_counter_semaphore_create(uint8_t *name, uint32_t initial_count, uint32_t max_count, OSAL_counter_semaphore_handle_t *handle)
+OSAL_status_t OSAL_queue_fetch_many(OSAL_queue_handle_t *handle, void **msgs, uint32_t max, uint32_t *count, uint32_t timeout)
 {
     OSAL_status_t result = OSAL_ERROR;
-    sem_t *mutex_sem = malloc(sizeof(sem_t));
 
-    if (NULL == handle)
+    if ((NULL == handle) || (NULL == msgs) || (0 == max) || (NULL == count))
     {
         result = OSAL_WRONG_ARGS;
     }
     else
     {
-        if (-1 != sem_init(mutex_sem, 0, initial_count))
+        osal_queue_t *queue_tmp = (osal_queue_t *)*handle;
+        struct timespec absolute_time_result;
+        int32_t wait_result = 0;
+        uint32_t fetched_count = 0;
+#ifdef OSAL_INSTRUMENTATION
+        uint32_t wait_start = OSAL_stats_time_us();
+        bool contended;
+#endif
+
+        if ((OSAL_INFINITE_TIME != timeout) && (OSAL_OK != OSAL_add_milliseconds_to_posix_current_time(timeout, &absolute_time_result)))
+        {
+            return OSAL_ERROR;
+        }
+
+        pthread_mutex_lock(&(queue_tmp->mutex));
+#ifdef OSAL_INSTRUMENTATION
+        contended = (0 == queue_tmp->count);
+#endif
+
+        // loop to handle spurious wakeups
+        while ((0 == queue_tmp->count) && (0 == wait_result))
+        {
+            if (OSAL_INFINITE_TIME == timeout)
+            {
+                wait_result = pthread_cond_wait(&(queue_tmp->condition), &(queue_tmp->mutex));
+            }
+            else
+            {
+                wait_result = pthread_cond_timedwait(&(queue_tmp->condition), &(queue_tmp->mutex), &absolute_time_result);
+            }
+        }
+
+        while ((fetched_count < max) && (queue_tmp->count > 0))
+        {
+            msgs[fetched_count] = OSAL_queue_buffer_get(queue_tmp);
+            ++fetched_count;
+        }
+
+        if (fetched_count > 0)
         {
-            *handle = mutex_sem;
+#ifdef OSAL_INSTRUMENTATION
+            OSAL_stats_acquired(&queue_tmp->stats, wait_start, contended);
+#endif
             result = OSAL_OK;
         }
+        else if (ETIMEDOUT != wait_result)
+        {
+            printf("[ERROR] failed to wait on OSAL queue condition (err: %s)\n", strerror(wait_result));
+        }
+
+        pthread_mutex_unlock(&(queue_tmp->mutex));
+        *count = fetched_count;
     }
     return result;
 }
 
 /**
- * @brief Delete an OS counter semaphore.
+ * @brief Fetch a message from the first of several OS queues that holds one. Blocks until a message arrived in one
+ * of the queues or a timeout occurred. This allows one task to serve several queues.
  *
- * @param[in] handle pointer on the counter semaphore handle
+ * The queues are checked in array order: when several queues hold messages, the lowest index is served first.
+ *
+ * @param[in] handles array of queue handles
+ * @param[in] count number of queues in <code>handles</code>, from 1 to OSAL_QUEUE_SELECT_MAX
+ * @param[out] index index in <code>handles</code> of the queue the message was fetched from
+ * @param[in,out] msg message fetched
+ * @param[in] timeout maximum time to wait for message arrival, OSAL_INFINITE_TIME for infinite timeout
  *
  * @return operation status (@see OSAL_status_t)
  */
-OSAL_status_t OSAL_counter_semaphore_delete(OSAL_counter_semaphore_handle_t *handle)
+OSAL_status_t OSAL_queue_select(OSAL_queue_handle_t *handles, uint32_t count, uint32_t *index, void **msg, uint32_t timeout)
 {
     OSAL_status_t result = OSAL_ERROR;
 
-    if (NULL == handle)
+    if ((NULL == handles) || (0 == count) || (count > OSAL_QUEUE_SELECT_MAX) || (NULL == index) || (NULL == msg))
     {
         result = OSAL_WRONG_ARGS;
     }
     else
     {
-        if (-1 != sem_destroy(*handle))
+        struct timespec absolute_time_result;
+        osal_queue_select_node_t nodes[OSAL_QUEUE_SELECT_MAX];
+        sem_t wakeup;
+        bool waiting = true;
+
+        if ((OSAL_INFINITE_TIME != timeout) && (OSAL_OK != OSAL_add_milliseconds_to_posix_current_time(timeout, &absolute_time_result)))
         {
-            result = OSAL_OK;
+            return OSAL_ERROR;
+        }
+
+        if (0 != sem_init(&wakeup, 0, 0))
+        {
+            printf("[ERROR] failed to init OSAL queue select semaphore (errno: %d)\n", errno);
+            return OSAL_ERROR;
+        }
+
+        // register on all the queues first: a message posted after a queue was checked wakes the task up
+        for (uint32_t i = 0; i < count; i++)
+        {
+            nodes[i].wakeup = &wakeup;
+            OSAL_queue_select_register((osal_queue_t *)handles[i], &nodes[i]);
+        }
+
+        while (OSAL_OK != result)
+        {
+            for (uint32_t i = 0; (i < count) && (OSAL_OK != result); i++)
+            {
+                osal_queue_t *queue_tmp = (osal_queue_t *)handles[i];
+                pthread_mutex_lock(&(queue_tmp->mutex));
+                if (queue_tmp->count > 0)
+                {
+                    *msg = OSAL_queue_buffer_get(queue_tmp);
+                    *index = i;
+                    result = OSAL_OK;
+                }
+                pthread_mutex_unlock(&(queue_tmp->mutex));
+            }
+
+            if ((OSAL_OK == result) || !waiting)
+            {
+                break;
+            }
+
+            // the semaphore may be posted several times or by a message already fetched by another task: loop to check again
+            int32_t wait_result;
+            if (OSAL_INFINITE_TIME == timeout)
+            {
+                wait_result = sem_wait(&wakeup);
+            }
+            else
+            {
+                wait_result = sem_timedwait(&wakeup, &absolute_time_result);
+            }
+
+            if ((0 != wait_result) && (ETIMEDOUT == errno))
+            {
+                // check the queues a last time
+                waiting = false;
+            }
+        }
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            OSAL_queue_select_unregister((osal_queue_t *)handles[i], &nodes[i]);
         }
-        free(*handle);
+        sem_destroy(&wakeup);
     }
+
     return result;
 }
 
+#ifndef OSAL_NO_DYNAMIC_ALLOCATION
 /**
- * @brief Take operation on OS counter semaphore. Block the current task until counter semaphore
- * become available or timeout occurred. Decrease the counter semaphore count value by 1 and
- * block the current task if count value equals to 0.
+ * @brief Create an OS priority queue. The messages are fetched by decreasing priority, and in posting order within a priority.
  *
- * @param[in] handle pointer on the counter semaphore handle
- * @param[in] timeout maximum time to wait until the counter semaphore become available
+ * @param[in] name priority queue name
+ * @param[in] levels number of priority levels, from 1 to OSAL_PRIO_QUEUE_MAX_LEVELS
+ * @param[in,out] handle pointer on a priority queue handle
  *
  * @return operation status (@see OSAL_status_t)
  */
-OSAL_status_t OSAL_counter_semaphore_take(OSAL_counter_semaphore_handle_t *handle, uint32_t timeout)
+OSAL_status_t OSAL_prio_queue_create(uint8_t *name, uint32_t levels, OSAL_prio_queue_handle_t *handle)
 {
     OSAL_status_t result = OSAL_ERROR;
-    struct timespec ts;
 
-    if (NULL == handle)
+    if ((NULL == handle) || (0 == levels) || (OSAL_PRIO_QUEUE_MAX_LEVELS < levels))
     {
         result = OSAL_WRONG_ARGS;
     }
     else
     {
-        if (-1 != clock_gettime(CLOCK_REALTIME, &ts))
+        OSAL_prio_queue_storage_t *prio_queue = malloc(sizeof(OSAL_prio_queue_storage_t));
+        if (NULL == prio_queue)
+        {
+            printf("[ERROR] OSAL priority queue memory allocation failed\n");
+            result = OSAL_NOMEM;
+        }
+        else
         {
-            ts.tv_nsec += timeout * 1000 * 1000;
-            if (-1 != sem_timedwait(*handle, &ts))
+            prio_queue->is_static = 0;
+            result = OSAL_prio_queue_init(prio_queue, name, levels, handle);
+            if (OSAL_OK != result)
             {
-                result = OSAL_OK;
+                free(prio_queue);
             }
         }
     }
     return result;
 }
+#endif // OSAL_NO_DYNAMIC_ALLOCATION
 
 /**
- * @brief Give operation on OS counter semaphore. Increase the counter semaphore count value by 1 and unblock the current task if count value.
- * equals to 0.
+ * @brief Create an OS priority queue in a storage declared with OSAL_prio_queue_storage_declare(). Does not allocate memory.
  *
- * @param[in] handle pointer on the counter semaphore handle
+ * @param[in] name priority queue name
+ * @param[in] levels number of priority levels, from 1 to OSAL_PRIO_QUEUE_MAX_LEVELS
+ * @param[in] storage priority queue storage
+ * @param[in,out] handle pointer on a priority queue handle
  *
  * @return operation status (@see OSAL_status_t)
  */
-OSAL_status_t OSAL_counter_semaphore_give(OSAL_counter_semaphore_handle_t *handle)
+OSAL_status_t OSAL_prio_queue_create_static(uint8_t *name, uint32_t levels, OSAL_prio_queue_storage_t *storage, OSAL_prio_queue_handle_t *handle)
 {
     OSAL_status_t result = OSAL_ERROR;
 
-    if (NULL == handle)
+    if ((NULL == handle) || (NULL == storage) || (0 == levels) || (OSAL_PRIO_QUEUE_MAX_LEVELS < levels))
     {
         result = OSAL_WRONG_ARGS;
     }
     else
     {
-        if (-1 != sem_post(*handle))
-        {
-            result = OSAL_OK;
-        }
+        storage->is_static = 1;
+        result = OSAL_prio_queue_init(storage, name, levels, handle);
     }
     return result;
 }
 
 /**
- * @brief Create an OS binary semaphore with a semaphore count initial value (0 or 1).
+ * @brief Delete an OS priority queue. The pending messages are discarded.
  *
- * @param[in] name counter semaphore name
- * @param[in] initial_count counter semaphore initial count value
- * @param[in,out] handle pointer on a binary semaphore handle
+ * @param[in] handle pointer on the priority queue handle
  *
  * @return operation status (@see OSAL_status_t)
  */
-OSAL_status_t OSAL_binary_semaphore_create(uint8_t *name, uint32_t initial_count, OSAL_binary_semaphore_handle_t *handle)
+OSAL_status_t OSAL_prio_queue_delete(OSAL_prio_queue_handle_t *handle)
 {
     OSAL_status_t result = OSAL_ERROR;
-    sem_t *mutex_sem = malloc(sizeof(sem_t));
 
     if (NULL == handle)
     {
@@ -485,205 +769,1347 @@ OSAL_status_t OSAL_binary_semaphore_create(uint8_t *name, uint32_t initial_count
     }
     else
     {
-        if (-1 != sem_init(mutex_sem, 0, (0 == initial_count) ? 0 : 1))
+        OSAL_prio_queue_storage_t *prio_queue = (OSAL_prio_queue_storage_t *)*handle;
+        if ((0 == pthread_cond_destroy(&(prio_queue->condition))) && (0 == pthread_mutex_destroy(&(prio_queue->mutex))))
         {
-            *handle = mutex_sem;
             result = OSAL_OK;
         }
+#ifndef OSAL_NO_DYNAMIC_ALLOCATION
+        if (0 == prio_queue->is_static)
+        {
+            free(prio_queue);
+        }
+#endif
     }
     return result;
 }
 
 /**
- * @brief Delete an OS binary semaphore.
+ * @brief Post a message in an OS priority queue. Never blocks and never fails for lack of room.
  *
- * @param[in] handle pointer on the binary semaphore handle
+ * @param[in] handle pointer on the priority queue handle
+ * @param[in] msg link embedded in the message. A message must not be posted again before it is fetched.
+ * @param[in] prio message priority, from 0 (lowest) to the number of levels - 1 (highest)
  *
  * @return operation status (@see OSAL_status_t)
  */
-OSAL_status_t OSAL_binary_semaphore_delete(OSAL_binary_semaphore_handle_t *handle)
+OSAL_status_t OSAL_prio_queue_post(OSAL_prio_queue_handle_t *handle, OSAL_prio_queue_node_t *msg, uint32_t prio)
 {
-    return OSAL_counter_semaphore_delete(handle);
+    OSAL_status_t result = OSAL_ERROR;
+
+    if ((NULL == handle) || (NULL == msg) || (((OSAL_prio_queue_storage_t *)*handle)->levels <= prio))
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        OSAL_prio_queue_storage_t *prio_queue = (OSAL_prio_queue_storage_t *)*handle;
+
+        msg->next = NULL;
+        pthread_mutex_lock(&(prio_queue->mutex));
+        if (NULL == prio_queue->tails[prio])
+        {
+            prio_queue->heads[prio] = msg;
+            prio_queue->non_empty_levels |= (1u << prio);
+        }
+        else
+        {
+            prio_queue->tails[prio]->next = msg;
+        }
+        prio_queue->tails[prio] = msg;
+        pthread_cond_signal(&(prio_queue->condition));
+        pthread_mutex_unlock(&(prio_queue->mutex));
+        result = OSAL_OK;
+    }
+    return result;
 }
 
 /**
- * @brief Take operation on OS binary semaphore. Block the current task until binary semaphore
- * become available or timeout occurred. Decrease the binary semaphore count value by 1 and
- * block the current task if count value equals to 0.
+ * @brief Fetch the oldest message of the highest priority from an OS priority queue.
  *
- * @param[in] handle pointer on the binary semaphore handle
- * @param[in] timeout maximum time to wait until the binary semaphore become available
+ * @param[in] handle pointer on the priority queue handle
+ * @param[in,out] msg link embedded in the fetched message
+ * @param[in] timeout maximum time to wait for a message, OSAL_INFINITE_TIME for infinite timeout
  *
- * @return operation status (@see OSAL_status_t)
+ * @return operation status (@see OSAL_status_t), OSAL_ERROR on timeout
  */
-OSAL_status_t OSAL_binary_semaphore_take(OSAL_binary_semaphore_handle_t *handle, uint32_t timeout)
+OSAL_status_t OSAL_prio_queue_fetch(OSAL_prio_queue_handle_t *handle, OSAL_prio_queue_node_t **msg, uint32_t timeout)
 {
-    return OSAL_counter_semaphore_take(handle, timeout);
-}
+    OSAL_status_t result = OSAL_ERROR;
+
+    if ((NULL == handle) || (NULL == msg))
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        OSAL_prio_queue_storage_t *prio_queue = (OSAL_prio_queue_storage_t *)*handle;
+        struct timespec absolute_time_result;
+        int32_t wait_result = 0;
+
+        if ((OSAL_INFINITE_TIME != timeout) && (OSAL_OK != OSAL_add_milliseconds_to_posix_current_time(timeout, &absolute_time_result)))
+        {
+            return OSAL_ERROR;
+        }
+
+        pthread_mutex_lock(&(prio_queue->mutex));
+
+        // loop to handle spurious wakeups
+        while ((0 == prio_queue->non_empty_levels) && (0 == wait_result))
+        {
+            if (OSAL_INFINITE_TIME == timeout)
+            {
+                wait_result = pthread_cond_wait(&(prio_queue->condition), &(prio_queue->mutex));
+            }
+            else
+            {
+                wait_result = pthread_cond_timedwait(&(prio_queue->condition), &(prio_queue->mutex), &absolute_time_result);
+            }
+        }
+
+        if (0 != prio_queue->non_empty_levels)
+        {
+            // highest non-empty level
+            uint32_t prio = 31 - __builtin_clz(prio_queue->non_empty_levels);
+            if (0 != prio_queue->fairness_limit)
+            {
+                prio = OSAL_prio_queue_fair_level(prio_queue, prio);
+            }
+            OSAL_prio_queue_node_t *node = prio_queue->heads[prio];
+            prio_queue->heads[prio] = node->next;
+            if (NULL == node->next)
+            {
+                prio_queue->tails[prio] = NULL;
+                prio_queue->non_empty_levels &= ~(1u << prio);
+            }
+            node->next = NULL;
+            *msg = node;
+            result = OSAL_OK;
+        }
+        else if (ETIMEDOUT != wait_result)
+        {
+            printf("[ERROR] failed to wait on OSAL priority queue condition (err: %s)\n", strerror(wait_result));
+        }
+
+        pthread_mutex_unlock(&(prio_queue->mutex));
+    }
+    return result;
+}
 
 /**
- * @brief Give operation on OS binary semaphore. Increase the binary semaphore count value by 1 and unblock the current task if count value.
+ * @brief Remove a message that has not been fetched yet from an OS priority queue.
+ *
+ * @param[in] handle pointer on the priority queue handle
+ * @param[in] msg link embedded in the message
+ *
+ * @return operation status (@see OSAL_status_t), OSAL_ERROR if the message is not in the priority queue
+ */
+OSAL_status_t OSAL_prio_queue_remove(OSAL_prio_queue_handle_t *handle, OSAL_prio_queue_node_t *msg)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    if ((NULL == handle) || (NULL == msg))
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        OSAL_prio_queue_storage_t *prio_queue = (OSAL_prio_queue_storage_t *)*handle;
+
+        pthread_mutex_lock(&(prio_queue->mutex));
+        for (uint32_t prio = 0; (prio < prio_queue->levels) && (OSAL_OK != result); prio++)
+        {
+            OSAL_prio_queue_node_t *previous = NULL;
+            OSAL_prio_queue_node_t *node = prio_queue->heads[prio];
+            while ((NULL != node) && (msg != node))
+            {
+                previous = node;
+                node = node->next;
+            }
+
+            if (NULL != node)
+            {
+                // unlink the message from its level
+                if (NULL == previous)
+                {
+                    prio_queue->heads[prio] = node->next;
+                }
+                else
+                {
+                    previous->next = node->next;
+                }
+                if (prio_queue->tails[prio] == node)
+                {
+                    prio_queue->tails[prio] = previous;
+                }
+                if (NULL == prio_queue->heads[prio])
+                {
+                    prio_queue->non_empty_levels &= ~(1u << prio);
+                    prio_queue->skipped[prio] = 0;
+                }
+                node->next = NULL;
+                result = OSAL_OK;
+            }
+        }
+        pthread_mutex_unlock(&(prio_queue->mutex));
+    }
+    return result;
+}
+
+/**
+ * @brief Set the fairness guard of an OS priority queue. Once a waiting level has been skipped <code>limit</code> times
+ * in favor of higher levels, its oldest message is fetched next. By default the limit is 0: strict priority, the lower
+ * levels may starve.
+ *
+ * @param[in] handle pointer on the priority queue handle
+ * @param[in] limit number of fetches a waiting level may be skipped, 0 to disable the guard
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_prio_queue_set_fairness(OSAL_prio_queue_handle_t *handle, uint32_t limit)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    if (NULL == handle)
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        OSAL_prio_queue_storage_t *prio_queue = (OSAL_prio_queue_storage_t *)*handle;
+        pthread_mutex_lock(&(prio_queue->mutex));
+        prio_queue->fairness_limit = limit;
+        pthread_mutex_unlock(&(prio_queue->mutex));
+        result = OSAL_OK;
+    }
+    return result;
+}
+
+#ifndef OSAL_NO_DYNAMIC_ALLOCATION
+/**
+ * @brief Create an OS counter semaphore with a semaphore count initial value.
+ *
+ * @param[in] name counter semaphore name
+ * @param[in] initial_count counter semaphore initial count value
+ * @param[in] max_count counter semaphore maximum count value
+ * @param[in,out] handle pointer on a counter semaphore handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_counter_semaphore_create(uint8_t *name, uint32_t initial_count, uint32_t max_count, OSAL_counter_semaphore_handle_t *handle)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    if (NULL == handle)
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        OSAL_semaphore_storage_t *semaphore = malloc(sizeof(OSAL_semaphore_storage_t));
+        if (NULL == semaphore)
+        {
+            printf("[ERROR] OSAL semaphore memory allocation failed\n");
+            result = OSAL_NOMEM;
+        }
+        else
+        {
+            result = OSAL_semaphore_init(semaphore, name, initial_count, 0, handle);
+            if (OSAL_OK != result)
+            {
+                free(semaphore);
+            }
+        }
+    }
+    return result;
+}
+#endif // OSAL_NO_DYNAMIC_ALLOCATION
+
+/**
+ * @brief Create an OS counter semaphore in a storage declared with OSAL_counter_semaphore_storage_declare(). Does not allocate memory.
+ *
+ * @param[in] name counter semaphore name
+ * @param[in] initial_count counter semaphore initial count value
+ * @param[in] max_count counter semaphore maximum count value
+ * @param[in] storage counter semaphore storage
+ * @param[in,out] handle pointer on a counter semaphore handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_counter_semaphore_create_static(uint8_t *name, uint32_t initial_count, uint32_t max_count, OSAL_semaphore_storage_t *storage, OSAL_counter_semaphore_handle_t *handle)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    if ((NULL == handle) || (NULL == storage))
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        result = OSAL_semaphore_init(storage, name, initial_count, 1, handle);
+    }
+    return result;
+}
+
+/**
+ * @brief Delete an OS counter semaphore.
+ *
+ * @param[in] handle pointer on the counter semaphore handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_counter_semaphore_delete(OSAL_counter_semaphore_handle_t *handle)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    if (NULL == handle)
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        OSAL_semaphore_storage_t *semaphore = (OSAL_semaphore_storage_t *)*handle;
+#ifdef OSAL_INSTRUMENTATION
+        OSAL_stats_unregister(&semaphore->stats);
+#endif
+        if (-1 != sem_destroy(&semaphore->sem))
+        {
+            result = OSAL_OK;
+        }
+#ifndef OSAL_NO_DYNAMIC_ALLOCATION
+        if (0 == semaphore->is_static)
+        {
+            free(semaphore);
+        }
+#endif
+    }
+    return result;
+}
+
+/**
+ * @brief Take operation on OS counter semaphore. Block the current task until counter semaphore
+ * become available or timeout occurred. Decrease the counter semaphore count value by 1 and
+ * block the current task if count value equals to 0.
+ *
+ * @param[in] handle pointer on the counter semaphore handle
+ * @param[in] timeout maximum time to wait until the counter semaphore become available
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_counter_semaphore_take(OSAL_counter_semaphore_handle_t *handle, uint32_t timeout)
+{
+    OSAL_status_t result = OSAL_ERROR;
+    struct timespec ts;
+
+    if (NULL == handle)
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        OSAL_semaphore_storage_t *semaphore = (OSAL_semaphore_storage_t *)*handle;
+#ifdef OSAL_INSTRUMENTATION
+        uint32_t wait_start = OSAL_stats_time_us();
+        bool contended = (0 != sem_trywait(&semaphore->sem));
+        if (!contended)
+        {
+            result = OSAL_OK;
+        }
+#endif
+#ifdef OSAL_SPIN_SUPPORTED
+        if ((OSAL_OK != result) && (0 != semaphore->spin_budget) && OSAL_spin_try(OSAL_spin_try_semaphore, &semaphore->sem, semaphore->spin_budget))
+        {
+            result = OSAL_OK;
+        }
+#endif
+        if ((OSAL_OK != result) && (OSAL_OK == OSAL_add_milliseconds_to_posix_current_time(timeout, &ts)))
+        {
+            if (-1 != sem_timedwait(&semaphore->sem, &ts))
+            {
+                result = OSAL_OK;
+            }
+        }
+#ifdef OSAL_INSTRUMENTATION
+        if (OSAL_OK == result)
+        {
+            OSAL_stats_acquired(&semaphore->stats, wait_start, contended);
+        }
+#endif
+    }
+    return result;
+}
+
+/**
+ * @brief Give operation on OS counter semaphore. Increase the counter semaphore count value by 1 and unblock the current task if count value.
  * equals to 0.
  *
+ * @param[in] handle pointer on the counter semaphore handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_counter_semaphore_give(OSAL_counter_semaphore_handle_t *handle)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    if (NULL == handle)
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        if (-1 != sem_post(&((OSAL_semaphore_storage_t *)*handle)->sem))
+        {
+            result = OSAL_OK;
+        }
+    }
+    return result;
+}
+
+#ifndef OSAL_NO_DYNAMIC_ALLOCATION
+/**
+ * @brief Create an OS binary semaphore with a semaphore count initial value (0 or 1).
+ *
+ * @param[in] name counter semaphore name
+ * @param[in] initial_count counter semaphore initial count value
+ * @param[in,out] handle pointer on a binary semaphore handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_binary_semaphore_create(uint8_t *name, uint32_t initial_count, OSAL_binary_semaphore_handle_t *handle)
+{
+    return OSAL_counter_semaphore_create(name, (0 == initial_count) ? 0 : 1, 1, handle);
+}
+#endif // OSAL_NO_DYNAMIC_ALLOCATION
+
+/**
+ * @brief Create an OS binary semaphore in a storage declared with OSAL_binary_semaphore_storage_declare(). Does not allocate memory.
+ *
+ * @param[in] name binary semaphore name
+ * @param[in] initial_count binary semaphore initial count value
+ * @param[in] storage binary semaphore storage
+ * @param[in,out] handle pointer on a binary semaphore handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_binary_semaphore_create_static(uint8_t *name, uint32_t initial_count, OSAL_semaphore_storage_t *storage, OSAL_binary_semaphore_handle_t *handle)
+{
+    return OSAL_counter_semaphore_create_static(name, (0 == initial_count) ? 0 : 1, 1, storage, handle);
+}
+
+/**
+ * @brief Delete an OS binary semaphore.
+ *
  * @param[in] handle pointer on the binary semaphore handle
  *
  * @return operation status (@see OSAL_status_t)
  */
-OSAL_status_t OSAL_binary_semaphore_give(OSAL_binary_semaphore_handle_t *handle)
+OSAL_status_t OSAL_binary_semaphore_delete(OSAL_binary_semaphore_handle_t *handle)
 {
-    return OSAL_counter_semaphore_give(handle);
+    return OSAL_counter_semaphore_delete(handle);
+}
+
+/**
+ * @brief Take operation on OS binary semaphore. Block the current task until binary semaphore
+ * become available or timeout occurred. Decrease the binary semaphore count value by 1 and
+ * block the current task if count value equals to 0.
+ *
+ * @param[in] handle pointer on the binary semaphore handle
+ * @param[in] timeout maximum time to wait until the binary semaphore become available
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_binary_semaphore_take(OSAL_binary_semaphore_handle_t *handle, uint32_t timeout)
+{
+    return OSAL_counter_semaphore_take(handle, timeout);
+}
+
+/**
+ * @brief Give operation on OS binary semaphore. Increase the binary semaphore count value by 1 and unblock the current task if count value.
+ * equals to 0.
+ *
+ * @param[in] handle pointer on the binary semaphore handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_binary_semaphore_give(OSAL_binary_semaphore_handle_t *handle)
+{
+    return OSAL_counter_semaphore_give(handle);
+}
+
+/**
+ * @brief Make the takes of an OS binary semaphore busy-wait for the semaphore before blocking, retrying with an
+ * exponential backoff. Spinning avoids a sleep and wake-up cycle when the semaphore is given by a task running on
+ * another CPU within a few microseconds.
+ *
+ * @param[in] handle pointer on the binary semaphore handle
+ * @param[in] spin_budget number of busy-wait iterations before blocking, 0 to block immediately (default OSAL_SPIN_BUDGET_DEFAULT)
+ *
+ * @return operation status (@see OSAL_status_t), OSAL_NOT_IMPLEMENTED on single CPU builds where spinning cannot help
+ */
+OSAL_status_t OSAL_binary_semaphore_set_spin_budget(OSAL_binary_semaphore_handle_t *handle, uint32_t spin_budget)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    if (NULL == handle)
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+#ifdef OSAL_SPIN_SUPPORTED
+        ((OSAL_semaphore_storage_t *)*handle)->spin_budget = spin_budget;
+        result = OSAL_OK;
+#else
+        result = OSAL_NOT_IMPLEMENTED;
+#endif
+    }
+    return result;
+}
+
+#ifndef OSAL_NO_DYNAMIC_ALLOCATION
+/**
+ * @brief Create an OS mutex.
+ *
+ * @param[in] name mutex name
+ * @param[in,out] handle pointer on a mutex handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_mutex_create(uint8_t *name, OSAL_mutex_handle_t *handle)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    if (NULL == handle)
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        OSAL_mutex_storage_t *mutex = malloc(sizeof(OSAL_mutex_storage_t));
+        if (NULL == mutex)
+        {
+            printf("[ERROR] OSAL mutex memory allocation failed\n");
+            result = OSAL_NOMEM;
+        }
+        else
+        {
+            result = OSAL_mutex_init(mutex, name, 0, handle);
+            if (OSAL_OK != result)
+            {
+                free(mutex);
+            }
+        }
+    }
+    return result;
+}
+#endif // OSAL_NO_DYNAMIC_ALLOCATION
+
+/**
+ * @brief Create an OS mutex in a storage declared with OSAL_mutex_storage_declare(). Does not allocate memory.
+ *
+ * @param[in] name mutex name
+ * @param[in] storage mutex storage
+ * @param[in,out] handle pointer on a mutex handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_mutex_create_static(uint8_t *name, OSAL_mutex_storage_t *storage, OSAL_mutex_handle_t *handle)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    if ((NULL == handle) || (NULL == storage))
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        result = OSAL_mutex_init(storage, name, 1, handle);
+    }
+    return result;
+}
+
+/**
+ * @brief Delete an OS mutex.
+ *
+ * @param[in] handle pointer on the mutex handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_mutex_delete(OSAL_mutex_handle_t *handle)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    if (NULL == handle)
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        OSAL_mutex_storage_t *mutex = (OSAL_mutex_storage_t *)*handle;
+#ifdef OSAL_INSTRUMENTATION
+        OSAL_stats_unregister(&mutex->stats);
+#endif
+        if (0 == pthread_mutex_destroy(&mutex->mutex))
+        {
+            result = OSAL_OK;
+        }
+#ifndef OSAL_NO_DYNAMIC_ALLOCATION
+        if (0 == mutex->is_static)
+        {
+            free(mutex);
+        }
+#endif
+    }
+    return result;
+}
+
+/**
+ * @brief Take operation on OS mutex.
+ *
+ * @param[in] handle pointer on the mutex handle
+ * @param[in] timeout maximum time to wait until the mutex become available
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_mutex_take(OSAL_mutex_handle_t *handle, uint32_t timeout)
+{
+    OSAL_status_t result = OSAL_ERROR;
+    struct timespec ts;
+
+    if (NULL == handle)
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        pthread_mutex_t *pthread_mutex = &((OSAL_mutex_storage_t *)*handle)->mutex;
+#ifdef OSAL_SPIN_SUPPORTED
+        uint32_t spin_budget = ((OSAL_mutex_storage_t *)*handle)->spin_budget;
+#endif
+#ifdef OSAL_INSTRUMENTATION
+        uint32_t wait_start = OSAL_stats_time_us();
+        bool contended = (0 != pthread_mutex_trylock(pthread_mutex));
+        if (!contended)
+        {
+            result = OSAL_OK;
+        }
+        else
+#endif
+#ifdef OSAL_SPIN_SUPPORTED
+        if ((0 != spin_budget) && OSAL_spin_try(OSAL_spin_try_mutex, pthread_mutex, spin_budget))
+        {
+            result = OSAL_OK;
+        }
+        else
+#endif
+        if (OSAL_INFINITE_TIME != timeout)
+        {
+            if (OSAL_OK == OSAL_add_milliseconds_to_posix_current_time(timeout, &ts))
+            {
+                if (0 == pthread_mutex_timedlock(pthread_mutex, &ts))
+                {
+                    result = OSAL_OK;
+                }
+            }
+        }
+        else
+        {
+            // Infinite timeout
+            if (0 == pthread_mutex_lock(pthread_mutex))
+            {
+                result = OSAL_OK;
+            }
+        }
+#ifdef OSAL_INSTRUMENTATION
+        if (OSAL_OK == result)
+        {
+            OSAL_stats_acquired(&((OSAL_mutex_storage_t *)*handle)->stats, wait_start, contended);
+        }
+#endif
+    }
+    return result;
+}
+
+/**
+ * @brief Give operation on OS mutex.
+ *
+ * @param[in] handle pointer on the mutex handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_mutex_give(OSAL_mutex_handle_t *handle)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    if (NULL == handle)
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        pthread_mutex_t *pthread_mutex = &((OSAL_mutex_storage_t *)*handle)->mutex;
+#ifdef OSAL_INSTRUMENTATION
+        // recorded before unlocking, while this task is still the holder
+        OSAL_stats_released(&((OSAL_mutex_storage_t *)*handle)->stats);
+#endif
+        if (0 == pthread_mutex_unlock(pthread_mutex))
+        {
+            result = OSAL_OK;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Make the takes of an OS mutex busy-wait for the mutex before blocking, retrying with an exponential backoff.
+ * Spinning avoids a sleep and wake-up cycle when the mutex is held by a task running on another CPU for a few microseconds.
+ *
+ * @param[in] handle pointer on the mutex handle
+ * @param[in] spin_budget number of busy-wait iterations before blocking, 0 to block immediately (default OSAL_SPIN_BUDGET_DEFAULT)
+ *
+ * @return operation status (@see OSAL_status_t), OSAL_NOT_IMPLEMENTED on single CPU builds where spinning cannot help
+ */
+OSAL_status_t OSAL_mutex_set_spin_budget(OSAL_mutex_handle_t *handle, uint32_t spin_budget)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    if (NULL == handle)
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+#ifdef OSAL_SPIN_SUPPORTED
+        ((OSAL_mutex_storage_t *)*handle)->spin_budget = spin_budget;
+        result = OSAL_OK;
+#else
+        result = OSAL_NOT_IMPLEMENTED;
+#endif
+    }
+    return result;
+}
+
+#ifndef OSAL_NO_DYNAMIC_ALLOCATION
+/**
+ * @brief Create an OS reader-writer lock. Several readers may hold the lock at the same time, a writer holds it alone.
+ *
+ * @param[in] name reader-writer lock name
+ * @param[in,out] handle pointer on a reader-writer lock handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_rwlock_create(uint8_t *name, OSAL_rwlock_handle_t *handle)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    if (NULL == handle)
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        OSAL_rwlock_storage_t *rwlock = malloc(sizeof(OSAL_rwlock_storage_t));
+        if (NULL == rwlock)
+        {
+            printf("[ERROR] OSAL rwlock memory allocation failed\n");
+            result = OSAL_NOMEM;
+        }
+        else
+        {
+            rwlock->is_static = 0;
+            result = OSAL_rwlock_init(rwlock, handle);
+            if (OSAL_OK != result)
+            {
+                free(rwlock);
+            }
+        }
+    }
+    return result;
+}
+#endif // OSAL_NO_DYNAMIC_ALLOCATION
+
+/**
+ * @brief Create an OS reader-writer lock in a storage declared with OSAL_rwlock_storage_declare(). Does not allocate memory.
+ *
+ * @param[in] name reader-writer lock name
+ * @param[in] storage reader-writer lock storage
+ * @param[in,out] handle pointer on a reader-writer lock handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_rwlock_create_static(uint8_t *name, OSAL_rwlock_storage_t *storage, OSAL_rwlock_handle_t *handle)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    if ((NULL == handle) || (NULL == storage))
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        storage->is_static = 1;
+        result = OSAL_rwlock_init(storage, handle);
+    }
+    return result;
+}
+
+/**
+ * @brief Delete an OS reader-writer lock.
+ *
+ * @param[in] handle pointer on the reader-writer lock handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_rwlock_delete(OSAL_rwlock_handle_t *handle)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    if (NULL == handle)
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        OSAL_rwlock_storage_t *rwlock = (OSAL_rwlock_storage_t *)*handle;
+        if (0 == pthread_rwlock_destroy(&rwlock->rwlock))
+        {
+            result = OSAL_OK;
+        }
+#ifndef OSAL_NO_DYNAMIC_ALLOCATION
+        if (0 == rwlock->is_static)
+        {
+            free(rwlock);
+        }
+#endif
+    }
+    return result;
+}
+
+/**
+ * @brief Take an OS reader-writer lock for reading. Does not wait for the other readers, only for a writer.
+ *
+ * @param[in] handle pointer on the reader-writer lock handle
+ * @param[in] timeout maximum time to wait until the lock become available, OSAL_INFINITE_TIME for infinite timeout
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_rwlock_read_take(OSAL_rwlock_handle_t *handle, uint32_t timeout)
+{
+    OSAL_status_t result = OSAL_ERROR;
+    struct timespec absolute_time;
+
+    if (NULL == handle)
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        pthread_rwlock_t *pthread_rwlock = &((OSAL_rwlock_storage_t *)*handle)->rwlock;
+        if (OSAL_INFINITE_TIME == timeout)
+        {
+            if (0 == pthread_rwlock_rdlock(pthread_rwlock))
+            {
+                result = OSAL_OK;
+            }
+        }
+        else if (OSAL_OK == OSAL_add_milliseconds_to_posix_current_time(timeout, &absolute_time))
+        {
+            if (0 == pthread_rwlock_timedrdlock(pthread_rwlock, &absolute_time))
+            {
+                result = OSAL_OK;
+            }
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Take an OS reader-writer lock for writing. Waits until there is no reader and no writer.
+ *
+ * @param[in] handle pointer on the reader-writer lock handle
+ * @param[in] timeout maximum time to wait until the lock become available, OSAL_INFINITE_TIME for infinite timeout
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_rwlock_write_take(OSAL_rwlock_handle_t *handle, uint32_t timeout)
+{
+    OSAL_status_t result = OSAL_ERROR;
+    struct timespec absolute_time;
+
+    if (NULL == handle)
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        pthread_rwlock_t *pthread_rwlock = &((OSAL_rwlock_storage_t *)*handle)->rwlock;
+        if (OSAL_INFINITE_TIME == timeout)
+        {
+            if (0 == pthread_rwlock_wrlock(pthread_rwlock))
+            {
+                result = OSAL_OK;
+            }
+        }
+        else if (OSAL_OK == OSAL_add_milliseconds_to_posix_current_time(timeout, &absolute_time))
+        {
+            if (0 == pthread_rwlock_timedwrlock(pthread_rwlock, &absolute_time))
+            {
+                result = OSAL_OK;
+            }
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Give an OS reader-writer lock taken for reading or for writing.
+ *
+ * @param[in] handle pointer on the reader-writer lock handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_rwlock_give(OSAL_rwlock_handle_t *handle)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    if (NULL == handle)
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        if (0 == pthread_rwlock_unlock(&((OSAL_rwlock_storage_t *)*handle)->rwlock))
+        {
+            result = OSAL_OK;
+        }
+    }
+    return result;
+}
+
+#ifndef OSAL_NO_DYNAMIC_ALLOCATION
+/**
+ * @brief Create an OS event group. All the event bits are cleared.
+ *
+ * @param[in] name event group name
+ * @param[in,out] handle pointer on an event group handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_event_group_create(uint8_t *name, OSAL_event_group_handle_t *handle)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    if (NULL == handle)
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        OSAL_event_group_storage_t *event_group = malloc(sizeof(OSAL_event_group_storage_t));
+        if (NULL == event_group)
+        {
+            printf("[ERROR] OSAL event group memory allocation failed\n");
+            result = OSAL_NOMEM;
+        }
+        else
+        {
+            result = OSAL_event_group_init(event_group, 0, handle);
+            if (OSAL_OK != result)
+            {
+                free(event_group);
+            }
+        }
+    }
+    return result;
+}
+#endif // OSAL_NO_DYNAMIC_ALLOCATION
+
+/**
+ * @brief Create an OS event group in a storage declared with OSAL_event_group_storage_declare(). Does not allocate memory.
+ * All the event bits are cleared.
+ *
+ * @param[in] name event group name
+ * @param[in] storage event group storage
+ * @param[in,out] handle pointer on an event group handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_event_group_create_static(uint8_t *name, OSAL_event_group_storage_t *storage, OSAL_event_group_handle_t *handle)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    if ((NULL == handle) || (NULL == storage))
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        result = OSAL_event_group_init(storage, 1, handle);
+    }
+    return result;
+}
+
+/**
+ * @brief Delete an OS event group.
+ *
+ * @param[in] handle pointer on the event group handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_event_group_delete(OSAL_event_group_handle_t *handle)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    if (NULL == handle)
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        OSAL_event_group_storage_t *event_group = (OSAL_event_group_storage_t *)*handle;
+
+        if ((0 == pthread_mutex_destroy(&(event_group->mutex))) && (0 == pthread_cond_destroy(&(event_group->condition))))
+        {
+            result = OSAL_OK;
+        }
+#ifndef OSAL_NO_DYNAMIC_ALLOCATION
+        if (0 == event_group->is_static)
+        {
+            free(event_group);
+        }
+#endif
+    }
+    return result;
+}
+
+/**
+ * @brief Set event bits and wake up the tasks whose wait condition is met.
+ *
+ * @param[in] handle pointer on the event group handle
+ * @param[in] bits bits to set
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_event_group_set(OSAL_event_group_handle_t *handle, uint32_t bits)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    if (NULL == handle)
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        OSAL_event_group_storage_t *event_group = (OSAL_event_group_storage_t *)*handle;
+
+        pthread_mutex_lock(&(event_group->mutex));
+        if ((event_group->bits | bits) != event_group->bits)
+        {
+            event_group->bits |= bits;
+            // the waiters may wait for different bits: each one checks its own condition
+            pthread_cond_broadcast(&(event_group->condition));
+        }
+        pthread_mutex_unlock(&(event_group->mutex));
+        result = OSAL_OK;
+    }
+    return result;
+}
+
+/**
+ * @brief Clear event bits.
+ *
+ * @param[in] handle pointer on the event group handle
+ * @param[in] bits bits to clear
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_event_group_clear(OSAL_event_group_handle_t *handle, uint32_t bits)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    if (NULL == handle)
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        OSAL_event_group_storage_t *event_group = (OSAL_event_group_storage_t *)*handle;
+
+        pthread_mutex_lock(&(event_group->mutex));
+        event_group->bits &= ~bits;
+        pthread_mutex_unlock(&(event_group->mutex));
+        result = OSAL_OK;
+    }
+    return result;
+}
+
+/**
+ * @brief Block the current task until one (OSAL_EVENT_GROUP_WAIT_ANY) or all (OSAL_EVENT_GROUP_WAIT_ALL) of the given
+ * bits are set, or a timeout occurred.
+ *
+ * @param[in] handle pointer on the event group handle
+ * @param[in] bits bits to wait for. Must not be 0.
+ * @param[in] options combination of OSAL_event_group_options_t values
+ * @param[out] set_bits event bits when the wait ended, before they are cleared by OSAL_EVENT_GROUP_CLEAR_ON_EXIT. May be NULL.
+ * @param[in] timeout maximum time to wait, OSAL_INFINITE_TIME for infinite timeout
+ *
+ * @return operation status (@see OSAL_status_t), OSAL_ERROR on timeout
+ */
+OSAL_status_t OSAL_event_group_wait(OSAL_event_group_handle_t *handle, uint32_t bits, uint32_t options, uint32_t *set_bits, uint32_t timeout)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    if ((NULL == handle) || (0 == bits))
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        OSAL_event_group_storage_t *event_group = (OSAL_event_group_storage_t *)*handle;
+        bool wait_all = (0 != (options & OSAL_EVENT_GROUP_WAIT_ALL));
+        struct timespec absolute_time_result;
+        int32_t wait_result = 0;
+
+        if ((OSAL_INFINITE_TIME != timeout) && (OSAL_OK != OSAL_add_milliseconds_to_posix_current_time(timeout, &absolute_time_result)))
+        {
+            return OSAL_ERROR;
+        }
+
+        pthread_mutex_lock(&(event_group->mutex));
+        while (1)
+        {
+            uint32_t matching_bits = event_group->bits & bits;
+            if (wait_all ? (bits == matching_bits) : (0 != matching_bits))
+            {
+                result = OSAL_OK;
+                break;
+            }
+            if (0 != wait_result)
+            {
+                // timeout
+                break;
+            }
+
+            if (OSAL_INFINITE_TIME == timeout)
+            {
+                wait_result = pthread_cond_wait(&(event_group->condition), &(event_group->mutex));
+            }
+            else
+            {
+                wait_result = pthread_cond_timedwait(&(event_group->condition), &(event_group->mutex), &absolute_time_result);
+            }
+        }
+
+        if (NULL != set_bits)
+        {
+            *set_bits = event_group->bits;
+        }
+        if ((OSAL_OK == result) && (0 != (options & OSAL_EVENT_GROUP_CLEAR_ON_EXIT)))
+        {
+            event_group->bits &= ~bits;
+        }
+        pthread_mutex_unlock(&(event_group->mutex));
+    }
+    return result;
 }
 
 /**
- * @brief Create an OS mutex.
- *
- * @param[in] name mutex name
- * @param[in,out] handle pointer on a mutex handle
+ * @brief Disable the OS scheduler context switching. Prevent the OS from
+ * scheduling other tasks than the current one until #OSAL_enable_context_switching is called.
+ * Calls may be nested by the same task: the context switching is enabled again by its outermost
+ * #OSAL_enable_context_switching. Interrupts are still served. Must not be called from an interrupt.
  *
- * @return operation status (@see OSAL_status_t)
+ * @return operation status (@see OSAL_status_t), OSAL_ERROR if called from an interrupt
  */
-OSAL_status_t OSAL_mutex_create(uint8_t *name, OSAL_mutex_handle_t *handle)
+OSAL_status_t OSAL_disable_context_switching(void)
 {
     OSAL_status_t result = OSAL_ERROR;
-    pthread_mutex_t *mutex = malloc(sizeof(pthread_mutex_t));
 
-    if (NULL == handle)
+#ifdef __NuttX__
+    // sched_lock() from an interrupt would lock the interrupted task
+    if (!up_interrupt_context() && (OK == sched_lock()))
     {
-        result = OSAL_WRONG_ARGS;
+#ifdef OSAL_CRITICAL_SECTION_MAX_US
+        if (1 == sched_lockcount())
+        {
+            OSAL_context_switching_disable_start[OSAL_CPU_INDEX()] = OSAL_critical_section_time_us();
+        }
+#endif
+        result = OSAL_OK;
     }
-    else
+#else
+    // no scheduler lock on the host: the critical sections only exclude each other
+    pthread_once(&OSAL_context_switching_once, OSAL_context_switching_host_init);
+    if (0 == pthread_mutex_lock(&OSAL_context_switching_host_mutex))
     {
-        if (0 == pthread_mutex_init(mutex, NULL))
+        OSAL_context_switching_disable_count++;
+#ifdef OSAL_CRITICAL_SECTION_MAX_US
+        if (1 == OSAL_context_switching_disable_count)
         {
-            *handle = mutex;
-            result = OSAL_OK;
+            OSAL_context_switching_disable_start = OSAL_critical_section_time_us();
         }
+#endif
+        result = OSAL_OK;
     }
+#endif
+
     return result;
 }
 
 /**
- * @brief Delete an OS mutex.
- *
- * @param[in] handle pointer on the mutex handle
+ * @brief Reenable the OS scheduling that was disabled by #OSAL_disable_context_switching.
+ * Must be called by the task that disabled it, not from an interrupt.
  *
- * @return operation status (@see OSAL_status_t)
+ * @return operation status (@see OSAL_status_t), OSAL_ERROR if the context switching is not disabled by the current
+ * task
  */
-OSAL_status_t OSAL_mutex_delete(OSAL_mutex_handle_t *handle)
+OSAL_status_t OSAL_enable_context_switching(void)
 {
     OSAL_status_t result = OSAL_ERROR;
 
-    if (NULL == handle)
+#ifdef __NuttX__
+    if (!up_interrupt_context() && (0 < sched_lockcount()))
     {
-        result = OSAL_WRONG_ARGS;
-    }
-    else
+#ifdef OSAL_CRITICAL_SECTION_MAX_US
+        bool outermost = (1 == sched_lockcount());
+        uint32_t duration = OSAL_critical_section_time_us() - OSAL_context_switching_disable_start[OSAL_CPU_INDEX()];
+#endif
+        if (OK == sched_unlock())
+        {
+            result = OSAL_OK;
+        }
+#else
+    if (0 < OSAL_context_switching_disable_count)
     {
-        pthread_mutex_t *pthread_mutex = (pthread_mutex_t *)*handle;
-        if (0 == pthread_mutex_destroy(pthread_mutex))
+        // the current task owns the host mutex
+        OSAL_context_switching_disable_count--;
+#ifdef OSAL_CRITICAL_SECTION_MAX_US
+        bool outermost = (0 == OSAL_context_switching_disable_count);
+        uint32_t duration = OSAL_critical_section_time_us() - OSAL_context_switching_disable_start;
+#endif
+        if (0 == pthread_mutex_unlock(&OSAL_context_switching_host_mutex))
         {
             result = OSAL_OK;
         }
-        free(*handle);
+#endif
+#ifdef OSAL_CRITICAL_SECTION_MAX_US
+        if (outermost)
+        {
+            OSAL_critical_section_end(duration);
+        }
+#endif
     }
+
     return result;
 }
 
 /**
- * @brief Take operation on OS mutex.
+ * @brief Enter a critical section protected by a spinlock. The interrupts of the current CPU are disabled until
+ * #OSAL_spinlock_give is called, and the tasks running on the other CPUs busy-wait to take the same spinlock.
+ * Must only protect a few instructions. Spinlocks must not be nested.
  *
- * @param[in] handle pointer on the mutex handle
- * @param[in] timeout maximum time to wait until the mutex become available
+ * @param[in] lock spinlock initialized with OSAL_SPINLOCK_INITIALIZER
  *
  * @return operation status (@see OSAL_status_t)
  */
-OSAL_status_t OSAL_mutex_take(OSAL_mutex_handle_t *handle, uint32_t timeout)
+OSAL_status_t OSAL_spinlock_take(OSAL_spinlock_t *lock)
 {
     OSAL_status_t result = OSAL_ERROR;
-    struct timespec ts;
-    struct timespec ts_start;
 
-    if (NULL == handle)
+    if (NULL == lock)
     {
         result = OSAL_WRONG_ARGS;
     }
     else
     {
-        pthread_mutex_t *pthread_mutex = (pthread_mutex_t *)*handle;
-        if (-1 != timeout)
+#ifdef __NuttX__
+        // the holder cannot be interrupted or preempted on its CPU, so the other CPUs only spin a few instructions
+        irqstate_t irq_state = up_irq_save();
+        while (__atomic_test_and_set(&lock->locked, __ATOMIC_ACQUIRE))
         {
-            if (-1 != clock_gettime(CLOCK_REALTIME, &ts_start))
-            {
-                ts.tv_nsec += timeout * 1000 * 1000;
-                if (0 == pthread_mutex_timedlock(pthread_mutex, &ts))
-                {
-                    result = OSAL_OK;
-                }
-            }
+            // spin
         }
-        else
+        lock->irq_state = (uint32_t)irq_state;
+#else
+        // the host cannot disable the preemption: let the holder run
+        while (__atomic_test_and_set(&lock->locked, __ATOMIC_ACQUIRE))
         {
-            // Infinite timeout
-            if (0 == pthread_mutex_lock(pthread_mutex))
-            {
-                result = OSAL_OK;
-            }
+            sched_yield();
         }
+#endif
+#ifdef OSAL_CRITICAL_SECTION_MAX_US
+        lock->start = OSAL_critical_section_time_us();
+#endif
+        result = OSAL_OK;
     }
+
     return result;
 }
 
 /**
- * @brief Give operation on OS mutex.
+ * @brief Leave a critical section entered with #OSAL_spinlock_take.
  *
- * @param[in] handle pointer on the mutex handle
+ * @param[in] lock spinlock taken by the current task
  *
  * @return operation status (@see OSAL_status_t)
  */
-OSAL_status_t OSAL_mutex_give(OSAL_mutex_handle_t *handle)
+OSAL_status_t OSAL_spinlock_give(OSAL_spinlock_t *lock)
 {
     OSAL_status_t result = OSAL_ERROR;
 
-    if (NULL == handle)
+    if (NULL == lock)
     {
         result = OSAL_WRONG_ARGS;
     }
     else
     {
-        pthread_mutex_t *pthread_mutex = (pthread_mutex_t *)*handle;
-        if (0 == pthread_mutex_unlock(pthread_mutex))
-        {
-            result = OSAL_OK;
-        }
+#ifdef OSAL_CRITICAL_SECTION_MAX_US
+        uint32_t duration = OSAL_critical_section_time_us() - lock->start;
+#endif
+#ifdef __NuttX__
+        irqstate_t irq_state = (irqstate_t)lock->irq_state;
+        __atomic_clear(&lock->locked, __ATOMIC_RELEASE);
+        up_irq_restore(irq_state);
+#else
+        __atomic_clear(&lock->locked, __ATOMIC_RELEASE);
+#endif
+#ifdef OSAL_CRITICAL_SECTION_MAX_US
+        OSAL_critical_section_end(duration);
+#endif
+        result = OSAL_OK;
     }
 
     return result;
 }
 
 /**
- * @brief Disable the OS scheduler context switching. Prevent the OS from
- * scheduling the current thread calling #OSAL_disable_context_switching while
- * the OS scheduling is already disable has an undefined behavior. This method
- * may be called from an interrupt.
+ * @brief Get the critical sections, context switching disabled or spinlock held, that lasted longer than
+ * OSAL_CRITICAL_SECTION_MAX_US since the startup.
  *
- * @return operation status (@see OSAL_status_t)
- */
-OSAL_status_t OSAL_disable_context_switching(void)
-{
-    // TODO
-    return OSAL_OK;
-}
-
-/**
- * @brief Reenable the OS scheduling that was disabled by #OSAL_disable_context_switching.
- * This method may be called from an interrupt.
+ * @param[out] overruns number of critical sections longer than OSAL_CRITICAL_SECTION_MAX_US
+ * @param[out] max_duration_us duration of the longest of them in microseconds
  *
- * @return operation status (@see OSAL_status_t)
+ * @return operation status (@see OSAL_status_t), OSAL_NOT_IMPLEMENTED if OSAL_CRITICAL_SECTION_MAX_US is not defined
  */
-OSAL_status_t OSAL_enable_context_switching(void)
+OSAL_status_t OSAL_get_critical_section_overruns(uint32_t *overruns, uint32_t *max_duration_us)
 {
-    // TODO
-    return OSAL_OK;
+#ifdef OSAL_CRITICAL_SECTION_MAX_US
+    OSAL_status_t result = OSAL_WRONG_ARGS;
+
+    if ((NULL != overruns) && (NULL != max_duration_us))
+    {
+        *overruns = __atomic_load_n(&OSAL_critical_section_overruns, __ATOMIC_RELAXED);
+        *max_duration_us = __atomic_load_n(&OSAL_critical_section_max_duration, __ATOMIC_RELAXED);
+        result = OSAL_OK;
+    }
+
+    return result;
+#else
+    (void)overruns;
+    (void)max_duration_us;
+    return OSAL_NOT_IMPLEMENTED;
+#endif
 }
 
 /**
@@ -709,116 +2135,324 @@ OSAL_status_t OSAL_sleep(uint32_t milliseconds)
     return result;
 }
 
-static OSAL_status_t OSAL_linked_list_initialize(osal_linked_list_t *linked_list)
+/**
+ * @brief Get the time elapsed since an unspecified origin, not affected by the changes of the system date.
+ * The value wraps around every 49 days: compare two times by the sign of their difference.
+ *
+ * @param[out] milliseconds the current time in milliseconds
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_get_time_ms(uint32_t *milliseconds)
 {
     OSAL_status_t result = OSAL_ERROR;
+    struct timespec now;
 
-    if (NULL == linked_list)
+    if (NULL == milliseconds)
     {
         result = OSAL_WRONG_ARGS;
     }
-    else
+    else if (0 == clock_gettime(CLOCK_MONOTONIC, &now))
     {
-        linked_list->size = 0;
-        linked_list->node = NULL;
+        *milliseconds = (uint32_t)((uint64_t)now.tv_sec * MILLISECONDS_IN_SECONDS + (uint64_t)now.tv_nsec / NANOSECONDS_IN_MILLISECONDS);
         result = OSAL_OK;
     }
 
     return result;
 }
 
-static OSAL_status_t OSAL_linked_list_add(osal_linked_list_t *linked_list, void *data)
+/**
+ * @brief Get the time elapsed since an unspecified origin, with a microsecond resolution, to measure short durations.
+ * The value wraps around every 71 minutes: compare two times by the sign of their difference.
+ *
+ * @param[out] microseconds the current time in microseconds
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_get_time_us(uint32_t *microseconds)
 {
     OSAL_status_t result = OSAL_ERROR;
+    struct timespec now;
 
-    if (NULL == linked_list)
+    if (NULL == microseconds)
     {
         result = OSAL_WRONG_ARGS;
     }
-    else
+    else if (0 == clock_gettime(CLOCK_MONOTONIC, &now))
+    {
+        *microseconds = (uint32_t)((uint64_t)now.tv_sec * MICROSECONDS_IN_SECONDS + (uint64_t)now.tv_nsec / NANOSECONDS_IN_MICROSECONDS);
+        result = OSAL_OK;
+    }
+
+    return result;
+}
+
+/*
+ * Store a message at the tail of the queue circular buffer.
+ * Must be called with the queue mutex locked and at least one free slot.
+ */
+static void OSAL_queue_buffer_put(osal_queue_t *queue, void *msg)
+{
+    int32_t tail = queue->head + queue->count;
+    if (tail >= queue->size)
+    {
+        tail -= queue->size;
+    }
+    queue->messages[tail] = msg;
+    ++queue->count;
+#ifdef OSAL_INSTRUMENTATION
+    OSAL_stats_queue_level(&queue->stats, queue->count);
+#endif
+}
+
+/*
+ * Remove and return the message at the head of the queue circular buffer.
+ * Must be called with the queue mutex locked and at least one message stored.
+ */
+static void *OSAL_queue_buffer_get(osal_queue_t *queue)
+{
+    void *msg = queue->messages[queue->head];
+    if (++queue->head >= queue->size)
+    {
+        queue->head = 0;
+    }
+    --queue->count;
+    return msg;
+}
+
+static OSAL_status_t OSAL_queue_init(osal_queue_t *queue, uint8_t *name, uint32_t size, uint8_t is_static, OSAL_queue_handle_t *handle)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    queue->name = name;
+    queue->selectors = NULL;
+    queue->size = (int32_t)size;
+    queue->count = 0;
+    queue->head = 0;
+    // the message slots are stored right after the queue structure
+    queue->messages = (void **)(queue + 1);
+    queue->is_static = is_static;
+
+    if (0 == pthread_mutex_init(&(queue->mutex), NULL))
     {
-        osal_linked_list_node_t *linked_list_node = malloc(sizeof(osal_linked_list_node_t));
-        if (NULL == linked_list_node)
+        if (0 == pthread_cond_init(&(queue->condition), NULL))
         {
-            int32_t errnum = errno;
-            if (ENOMEM == errnum)
-            {
-                result = OSAL_NOMEM;
-            }
-            printf("[ERROR] linked list add failed (%s)\n", strerror(errnum));
+#ifdef OSAL_INSTRUMENTATION
+            OSAL_stats_register(&queue->stats, name, OSAL_STATS_QUEUE);
+#endif
+            *handle = (OSAL_queue_handle_t)queue;
+            result = OSAL_OK;
         }
         else
         {
-            // initialize the new linked list node
-            linked_list_node->data = data;
-            linked_list_node->next = NULL;
+            pthread_mutex_destroy(&(queue->mutex));
+        }
+    }
 
-            if (NULL == linked_list->node)
-            {
-                linked_list->node = linked_list_node;
-            }
-            else
-            {
-                osal_linked_list_node_t *linked_list_node_tmp = linked_list->node;
-                // add the new node in the linked list
-                while (NULL != linked_list_node_tmp->next)
-                {
-                    linked_list_node_tmp = linked_list_node_tmp->next;
-                }
-                linked_list_node_tmp->next = linked_list_node;
-            }
+    return result;
+}
+
+static OSAL_status_t OSAL_prio_queue_init(OSAL_prio_queue_storage_t *prio_queue, uint8_t *name, uint32_t levels, OSAL_prio_queue_handle_t *handle)
+{
+    OSAL_status_t result = OSAL_ERROR;
 
-            // new data added, increase linked list size
-            ++linked_list->size;
+    for (uint32_t i = 0; i < OSAL_PRIO_QUEUE_MAX_LEVELS; i++)
+    {
+        prio_queue->heads[i] = NULL;
+        prio_queue->tails[i] = NULL;
+        prio_queue->skipped[i] = 0;
+    }
+    prio_queue->non_empty_levels = 0;
+    prio_queue->fairness_limit = 0;
+    prio_queue->levels = levels;
+    prio_queue->name = name;
 
+    if (0 == pthread_mutex_init(&(prio_queue->mutex), NULL))
+    {
+        if (0 == pthread_cond_init(&(prio_queue->condition), NULL))
+        {
+            *handle = (OSAL_prio_queue_handle_t)prio_queue;
             result = OSAL_OK;
         }
+        else
+        {
+            pthread_mutex_destroy(&(prio_queue->mutex));
+        }
     }
 
     return result;
 }
 
-static OSAL_status_t OSAL_linked_list_get(osal_linked_list_t *linked_list, void **data)
+/**
+ * @brief Select the level to fetch from a non-empty priority queue with a fairness guard, and update the skip counters.
+ * Must be called with the priority queue mutex held.
+ *
+ * @param[in] prio_queue the priority queue
+ * @param[in] highest the highest non-empty level
+ *
+ * @return the highest starved level if any, otherwise the highest non-empty level
+ */
+static uint32_t OSAL_prio_queue_fair_level(OSAL_prio_queue_storage_t *prio_queue, uint32_t highest)
 {
-    OSAL_status_t result = OSAL_ERROR;
+    uint32_t prio = highest;
+    uint32_t starved_levels = 0;
 
-    if ((NULL == linked_list) || (NULL == data))
+    for (uint32_t i = 0; i < highest; i++)
     {
-        result = OSAL_WRONG_ARGS;
+        if ((0 != (prio_queue->non_empty_levels & (1u << i))) && (prio_queue->fairness_limit <= prio_queue->skipped[i]))
+        {
+            starved_levels |= (1u << i);
+        }
     }
-    else
+    if (0 != starved_levels)
+    {
+        prio = 31 - __builtin_clz(starved_levels);
+    }
+
+    // the waiting levels below the served one are skipped once more
+    for (uint32_t i = 0; i < prio; i++)
     {
-        osal_linked_list_node_t *linked_list_node_tmp = linked_list->node;
-        if (NULL != linked_list_node_tmp)
+        if (0 != (prio_queue->non_empty_levels & (1u << i)))
         {
-            *data = linked_list_node_tmp->data;
-            linked_list->node = (linked_list->node)->next;
-            free(linked_list_node_tmp);
-            --linked_list->size;
-            result = OSAL_OK;
+            prio_queue->skipped[i]++;
         }
     }
+    prio_queue->skipped[prio] = 0;
+
+    return prio;
+}
+
+static OSAL_status_t OSAL_semaphore_init(OSAL_semaphore_storage_t *semaphore, uint8_t *name, uint32_t initial_count, uint8_t is_static, void **handle)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    semaphore->is_static = is_static;
+    semaphore->spin_budget = OSAL_SPIN_BUDGET_DEFAULT;
+    if (-1 != sem_init(&semaphore->sem, 0, initial_count))
+    {
+#ifdef OSAL_INSTRUMENTATION
+        OSAL_stats_register(&semaphore->stats, name, OSAL_STATS_SEMAPHORE);
+#endif
+        *handle = semaphore;
+        result = OSAL_OK;
+    }
 
     return result;
 }
 
-static OSAL_status_t OSAL_linked_list_size(osal_linked_list_t *linked_list, int32_t *size)
+static OSAL_status_t OSAL_mutex_init(OSAL_mutex_storage_t *mutex, uint8_t *name, uint8_t is_static, OSAL_mutex_handle_t *handle)
 {
     OSAL_status_t result = OSAL_ERROR;
 
-    if ((NULL == linked_list) || (NULL == size))
+    mutex->is_static = is_static;
+    mutex->spin_budget = OSAL_SPIN_BUDGET_DEFAULT;
+    if (0 == pthread_mutex_init(&mutex->mutex, NULL))
     {
-        result = OSAL_WRONG_ARGS;
+#ifdef OSAL_INSTRUMENTATION
+        OSAL_stats_register(&mutex->stats, name, OSAL_STATS_MUTEX);
+#endif
+        *handle = mutex;
+        result = OSAL_OK;
     }
-    else
+
+    return result;
+}
+
+static OSAL_status_t OSAL_rwlock_init(OSAL_rwlock_storage_t *rwlock, OSAL_rwlock_handle_t *handle)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    if (0 == pthread_rwlock_init(&rwlock->rwlock, NULL))
     {
-        *size = linked_list->size;
+        *handle = rwlock;
         result = OSAL_OK;
     }
 
     return result;
 }
 
+static OSAL_status_t OSAL_event_group_init(OSAL_event_group_storage_t *event_group, uint8_t is_static, OSAL_event_group_handle_t *handle)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    event_group->bits = 0;
+    event_group->is_static = is_static;
+
+    if (0 == pthread_mutex_init(&(event_group->mutex), NULL))
+    {
+        if (0 == pthread_cond_init(&(event_group->condition), NULL))
+        {
+            *handle = (OSAL_event_group_handle_t)event_group;
+            result = OSAL_OK;
+        }
+        else
+        {
+            pthread_mutex_destroy(&(event_group->mutex));
+        }
+    }
+
+    return result;
+}
+
+/*
+ * Wake up the tasks selecting the queue.
+ * Must be called with the queue mutex locked.
+ */
+static void OSAL_queue_notify_selectors(osal_queue_t *queue)
+{
+    for (osal_queue_select_node_t *node = queue->selectors; NULL != node; node = node->next)
+    {
+        sem_post(node->wakeup);
+    }
+}
+
+static void OSAL_queue_select_register(osal_queue_t *queue, osal_queue_select_node_t *node)
+{
+    pthread_mutex_lock(&(queue->mutex));
+    node->next = queue->selectors;
+    queue->selectors = node;
+    pthread_mutex_unlock(&(queue->mutex));
+}
+
+static void OSAL_queue_select_unregister(osal_queue_t *queue, osal_queue_select_node_t *node)
+{
+    pthread_mutex_lock(&(queue->mutex));
+    osal_queue_select_node_t **link = &queue->selectors;
+    while ((NULL != *link) && (node != *link))
+    {
+        link = &(*link)->next;
+    }
+    if (NULL != *link)
+    {
+        *link = node->next;
+    }
+    pthread_mutex_unlock(&(queue->mutex));
+}
+
+/*
+ * Use the explicit scheduling policy and the given priority instead of inheriting the creator ones.
+ */
+static void OSAL_task_set_sched_attr(pthread_attr_t *attr, int32_t priority)
+{
+    struct sched_param param;
+    int32_t min_priority = sched_get_priority_min(OSAL_TASK_SCHED_POLICY);
+    int32_t max_priority = sched_get_priority_max(OSAL_TASK_SCHED_POLICY);
+
+    if (priority < min_priority)
+    {
+        priority = min_priority;
+    }
+    else if (priority > max_priority)
+    {
+        priority = max_priority;
+    }
+
+    param.sched_priority = priority;
+    pthread_attr_setinheritsched(attr, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(attr, OSAL_TASK_SCHED_POLICY);
+    pthread_attr_setschedparam(attr, &param);
+}
+
 static OSAL_status_t OSAL_posix_current_time(struct timespec *time)
 {
     OSAL_status_t result = OSAL_ERROR;
@@ -906,3 +2540,73 @@ static OSAL_status_t OSAL_add_milliseconds_to_posix_current_time(uint32_t ms, st
 
     return result;
 }
+
+#ifdef OSAL_CRITICAL_SECTION_MAX_US
+static uint32_t OSAL_critical_section_time_us(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((now.tv_sec * 1000000) + (now.tv_nsec / 1000));
+}
+
+/*
+ * Count a critical section longer than OSAL_CRITICAL_SECTION_MAX_US. Called when the section ends, possibly with the
+ * interrupts of the CPU still disabled: never print from here.
+ */
+static void OSAL_critical_section_end(uint32_t duration)
+{
+    if (duration > OSAL_CRITICAL_SECTION_MAX_US)
+    {
+        __atomic_fetch_add(&OSAL_critical_section_overruns, 1, __ATOMIC_RELAXED);
+        uint32_t max = __atomic_load_n(&OSAL_critical_section_max_duration, __ATOMIC_RELAXED);
+        while ((duration > max) && !__atomic_compare_exchange_n(&OSAL_critical_section_max_duration, &max, duration, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        {
+            // max holds the new maximum
+        }
+    }
+}
+#endif
+
+#ifdef OSAL_SPIN_SUPPORTED
+/*
+ * Retry try_take with an exponential backoff until it succeeds or spin_budget busy-wait iterations are spent.
+ */
+static bool OSAL_spin_try(int (*try_take)(void *), void *primitive, uint32_t spin_budget)
+{
+    bool taken = false;
+    uint32_t backoff = 1;
+    uint32_t spent = 0;
+
+    while (!taken && (spent < spin_budget))
+    {
+        for (uint32_t i = 0; i < backoff; i++)
+        {
+#if defined(__arm__)
+            __asm__ volatile("yield");
+#elif defined(__i386__) || defined(__x86_64__)
+            __asm__ volatile("pause");
+#else
+            __asm__ volatile("" ::: "memory");
+#endif
+        }
+        spent += backoff;
+        taken = (0 == try_take(primitive));
+        if (backoff < OSAL_SPIN_MAX_BACKOFF)
+        {
+            backoff <<= 1;
+        }
+    }
+
+    return taken;
+}
+
+static int OSAL_spin_try_mutex(void *mutex)
+{
+    return pthread_mutex_trylock((pthread_mutex_t *)mutex);
+}
+
+static int OSAL_spin_try_semaphore(void *sem)
+{
+    return sem_trywait((sem_t *)sem);
+}
+#endif
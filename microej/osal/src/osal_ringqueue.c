@@ -0,0 +1,288 @@
+/*
+ * C
+ *
+ * Copyright 2019 IS2T. All rights reserved
+ * This library is provided in source code for use, modification and test, subject to license terms
+ * Any modification of the source code will break IS2T warranties on the whole library
+ */
+
+/**
+ * @file
+ * @brief OS Abstraction Layer lock-free ring queue implementation
+ * @author MicroEJ Developer Team
+ * @version 0.1.0
+ * @date 11 April 2018
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "osal.h"
+
+#ifdef OSAL_NO_DYNAMIC_ALLOCATION
+// any path reaching the heap fails to compile
+#pragma GCC poison malloc free
+#endif
+
+/*
+ * The MPSC variant is a bounded queue where each slot carries a sequence number: a producer reserves a slot
+ * by moving the tail index with a compare-and-swap, then publishes the message by updating the slot sequence.
+ * The consumer only reads a slot once its sequence says the message is published.
+ *
+ * The SPSC variant only needs the head and tail indexes: the producer owns the tail and the consumer owns the head.
+ *
+ * Head and tail are written by different tasks, they are placed on their own cache line.
+ */
+
+typedef OSAL_ringqueue_slot_t osal_ringqueue_slot_t;
+typedef OSAL_ringqueue_storage_t osal_ringqueue_t;
+
+static void OSAL_ringqueue_init(osal_ringqueue_t *ringqueue, uint8_t *name, uint32_t size, OSAL_ringqueue_type_t type, uint8_t is_static, OSAL_ringqueue_handle_t *handle);
+static bool OSAL_ringqueue_check_args(uint32_t size, OSAL_ringqueue_type_t type);
+
+#ifndef OSAL_NO_DYNAMIC_ALLOCATION
+/**
+ * @brief Create a lock-free ring queue with a fixed number of message slots.
+ *
+ * @param[in] name ring queue name
+ * @param[in] size number of message slots. Must be a power of 2 greater than 1.
+ * @param[in] type producer/consumer model
+ * @param[in,out] handle pointer on a ring queue handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_ringqueue_create(uint8_t *name, uint32_t size, OSAL_ringqueue_type_t type, OSAL_ringqueue_handle_t *handle)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    if ((NULL == handle) || !OSAL_ringqueue_check_args(size, type))
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        // the slots are allocated right after the ring queue structure
+        osal_ringqueue_t *ringqueue = malloc(sizeof(osal_ringqueue_t) + (size * sizeof(osal_ringqueue_slot_t)));
+        if (NULL == ringqueue)
+        {
+            printf("[ERROR] OSAL ring queue memory allocation failed\n");
+            result = OSAL_NOMEM;
+        }
+        else
+        {
+            OSAL_ringqueue_init(ringqueue, name, size, type, 0, handle);
+            result = OSAL_OK;
+        }
+    }
+
+    return result;
+}
+#endif // OSAL_NO_DYNAMIC_ALLOCATION
+
+/**
+ * @brief Create a lock-free ring queue in a storage declared with OSAL_ringqueue_storage_declare(). Does not allocate memory.
+ *
+ * @param[in] name ring queue name
+ * @param[in] size number of message slots. Must be the size given to OSAL_ringqueue_storage_declare(), a power of 2 greater than 1.
+ * @param[in] type producer/consumer model
+ * @param[in] storage ring queue storage, <code>&_name.ringqueue</code> where <code>_name</code> is the storage declared with OSAL_ringqueue_storage_declare()
+ * @param[in,out] handle pointer on a ring queue handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_ringqueue_create_static(uint8_t *name, uint32_t size, OSAL_ringqueue_type_t type, OSAL_ringqueue_storage_t *storage, OSAL_ringqueue_handle_t *handle)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    if ((NULL == handle) || (NULL == storage) || !OSAL_ringqueue_check_args(size, type))
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        OSAL_ringqueue_init(storage, name, size, type, 1, handle);
+        result = OSAL_OK;
+    }
+
+    return result;
+}
+
+/**
+ * @brief Delete a lock-free ring queue. The pending messages are discarded.
+ *
+ * @param[in] handle pointer on the ring queue handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_ringqueue_delete(OSAL_ringqueue_handle_t *handle)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    if (NULL == handle)
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+#ifndef OSAL_NO_DYNAMIC_ALLOCATION
+        if (0 == ((osal_ringqueue_t *)*handle)->is_static)
+        {
+            free(*handle);
+        }
+#endif
+        result = OSAL_OK;
+    }
+
+    return result;
+}
+
+/**
+ * @brief Post a message in a lock-free ring queue. Never blocks.
+ *
+ * @param[in] handle pointer on the ring queue handle
+ * @param[in] msg message to post in the ring queue
+ *
+ * @return operation status (@see OSAL_status_t), OSAL_NOMEM if all the slots are used
+ */
+OSAL_status_t OSAL_ringqueue_post(OSAL_ringqueue_handle_t *handle, void *msg)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    if (NULL == handle)
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        osal_ringqueue_t *ringqueue = (osal_ringqueue_t *)*handle;
+
+        if (OSAL_RINGQUEUE_SPSC == ringqueue->type)
+        {
+            uint32_t tail = ringqueue->tail;
+            uint32_t head = __atomic_load_n(&ringqueue->head, __ATOMIC_ACQUIRE);
+            if ((tail - head) > ringqueue->mask)
+            {
+                // ring queue full
+                result = OSAL_NOMEM;
+            }
+            else
+            {
+                ringqueue->slots[tail & ringqueue->mask].msg = msg;
+                __atomic_store_n(&ringqueue->tail, tail + 1, __ATOMIC_RELEASE);
+                result = OSAL_OK;
+            }
+        }
+        else
+        {
+            uint32_t tail = __atomic_load_n(&ringqueue->tail, __ATOMIC_RELAXED);
+            osal_ringqueue_slot_t *slot;
+
+            while (1)
+            {
+                slot = &ringqueue->slots[tail & ringqueue->mask];
+                int32_t diff = (int32_t)(__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) - tail);
+                if (0 == diff)
+                {
+                    // slot free: try to reserve it, on failure tail is reloaded with the current value
+                    if (__atomic_compare_exchange_n(&ringqueue->tail, &tail, tail + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                    {
+                        break;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    // slot still holds a message not fetched yet: ring queue full
+                    return OSAL_NOMEM;
+                }
+                else
+                {
+                    // another producer reserved this slot
+                    tail = __atomic_load_n(&ringqueue->tail, __ATOMIC_RELAXED);
+                }
+            }
+
+            // publish the message
+            slot->msg = msg;
+            __atomic_store_n(&slot->sequence, tail + 1, __ATOMIC_RELEASE);
+            result = OSAL_OK;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Fetch the oldest message from a lock-free ring queue. Never blocks.
+ *
+ * @param[in] handle pointer on the ring queue handle
+ * @param[in,out] msg message fetched in the ring queue
+ *
+ * @return operation status (@see OSAL_status_t), OSAL_ERROR if the ring queue is empty
+ */
+OSAL_status_t OSAL_ringqueue_fetch(OSAL_ringqueue_handle_t *handle, void **msg)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    if ((NULL == handle) || (NULL == msg))
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        osal_ringqueue_t *ringqueue = (osal_ringqueue_t *)*handle;
+        uint32_t head = ringqueue->head;
+
+        if (OSAL_RINGQUEUE_SPSC == ringqueue->type)
+        {
+            if (head != __atomic_load_n(&ringqueue->tail, __ATOMIC_ACQUIRE))
+            {
+                *msg = ringqueue->slots[head & ringqueue->mask].msg;
+                __atomic_store_n(&ringqueue->head, head + 1, __ATOMIC_RELEASE);
+                result = OSAL_OK;
+            }
+        }
+        else
+        {
+            osal_ringqueue_slot_t *slot = &ringqueue->slots[head & ringqueue->mask];
+            if ((head + 1) == __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE))
+            {
+                *msg = slot->msg;
+                // give the slot back to the producers for the next round
+                __atomic_store_n(&slot->sequence, head + ringqueue->mask + 1, __ATOMIC_RELEASE);
+                __atomic_store_n(&ringqueue->head, head + 1, __ATOMIC_RELAXED);
+                result = OSAL_OK;
+            }
+        }
+    }
+
+    return result;
+}
+
+static bool OSAL_ringqueue_check_args(uint32_t size, OSAL_ringqueue_type_t type)
+{
+    return (size >= 2) && (0 == (size & (size - 1))) && (size <= (UINT32_MAX / 2)) &&
+           ((OSAL_RINGQUEUE_MPSC == type) || (OSAL_RINGQUEUE_SPSC == type));
+}
+
+static void OSAL_ringqueue_init(osal_ringqueue_t *ringqueue, uint8_t *name, uint32_t size, OSAL_ringqueue_type_t type, uint8_t is_static, OSAL_ringqueue_handle_t *handle)
+{
+    ringqueue->tail = 0;
+    ringqueue->head = 0;
+    ringqueue->mask = size - 1;
+    ringqueue->type = type;
+    ringqueue->name = name;
+    ringqueue->is_static = is_static;
+    // the slots are stored right after the ring queue structure
+    ringqueue->slots = (osal_ringqueue_slot_t *)(ringqueue + 1);
+    for (uint32_t i = 0; i < size; i++)
+    {
+        ringqueue->slots[i].sequence = i;
+        ringqueue->slots[i].msg = NULL;
+    }
+
+    // make the initialized slots visible before the handle
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    *handle = (OSAL_ringqueue_handle_t)ringqueue;
+}
@@ -0,0 +1,243 @@
+/*
+ * C
+ *
+ * Copyright 2019 IS2T. All rights reserved
+ * This library is provided in source code for use, modification and test, subject to license terms
+ * Any modification of the source code will break IS2T warranties on the whole library
+ */
+
+/**
+ * @file
+ * @brief OS Abstraction Layer instrumentation implementation
+ * @author MicroEJ Developer Team
+ * @version 0.1.0
+ * @date 11 April 2018
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include "osal.h"
+#include "osal_stats.h"
+
+#ifdef OSAL_INSTRUMENTATION
+
+/*
+ * Each instrumented queue, semaphore and mutex embeds its record in its storage. The records are linked in a
+ * registry so they can be listed without knowing the primitives. The counters are updated with relaxed atomic
+ * operations: the semaphores are taken concurrently and the readers only need approximate values.
+ */
+
+static pthread_mutex_t osal_stats_registry_mutex = PTHREAD_MUTEX_INITIALIZER;
+static OSAL_stats_t *osal_stats_registry = NULL;
+
+static void OSAL_stats_histogram_add(uint32_t *histogram, uint32_t duration_us);
+static void OSAL_stats_print_histogram(const char *label, uint32_t *histogram);
+
+void OSAL_stats_register(OSAL_stats_t *stats, uint8_t *name, OSAL_stats_type_t type)
+{
+    memset(stats, 0, sizeof(OSAL_stats_t));
+    stats->name = name;
+    stats->type = type;
+
+    pthread_mutex_lock(&osal_stats_registry_mutex);
+    stats->next = osal_stats_registry;
+    osal_stats_registry = stats;
+    pthread_mutex_unlock(&osal_stats_registry_mutex);
+}
+
+void OSAL_stats_unregister(OSAL_stats_t *stats)
+{
+    pthread_mutex_lock(&osal_stats_registry_mutex);
+    OSAL_stats_t **link = &osal_stats_registry;
+    while ((NULL != *link) && (stats != *link))
+    {
+        link = &(*link)->next;
+    }
+    if (NULL != *link)
+    {
+        *link = stats->next;
+    }
+    pthread_mutex_unlock(&osal_stats_registry_mutex);
+}
+
+uint32_t OSAL_stats_time_us(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((now.tv_sec * 1000000) + (now.tv_nsec / 1000));
+}
+
+void OSAL_stats_acquired(OSAL_stats_t *stats, uint32_t wait_start_us, bool contended)
+{
+    uint32_t now = OSAL_stats_time_us();
+
+    __atomic_fetch_add(&stats->acquisitions, 1, __ATOMIC_RELAXED);
+    if (contended)
+    {
+        __atomic_fetch_add(&stats->contended, 1, __ATOMIC_RELAXED);
+        OSAL_stats_histogram_add(stats->wait_histogram, now - wait_start_us);
+    }
+    if (OSAL_STATS_MUTEX == stats->type)
+    {
+        // only written by the mutex holder
+        stats->hold_start = now;
+    }
+}
+
+void OSAL_stats_released(OSAL_stats_t *stats)
+{
+    OSAL_stats_histogram_add(stats->hold_histogram, OSAL_stats_time_us() - stats->hold_start);
+}
+
+void OSAL_stats_queue_level(OSAL_stats_t *stats, int32_t count)
+{
+    if (count > stats->high_water)
+    {
+        stats->high_water = count;
+    }
+}
+
+/**
+ * @brief Copy the instrumentation records of all the existing queues, semaphores and mutexes.
+ * The counters are updated concurrently: each record is consistent only to within the operations in progress.
+ *
+ * @param[in,out] records array filled with the records. Their <code>next</code> field is set to NULL.
+ * @param[in] max length of <code>records</code>
+ * @param[out] count number of records copied
+ *
+ * @return operation status (@see OSAL_status_t), OSAL_NOMEM if there are more than <code>max</code> records,
+ * OSAL_NOT_IMPLEMENTED if OSAL_INSTRUMENTATION is not defined
+ */
+OSAL_status_t OSAL_stats_snapshot(OSAL_stats_t *records, uint32_t max, uint32_t *count)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    if (((NULL == records) && (0 != max)) || (NULL == count))
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        uint32_t copied = 0;
+        result = OSAL_OK;
+
+        pthread_mutex_lock(&osal_stats_registry_mutex);
+        for (OSAL_stats_t *stats = osal_stats_registry; NULL != stats; stats = stats->next)
+        {
+            if (copied == max)
+            {
+                result = OSAL_NOMEM;
+                break;
+            }
+            records[copied] = *stats;
+            records[copied].next = NULL;
+            ++copied;
+        }
+        pthread_mutex_unlock(&osal_stats_registry_mutex);
+
+        *count = copied;
+    }
+
+    return result;
+}
+
+/**
+ * @brief Print the instrumentation records of all the existing queues, semaphores and mutexes on the console.
+ *
+ * @return operation status (@see OSAL_status_t), OSAL_NOT_IMPLEMENTED if OSAL_INSTRUMENTATION is not defined
+ */
+OSAL_status_t OSAL_stats_dump(void)
+{
+    static const char *type_names[] = {"queue", "semaphore", "mutex"};
+
+    pthread_mutex_lock(&osal_stats_registry_mutex);
+    printf("[OSAL] instrumentation (histograms: log2 buckets in us)\n");
+    for (OSAL_stats_t *stats = osal_stats_registry; NULL != stats; stats = stats->next)
+    {
+        printf("[OSAL] %s %s: acquisitions=%u contended=%u", type_names[stats->type],
+               (NULL != stats->name) ? (const char *)stats->name : "?", (unsigned int)stats->acquisitions, (unsigned int)stats->contended);
+        if (OSAL_STATS_QUEUE == stats->type)
+        {
+            printf(" high_water=%d", (int)stats->high_water);
+        }
+        printf("\n");
+        OSAL_stats_print_histogram("wait", stats->wait_histogram);
+        if (OSAL_STATS_MUTEX == stats->type)
+        {
+            OSAL_stats_print_histogram("hold", stats->hold_histogram);
+        }
+    }
+    pthread_mutex_unlock(&osal_stats_registry_mutex);
+
+    return OSAL_OK;
+}
+
+/**
+ * @brief Reset the counters and histograms of all the instrumentation records.
+ *
+ * @return operation status (@see OSAL_status_t), OSAL_NOT_IMPLEMENTED if OSAL_INSTRUMENTATION is not defined
+ */
+OSAL_status_t OSAL_stats_reset(void)
+{
+    pthread_mutex_lock(&osal_stats_registry_mutex);
+    for (OSAL_stats_t *stats = osal_stats_registry; NULL != stats; stats = stats->next)
+    {
+        stats->acquisitions = 0;
+        stats->contended = 0;
+        memset(stats->wait_histogram, 0, sizeof(stats->wait_histogram));
+        memset(stats->hold_histogram, 0, sizeof(stats->hold_histogram));
+        stats->high_water = 0;
+    }
+    pthread_mutex_unlock(&osal_stats_registry_mutex);
+
+    return OSAL_OK;
+}
+
+static void OSAL_stats_histogram_add(uint32_t *histogram, uint32_t duration_us)
+{
+    // bucket i holds [2^(i-1), 2^i[ us
+    uint32_t bucket = (0 == duration_us) ? 0 : (32 - __builtin_clz(duration_us));
+    if (bucket >= OSAL_STATS_HISTOGRAM_SIZE)
+    {
+        bucket = OSAL_STATS_HISTOGRAM_SIZE - 1;
+    }
+    __atomic_fetch_add(&histogram[bucket], 1, __ATOMIC_RELAXED);
+}
+
+static void OSAL_stats_print_histogram(const char *label, uint32_t *histogram)
+{
+    printf("[OSAL]     %s:", label);
+    for (int32_t i = 0; i < OSAL_STATS_HISTOGRAM_SIZE; i++)
+    {
+        printf(" %u", (unsigned int)histogram[i]);
+    }
+    printf("\n");
+}
+
+#else // OSAL_INSTRUMENTATION
+
+OSAL_status_t OSAL_stats_snapshot(OSAL_stats_t *records, uint32_t max, uint32_t *count)
+{
+    if (NULL != count)
+    {
+        *count = 0;
+    }
+    return OSAL_NOT_IMPLEMENTED;
+}
+
+OSAL_status_t OSAL_stats_dump(void)
+{
+    return OSAL_NOT_IMPLEMENTED;
+}
+
+OSAL_status_t OSAL_stats_reset(void)
+{
+    return OSAL_NOT_IMPLEMENTED;
+}
+
+#endif // OSAL_INSTRUMENTATION
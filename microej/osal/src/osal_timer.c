@@ -0,0 +1,593 @@
+/*
+ * C
+ *
+ * Copyright 2019 IS2T. All rights reserved
+ * This library is provided in source code for use, modification and test, subject to license terms
+ * Any modification of the source code will break IS2T warranties on the whole library
+ */
+
+/**
+ * @file
+ * @brief OS Abstraction Layer timer service implementation
+ * @author MicroEJ Developer Team
+ * @version 0.1.0
+ * @date 11 April 2018
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <time.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "osal.h"
+
+#ifdef OSAL_NO_DYNAMIC_ALLOCATION
+// any path reaching the heap fails to compile
+#pragma GCC poison malloc free
+#endif
+
+/*
+ * All the timers are served by one task using a two-level timer wheel:
+ * - level 0 has one slot per tick and holds the timers expiring in the next OSAL_TIMER_WHEEL0_SIZE ticks,
+ * - level 1 has one slot per OSAL_TIMER_WHEEL0_SIZE ticks and holds the other timers. Each time level 0 completes
+ *   a round, the next level 1 slot is cascaded: its timers are moved to level 0 or back to level 1 when they expire
+ *   beyond the level 1 range.
+ * Starting, stopping and expiring a timer is O(1). The task sleeps until the next non-empty level 0 slot or the next
+ * cascade, it does not wake up on every tick.
+ *
+ * The deadlines are computed on CLOCK_MONOTONIC. The wait itself uses sem_timedwait() which only takes an absolute
+ * CLOCK_REALTIME time: the remaining monotonic time is converted before each wait, so a wall clock change can only
+ * delay one wakeup.
+ */
+
+#ifndef OSAL_TIMER_TICK_MS
+// Timer resolution in milliseconds
+#define OSAL_TIMER_TICK_MS (1)
+#endif
+
+#ifndef OSAL_TIMER_TASK_STACK_SIZE
+// The timer callbacks are called on the timer task, its stack must fit them
+#define OSAL_TIMER_TASK_STACK_SIZE (2048)
+#endif
+
+#ifndef OSAL_TIMER_TASK_PRIORITY
+#define OSAL_TIMER_TASK_PRIORITY (110)
+#endif
+
+#define OSAL_TIMER_WHEEL0_BITS (8)
+#define OSAL_TIMER_WHEEL0_SIZE (1 << OSAL_TIMER_WHEEL0_BITS)
+#define OSAL_TIMER_WHEEL0_MASK (OSAL_TIMER_WHEEL0_SIZE - 1)
+#define OSAL_TIMER_WHEEL1_SIZE (64)
+#define OSAL_TIMER_WHEEL1_MASK (OSAL_TIMER_WHEEL1_SIZE - 1)
+
+#define NANOSECONDS_IN_SECONDS 1000000000
+#define NANOSECONDS_IN_MILLISECONDS 1000000
+#define MILLISECONDS_IN_SECONDS 1000
+
+typedef OSAL_timer_storage_t osal_timer_t;
+
+typedef struct
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t callback_done; // signaled each time a callback returns
+    sem_t wakeup;                 // wakes up the timer task when an earlier deadline is armed
+    bool started;
+    bool awake;         // the timer task is processing the wheel and will compute its next wakeup
+    bool wakeup_planned;
+    uint32_t wakeup_tick; // tick of the planned wakeup when the timer task sleeps
+    uint32_t current_tick; // last tick processed by the timer task
+    pthread_t thread;
+    OSAL_task_handle_t task;
+    osal_timer_t *running; // timer whose callback is being called
+    osal_timer_t *wheel0[OSAL_TIMER_WHEEL0_SIZE];
+    osal_timer_t *wheel1[OSAL_TIMER_WHEEL1_SIZE];
+} osal_timer_service_t;
+
+static osal_timer_service_t osal_timer_service = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .callback_done = PTHREAD_COND_INITIALIZER,
+};
+
+OSAL_task_stack_declare(osal_timer_stack, OSAL_TIMER_TASK_STACK_SIZE);
+
+static void *OSAL_timer_task(void *args);
+static OSAL_status_t OSAL_timer_service_ensure_started(osal_timer_service_t *service);
+static void OSAL_timer_init(osal_timer_t *timer, uint8_t *name, OSAL_timer_callback_t callback, void *arg, uint8_t is_static, OSAL_timer_handle_t *handle);
+static void OSAL_timer_release(osal_timer_t *timer);
+static OSAL_status_t OSAL_timer_service_start(osal_timer_service_t *service);
+static uint64_t OSAL_timer_current_time_ns(void);
+static uint32_t OSAL_timer_current_tick(void);
+static uint32_t OSAL_timer_deadline_tick(uint32_t delay_ms);
+static uint32_t OSAL_timer_milliseconds_to_ticks(uint32_t ms);
+static void OSAL_timer_link(osal_timer_t **list, osal_timer_t *timer);
+static void OSAL_timer_unlink(osal_timer_t *timer);
+static void OSAL_timer_insert(osal_timer_service_t *service, osal_timer_t *timer);
+static void OSAL_timer_cascade(osal_timer_service_t *service);
+static bool OSAL_timer_next_wakeup(osal_timer_service_t *service, uint32_t *tick);
+static void OSAL_timer_wait(osal_timer_service_t *service, uint32_t now);
+
+#ifndef OSAL_NO_DYNAMIC_ALLOCATION
+/**
+ * @brief Create an OS timer. The timer is created stopped.
+ *
+ * All the timers are served by one timer service task, started with the first timer creation. The callbacks are called
+ * on this task: they must be short and must not block.
+ *
+ * @param[in] name timer name
+ * @param[in] callback function called each time the timer expires
+ * @param[in] arg argument given to the callback
+ * @param[in,out] handle pointer on a timer handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_timer_create(uint8_t *name, OSAL_timer_callback_t callback, void *arg, OSAL_timer_handle_t *handle)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    if ((NULL == handle) || (NULL == callback))
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        result = OSAL_timer_service_ensure_started(&osal_timer_service);
+        if (OSAL_OK == result)
+        {
+            osal_timer_t *timer = malloc(sizeof(osal_timer_t));
+            if (NULL == timer)
+            {
+                printf("[ERROR] OSAL timer memory allocation failed\n");
+                result = OSAL_NOMEM;
+            }
+            else
+            {
+                OSAL_timer_init(timer, name, callback, arg, 0, handle);
+            }
+        }
+    }
+
+    return result;
+}
+#endif // OSAL_NO_DYNAMIC_ALLOCATION
+
+/**
+ * @brief Create an OS timer in a storage declared with OSAL_timer_storage_declare(). Does not allocate memory.
+ * The timer is created stopped.
+ *
+ * @param[in] name timer name
+ * @param[in] callback function called each time the timer expires
+ * @param[in] arg argument given to the callback
+ * @param[in] storage timer storage
+ * @param[in,out] handle pointer on a timer handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_timer_create_static(uint8_t *name, OSAL_timer_callback_t callback, void *arg, OSAL_timer_storage_t *storage, OSAL_timer_handle_t *handle)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    if ((NULL == handle) || (NULL == callback) || (NULL == storage))
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        result = OSAL_timer_service_ensure_started(&osal_timer_service);
+        if (OSAL_OK == result)
+        {
+            OSAL_timer_init(storage, name, callback, arg, 1, handle);
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Delete an OS timer. When this function returns, the timer callback is not running and will not be called anymore.
+ * A timer may delete itself from its own callback.
+ *
+ * @param[in] handle pointer on the timer handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_timer_delete(OSAL_timer_handle_t *handle)
+{
+    OSAL_status_t result = OSAL_ERROR;
+    osal_timer_service_t *service = &osal_timer_service;
+
+    if ((NULL == handle) || (NULL == *handle))
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        osal_timer_t *timer = (osal_timer_t *)*handle;
+
+        pthread_mutex_lock(&service->mutex);
+        OSAL_timer_unlink(timer);
+        if ((service->running == timer) && pthread_equal(pthread_self(), service->thread))
+        {
+            // deleted from its own callback: the timer task frees it when the callback returns
+            timer->delete_pending = 1;
+        }
+        else
+        {
+            while (service->running == timer)
+            {
+                pthread_cond_wait(&service->callback_done, &service->mutex);
+            }
+            OSAL_timer_release(timer);
+        }
+        pthread_mutex_unlock(&service->mutex);
+
+        *handle = NULL;
+        result = OSAL_OK;
+    }
+
+    return result;
+}
+
+/**
+ * @brief Start an OS timer. Starting a running timer restarts it with the new delay and period.
+ * The deadlines are computed on a monotonic clock.
+ *
+ * @param[in] handle pointer on the timer handle
+ * @param[in] delay_ms delay before the first expiration, in milliseconds
+ * @param[in] period_ms period of the next expirations in milliseconds, 0 for a one-shot timer
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_timer_start(OSAL_timer_handle_t *handle, uint32_t delay_ms, uint32_t period_ms)
+{
+    OSAL_status_t result = OSAL_ERROR;
+    osal_timer_service_t *service = &osal_timer_service;
+
+    if ((NULL == handle) || (NULL == *handle))
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        osal_timer_t *timer = (osal_timer_t *)*handle;
+
+        pthread_mutex_lock(&service->mutex);
+        OSAL_timer_unlink(timer);
+
+        if (!service->awake && !service->wakeup_planned)
+        {
+            // the timer task sleeps with an empty wheel: skip the idle ticks instead of processing them one by one
+            service->current_tick = OSAL_timer_current_tick();
+        }
+
+        // the clock is read under the lock so the deadline is never behind the tick processed by the timer task
+        timer->expiry = OSAL_timer_deadline_tick(delay_ms);
+        if ((int32_t)(timer->expiry - service->current_tick) <= 0)
+        {
+            timer->expiry = service->current_tick + 1;
+        }
+        timer->period = OSAL_timer_milliseconds_to_ticks(period_ms);
+        OSAL_timer_insert(service, timer);
+
+        if (!service->awake && (!service->wakeup_planned || ((int32_t)(timer->expiry - service->wakeup_tick) < 0)))
+        {
+            // the timer task sleeps until a later deadline
+            service->wakeup_planned = true;
+            service->wakeup_tick = timer->expiry;
+            sem_post(&service->wakeup);
+        }
+        pthread_mutex_unlock(&service->mutex);
+
+        result = OSAL_OK;
+    }
+
+    return result;
+}
+
+/**
+ * @brief Stop an OS timer. Stopping a stopped timer has no effect.
+ *
+ * @param[in] handle pointer on the timer handle
+ *
+ * @return operation status (@see OSAL_status_t)
+ */
+OSAL_status_t OSAL_timer_stop(OSAL_timer_handle_t *handle)
+{
+    OSAL_status_t result = OSAL_ERROR;
+    osal_timer_service_t *service = &osal_timer_service;
+
+    if ((NULL == handle) || (NULL == *handle))
+    {
+        result = OSAL_WRONG_ARGS;
+    }
+    else
+    {
+        // the timer task does not need to be woken up: an early wakeup without expired timer is harmless
+        pthread_mutex_lock(&service->mutex);
+        OSAL_timer_unlink((osal_timer_t *)*handle);
+        pthread_mutex_unlock(&service->mutex);
+        result = OSAL_OK;
+    }
+
+    return result;
+}
+
+static OSAL_status_t OSAL_timer_service_ensure_started(osal_timer_service_t *service)
+{
+    OSAL_status_t result;
+
+    pthread_mutex_lock(&service->mutex);
+    result = service->started ? OSAL_OK : OSAL_timer_service_start(service);
+    pthread_mutex_unlock(&service->mutex);
+
+    return result;
+}
+
+static void OSAL_timer_init(osal_timer_t *timer, uint8_t *name, OSAL_timer_callback_t callback, void *arg, uint8_t is_static, OSAL_timer_handle_t *handle)
+{
+    timer->next = NULL;
+    timer->pprev = NULL;
+    timer->expiry = 0;
+    timer->period = 0;
+    timer->callback = callback;
+    timer->arg = arg;
+    timer->name = name;
+    timer->delete_pending = 0;
+    timer->is_static = is_static;
+    *handle = (OSAL_timer_handle_t)timer;
+}
+
+static void OSAL_timer_release(osal_timer_t *timer)
+{
+#ifndef OSAL_NO_DYNAMIC_ALLOCATION
+    if (0 == timer->is_static)
+    {
+        free(timer);
+    }
+#else
+    (void)timer;
+#endif
+}
+
+// Must be called with the service mutex locked
+static OSAL_status_t OSAL_timer_service_start(osal_timer_service_t *service)
+{
+    OSAL_status_t result = OSAL_ERROR;
+
+    if (0 != sem_init(&service->wakeup, 0, 0))
+    {
+        printf("[ERROR] OSAL timer service semaphore init failed (errno: %d)\n", errno);
+    }
+    else
+    {
+        service->current_tick = OSAL_timer_current_tick();
+        service->awake = true;
+        result = OSAL_task_create(OSAL_timer_task, (uint8_t *)"osal_timer", osal_timer_stack, OSAL_TIMER_TASK_PRIORITY, service, &service->task);
+        if (OSAL_OK == result)
+        {
+            service->started = true;
+        }
+        else
+        {
+            printf("[ERROR] OSAL timer service task creation failed\n");
+            sem_destroy(&service->wakeup);
+        }
+    }
+
+    return result;
+}
+
+static void *OSAL_timer_task(void *args)
+{
+    osal_timer_service_t *service = (osal_timer_service_t *)args;
+
+    pthread_mutex_lock(&service->mutex);
+    service->thread = pthread_self();
+
+    while (1)
+    {
+        uint32_t now = OSAL_timer_current_tick();
+
+        // process all the ticks elapsed since the last wakeup
+        while ((int32_t)(now - service->current_tick) > 0)
+        {
+            osal_timer_t *timer;
+
+            ++service->current_tick;
+            if (0 == (service->current_tick & OSAL_TIMER_WHEEL0_MASK))
+            {
+                OSAL_timer_cascade(service);
+            }
+
+            // a level 0 slot only holds timers expiring on the current tick
+            while (NULL != (timer = service->wheel0[service->current_tick & OSAL_TIMER_WHEEL0_MASK]))
+            {
+                OSAL_timer_unlink(timer);
+                if (0 != timer->period)
+                {
+                    // periodic timers are rearmed from their previous deadline to avoid drifting
+                    timer->expiry += timer->period;
+                    OSAL_timer_insert(service, timer);
+                }
+
+                service->running = timer;
+                pthread_mutex_unlock(&service->mutex);
+                timer->callback(timer->arg);
+                pthread_mutex_lock(&service->mutex);
+                service->running = NULL;
+
+                if (timer->delete_pending)
+                {
+                    OSAL_timer_release(timer);
+                }
+                pthread_cond_broadcast(&service->callback_done);
+            }
+        }
+
+        OSAL_timer_wait(service, now);
+    }
+
+    return NULL;
+}
+
+// Must be called with the service mutex locked, returns with the service mutex locked
+static void OSAL_timer_wait(osal_timer_service_t *service, uint32_t now)
+{
+    uint32_t next_tick = 0;
+    // the shared fields may be updated by OSAL_timer_start() once unlocked
+    bool planned = OSAL_timer_next_wakeup(service, &next_tick);
+
+    service->wakeup_planned = planned;
+    service->wakeup_tick = next_tick;
+    service->awake = false;
+    pthread_mutex_unlock(&service->mutex);
+
+    if (planned)
+    {
+        struct timespec abs_time;
+        uint32_t remaining_ms = (next_tick - now) * OSAL_TIMER_TICK_MS;
+
+        clock_gettime(CLOCK_REALTIME, &abs_time);
+        abs_time.tv_sec += remaining_ms / MILLISECONDS_IN_SECONDS;
+        abs_time.tv_nsec += (remaining_ms % MILLISECONDS_IN_SECONDS) * NANOSECONDS_IN_MILLISECONDS;
+        if (abs_time.tv_nsec >= NANOSECONDS_IN_SECONDS)
+        {
+            abs_time.tv_nsec -= NANOSECONDS_IN_SECONDS;
+            abs_time.tv_sec++;
+        }
+        // timeout, interruption and wakeup are handled the same way: the wheel is processed again
+        sem_timedwait(&service->wakeup, &abs_time);
+    }
+    else
+    {
+        sem_wait(&service->wakeup);
+    }
+
+    pthread_mutex_lock(&service->mutex);
+    service->awake = true;
+    if (!service->wakeup_planned)
+    {
+        // no timer was armed while sleeping: skip the idle ticks instead of processing them one by one, a timer armed
+        // meanwhile already did it in OSAL_timer_start()
+        service->current_tick = OSAL_timer_current_tick();
+    }
+}
+
+// Must be called with the service mutex locked
+static bool OSAL_timer_next_wakeup(osal_timer_service_t *service, uint32_t *tick)
+{
+    for (uint32_t delta = 1; delta < OSAL_TIMER_WHEEL0_SIZE; delta++)
+    {
+        if (NULL != service->wheel0[(service->current_tick + delta) & OSAL_TIMER_WHEEL0_MASK])
+        {
+            *tick = service->current_tick + delta;
+            return true;
+        }
+    }
+
+    for (uint32_t i = 0; i < OSAL_TIMER_WHEEL1_SIZE; i++)
+    {
+        if (NULL != service->wheel1[i])
+        {
+            // wake up for the next cascade
+            *tick = (service->current_tick | OSAL_TIMER_WHEEL0_MASK) + 1;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Must be called with the service mutex locked
+static void OSAL_timer_cascade(osal_timer_service_t *service)
+{
+    uint32_t slot = (service->current_tick >> OSAL_TIMER_WHEEL0_BITS) & OSAL_TIMER_WHEEL1_MASK;
+    osal_timer_t *timer = service->wheel1[slot];
+
+    service->wheel1[slot] = NULL;
+    while (NULL != timer)
+    {
+        osal_timer_t *next = timer->next;
+        timer->pprev = NULL;
+        OSAL_timer_insert(service, timer);
+        timer = next;
+    }
+}
+
+// Must be called with the service mutex locked, the timer must not be armed
+static void OSAL_timer_insert(osal_timer_service_t *service, osal_timer_t *timer)
+{
+    uint32_t delta = timer->expiry - service->current_tick;
+
+    if (delta < OSAL_TIMER_WHEEL0_SIZE)
+    {
+        OSAL_timer_link(&service->wheel0[timer->expiry & OSAL_TIMER_WHEEL0_MASK], timer);
+    }
+    else
+    {
+        uint32_t round = service->current_tick >> OSAL_TIMER_WHEEL0_BITS;
+        uint32_t expiry_round = timer->expiry >> OSAL_TIMER_WHEEL0_BITS;
+
+        if ((expiry_round - round) >= OSAL_TIMER_WHEEL1_SIZE)
+        {
+            // beyond the wheel range: parked in the last slot and inserted again when cascaded
+            expiry_round = round + OSAL_TIMER_WHEEL1_SIZE - 1;
+        }
+        OSAL_timer_link(&service->wheel1[expiry_round & OSAL_TIMER_WHEEL1_MASK], timer);
+    }
+}
+
+static void OSAL_timer_link(osal_timer_t **list, osal_timer_t *timer)
+{
+    timer->next = *list;
+    if (NULL != timer->next)
+    {
+        timer->next->pprev = &timer->next;
+    }
+    timer->pprev = list;
+    *list = timer;
+}
+
+static void OSAL_timer_unlink(osal_timer_t *timer)
+{
+    if (NULL != timer->pprev)
+    {
+        *timer->pprev = timer->next;
+        if (NULL != timer->next)
+        {
+            timer->next->pprev = timer->pprev;
+        }
+        timer->next = NULL;
+        timer->pprev = NULL;
+    }
+}
+
+static uint64_t OSAL_timer_current_time_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * NANOSECONDS_IN_SECONDS) + now.tv_nsec;
+}
+
+static uint32_t OSAL_timer_current_tick(void)
+{
+    // wraps around, ticks are only compared through differences
+    return (uint32_t)(OSAL_timer_current_time_ns() / ((uint64_t)OSAL_TIMER_TICK_MS * NANOSECONDS_IN_MILLISECONDS));
+}
+
+static uint32_t OSAL_timer_deadline_tick(uint32_t delay_ms)
+{
+    // rounded up so a timer never expires before its delay
+    uint64_t tick_ns = (uint64_t)OSAL_TIMER_TICK_MS * NANOSECONDS_IN_MILLISECONDS;
+    uint64_t deadline_ns = OSAL_timer_current_time_ns() + ((uint64_t)delay_ms * NANOSECONDS_IN_MILLISECONDS);
+    return (uint32_t)((deadline_ns + tick_ns - 1) / tick_ns);
+}
+
+static uint32_t OSAL_timer_milliseconds_to_ticks(uint32_t ms)
+{
+    // rounded up so a timer never expires before its delay
+    return (uint32_t)(((uint64_t)ms + OSAL_TIMER_TICK_MS - 1) / OSAL_TIMER_TICK_MS);
+}
@@ -6,6 +6,9 @@
  * Any modification of the source code will break IS2T warranties on the whole library
  */
 
+#ifdef __NuttX__
+// host C libraries provide pthread_mutex_timedlock()
+
 #include "pthread_mutex_timedlock.h"
 #include <sched.h>
 #include "errno.h"
@@ -56,3 +59,5 @@ int pthread_mutex_timedlock(pthread_mutex_t *mutex, const struct timespec *restr
     }
     return ret;
 }
+
+#endif // __NuttX__
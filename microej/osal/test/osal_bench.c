@@ -0,0 +1,687 @@
+/*
+ * C
+ *
+ * Copyright 2019 IS2T. All rights reserved
+ * This library is provided in source code for use, modification and test, subject to license terms
+ * Any modification of the source code will break IS2T warranties on the whole library
+ */
+
+/**
+ * @file
+ * @brief OS Abstraction Layer host benchmarks and stress tests
+ * @author MicroEJ Developer Team
+ * @version 0.1.0
+ * @date 17 October 2026
+ *
+ * Usage: osal_bench [-g] [benchmark...]
+ * Without benchmark name, all the benchmarks are run. With -g, each benchmark compares its results to the thresholds
+ * below and the program exits with a non-zero status if one of them is exceeded (regression gate).
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sched.h>
+#include <unistd.h>
+#include "osal.h"
+#include "osal_bench_helper.h"
+
+// Gate thresholds. They are loose enough for a loaded single CPU host: they catch lost wakeups and early timeouts,
+// not small performance variations.
+#ifndef OSAL_BENCH_MAX_P99_LATENCY_US
+#define OSAL_BENCH_MAX_P99_LATENCY_US (5000)
+#endif
+#ifndef OSAL_BENCH_MIN_THROUGHPUT
+#define OSAL_BENCH_MIN_THROUGHPUT (5000)
+#endif
+#ifndef OSAL_BENCH_MAX_OVERSHOOT_US
+#define OSAL_BENCH_MAX_OVERSHOOT_US (20000)
+#endif
+
+#define OSAL_BENCH_STACK_SIZE (65536)
+#define OSAL_BENCH_PRIORITY (100)
+#define OSAL_BENCH_ROUND_TRIPS (20000)
+#define OSAL_BENCH_MAX_PRODUCERS (8)
+#define OSAL_BENCH_MESSAGES_PER_PRODUCER (5000)
+#define OSAL_BENCH_STRESS_TASKS (8)
+#define OSAL_BENCH_STRESS_ITERATIONS (300)
+#define OSAL_BENCH_TIMERS (1000)
+#define OSAL_BENCH_SELECT_QUEUES (OSAL_QUEUE_SELECT_MAX)
+// Stack of a service task on the target, used to compare the RAM of the task-per-queue and select designs
+#define OSAL_BENCH_TARGET_STACK_SIZE (2048)
+#define OSAL_BENCH_SPIN_TASKS (4)
+#define OSAL_BENCH_SPIN_TAKES (1000)
+#define OSAL_BENCH_TIMER_MAX_DELAY_MS (700)
+
+OSAL_task_stack_declare(osal_bench_stack, OSAL_BENCH_STACK_SIZE);
+
+static uint32_t osal_bench_samples[OSAL_BENCH_ROUND_TRIPS];
+
+static OSAL_task_handle_t osal_bench_start(OSAL_task_entry_point_t entry_point, const char *name, void *parameters)
+{
+    OSAL_task_handle_t task = NULL;
+    if (OSAL_task_create(entry_point, (uint8_t *)name, osal_bench_stack, OSAL_BENCH_PRIORITY, parameters, &task) != OSAL_OK)
+    {
+        printf("  cannot create task %s\n", name);
+        exit(2);
+    }
+    return task;
+}
+
+/*
+ * Queue ping-pong: round trip of a message through two queues and an echo task.
+ */
+
+static OSAL_queue_handle_t osal_bench_ping;
+static OSAL_queue_handle_t osal_bench_pong;
+
+static void *osal_bench_echo_task(void *args)
+{
+    void *msg = NULL;
+    while (OSAL_queue_fetch(&osal_bench_ping, &msg, OSAL_INFINITE_TIME) == OSAL_OK && msg != NULL)
+    {
+        OSAL_queue_post(&osal_bench_pong, msg);
+    }
+    OSAL_queue_post(&osal_bench_pong, NULL);
+    return NULL;
+}
+
+static bool osal_bench_queue_ping_pong(bool gate)
+{
+    OSAL_queue_create((uint8_t *)"ping", 1, &osal_bench_ping);
+    OSAL_queue_create((uint8_t *)"pong", 1, &osal_bench_pong);
+    OSAL_task_handle_t task = osal_bench_start(osal_bench_echo_task, "echo", NULL);
+
+    uint32_t lost = 0;
+    for (uint32_t i = 0; i < OSAL_BENCH_ROUND_TRIPS; i++)
+    {
+        void *msg = NULL;
+        uint32_t start = osal_bench_time_us();
+        OSAL_queue_post(&osal_bench_ping, (void *)(uintptr_t)(i + 1));
+        if (OSAL_queue_fetch(&osal_bench_pong, &msg, 1000) != OSAL_OK || msg != (void *)(uintptr_t)(i + 1))
+        {
+            lost++;
+        }
+        osal_bench_samples[i] = osal_bench_time_us() - start;
+    }
+    void *msg = NULL;
+    OSAL_queue_post(&osal_bench_ping, NULL);
+    OSAL_queue_fetch(&osal_bench_pong, &msg, 1000);
+    OSAL_task_delete(&task);
+    OSAL_queue_delete(&osal_bench_ping);
+    OSAL_queue_delete(&osal_bench_pong);
+
+    uint32_t p99 = osal_bench_report_latency("round trip", osal_bench_samples, OSAL_BENCH_ROUND_TRIPS);
+    bool ok = osal_bench_check(gate, lost == 0, "lost messages");
+    return osal_bench_check(gate, p99 <= OSAL_BENCH_MAX_P99_LATENCY_US, "round trip p99 above OSAL_BENCH_MAX_P99_LATENCY_US") && ok;
+}
+
+/*
+ * Queue producers: 1 to 8 tasks posting to one queue drained by the main task. Each message holds its producer and
+ * its sequence number so that losses and reordering are detected.
+ */
+
+static OSAL_queue_handle_t osal_bench_queue;
+
+static void *osal_bench_producer_task(void *args)
+{
+    uintptr_t producer = (uintptr_t)args;
+    for (uintptr_t i = 1; i <= OSAL_BENCH_MESSAGES_PER_PRODUCER; i++)
+    {
+        while (OSAL_queue_post(&osal_bench_queue, (void *)((producer << 24) | i)) != OSAL_OK)
+        {
+            // Full queue: let the consumer run
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static bool osal_bench_queue_producers(bool gate)
+{
+    bool ok = true;
+    OSAL_queue_create((uint8_t *)"producers", 256, &osal_bench_queue);
+    for (uint32_t producers = 1; producers <= OSAL_BENCH_MAX_PRODUCERS; producers *= 2)
+    {
+        OSAL_task_handle_t tasks[OSAL_BENCH_MAX_PRODUCERS];
+        uint32_t last[OSAL_BENCH_MAX_PRODUCERS] = {0};
+        uint32_t errors = 0;
+        uint32_t total = producers * OSAL_BENCH_MESSAGES_PER_PRODUCER;
+        uint32_t start = osal_bench_time_us();
+        for (uint32_t p = 0; p < producers; p++)
+        {
+            tasks[p] = osal_bench_start(osal_bench_producer_task, "producer", (void *)(uintptr_t)p);
+        }
+        uint32_t received = 0;
+        while (received < total)
+        {
+            void *msgs[32];
+            uint32_t count = 0;
+            if (OSAL_queue_fetch_many(&osal_bench_queue, msgs, 32, &count, 1000) != OSAL_OK)
+            {
+                errors++;
+                break;
+            }
+            for (uint32_t i = 0; i < count; i++)
+            {
+                uintptr_t msg = (uintptr_t)msgs[i];
+                uint32_t producer = (uint32_t)(msg >> 24);
+                uint32_t seq = (uint32_t)(msg & 0xFFFFFF);
+                if (producer >= producers || seq != last[producer] + 1)
+                {
+                    errors++;
+                }
+                else
+                {
+                    last[producer] = seq;
+                }
+            }
+            received += count;
+        }
+        uint32_t elapsed = osal_bench_time_us() - start;
+        for (uint32_t p = 0; p < producers; p++)
+        {
+            OSAL_task_delete(&tasks[p]);
+        }
+        uint32_t throughput = (uint32_t)(((uint64_t)received * 1000000) / (elapsed == 0 ? 1 : elapsed));
+        printf("  %lu producer(s)                %8lu msg/s  errors %lu\n", (unsigned long)producers, (unsigned long)throughput, (unsigned long)errors);
+        ok = osal_bench_check(gate, errors == 0, "lost or reordered messages") && ok;
+        ok = osal_bench_check(gate, throughput >= OSAL_BENCH_MIN_THROUGHPUT, "throughput below OSAL_BENCH_MIN_THROUGHPUT") && ok;
+    }
+    OSAL_queue_delete(&osal_bench_queue);
+    return ok;
+}
+
+/*
+ * Semaphore handoff: two tasks passing the turn with two binary semaphores.
+ */
+
+static OSAL_binary_semaphore_handle_t osal_bench_turn;
+static OSAL_binary_semaphore_handle_t osal_bench_turn_back;
+static volatile bool osal_bench_stop;
+
+static void *osal_bench_handoff_task(void *args)
+{
+    while (OSAL_binary_semaphore_take(&osal_bench_turn, OSAL_INFINITE_TIME) == OSAL_OK && !osal_bench_stop)
+    {
+        OSAL_binary_semaphore_give(&osal_bench_turn_back);
+    }
+    OSAL_binary_semaphore_give(&osal_bench_turn_back);
+    return NULL;
+}
+
+static bool osal_bench_semaphore_handoff(bool gate)
+{
+    OSAL_binary_semaphore_create((uint8_t *)"turn", 0, &osal_bench_turn);
+    OSAL_binary_semaphore_create((uint8_t *)"turn back", 0, &osal_bench_turn_back);
+    osal_bench_stop = false;
+    OSAL_task_handle_t task = osal_bench_start(osal_bench_handoff_task, "handoff", NULL);
+
+    uint32_t lost = 0;
+    for (uint32_t i = 0; i < OSAL_BENCH_ROUND_TRIPS; i++)
+    {
+        uint32_t start = osal_bench_time_us();
+        OSAL_binary_semaphore_give(&osal_bench_turn);
+        if (OSAL_binary_semaphore_take(&osal_bench_turn_back, 1000) != OSAL_OK)
+        {
+            lost++;
+        }
+        osal_bench_samples[i] = osal_bench_time_us() - start;
+    }
+    osal_bench_stop = true;
+    OSAL_binary_semaphore_give(&osal_bench_turn);
+    OSAL_binary_semaphore_take(&osal_bench_turn_back, 1000);
+    OSAL_task_delete(&task);
+    OSAL_binary_semaphore_delete(&osal_bench_turn);
+    OSAL_binary_semaphore_delete(&osal_bench_turn_back);
+
+    uint32_t p99 = osal_bench_report_latency("handoff round trip", osal_bench_samples, OSAL_BENCH_ROUND_TRIPS);
+    bool ok = osal_bench_check(gate, lost == 0, "lost gives");
+    return osal_bench_check(gate, p99 <= OSAL_BENCH_MAX_P99_LATENCY_US, "handoff p99 above OSAL_BENCH_MAX_P99_LATENCY_US") && ok;
+}
+
+/*
+ * Timed wait accuracy: timed takes and fetches that time out. A timeout must never return early.
+ */
+
+static bool osal_bench_timed_wait(bool gate)
+{
+    static const uint32_t timeouts[] = {1, 2, 5, 10, 20, 50};
+    OSAL_binary_semaphore_handle_t binary;
+    OSAL_counter_semaphore_handle_t counter;
+    OSAL_queue_handle_t queue;
+    OSAL_binary_semaphore_create((uint8_t *)"binary", 0, &binary);
+    OSAL_counter_semaphore_create((uint8_t *)"counter", 0, 1, &counter);
+    OSAL_queue_create((uint8_t *)"queue", 1, &queue);
+
+    bool ok = true;
+    uint32_t early = 0;
+    uint32_t max_overshoot = 0;
+    for (uint32_t t = 0; t < sizeof(timeouts) / sizeof(timeouts[0]); t++)
+    {
+        uint32_t timeout = timeouts[t];
+        uint32_t min = UINT32_MAX;
+        uint32_t max = 0;
+        uint64_t sum = 0;
+        uint32_t count = 0;
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            for (uint32_t kind = 0; kind < 3; kind++)
+            {
+                void *msg = NULL;
+                OSAL_status_t status;
+                uint32_t start = osal_bench_time_us();
+                if (kind == 0)
+                {
+                    status = OSAL_binary_semaphore_take(&binary, timeout);
+                }
+                else if (kind == 1)
+                {
+                    status = OSAL_counter_semaphore_take(&counter, timeout);
+                }
+                else
+                {
+                    status = OSAL_queue_fetch(&queue, &msg, timeout);
+                }
+                uint32_t elapsed = osal_bench_time_us() - start;
+                if (status == OSAL_OK || elapsed < timeout * 1000)
+                {
+                    early++;
+                }
+                uint32_t overshoot = elapsed > timeout * 1000 ? elapsed - timeout * 1000 : 0;
+                min = overshoot < min ? overshoot : min;
+                max = overshoot > max ? overshoot : max;
+                sum += overshoot;
+                count++;
+            }
+        }
+        max_overshoot = max > max_overshoot ? max : max_overshoot;
+        printf("  timeout %2lu ms   overshoot    min %6lu us  avg %6lu us  max %6lu us\n", (unsigned long)timeout,
+               (unsigned long)min, (unsigned long)(sum / count), (unsigned long)max);
+    }
+    printf("  early or successful timeouts %lu\n", (unsigned long)early);
+
+    OSAL_queue_delete(&queue);
+    OSAL_counter_semaphore_delete(&counter);
+    OSAL_binary_semaphore_delete(&binary);
+    ok = osal_bench_check(gate, early == 0, "timed wait returned before its timeout") && ok;
+    return osal_bench_check(gate, max_overshoot <= OSAL_BENCH_MAX_OVERSHOOT_US, "overshoot above OSAL_BENCH_MAX_OVERSHOOT_US") && ok;
+}
+
+/*
+ * Random timeout stress: tasks taking a counter semaphore and a mutex with random timeouts while a task gives the
+ * semaphore at random intervals. Checks that no give is lost, that the mutex excludes its holders and that a take
+ * never times out early.
+ */
+
+static OSAL_counter_semaphore_handle_t osal_bench_tokens;
+static OSAL_mutex_handle_t osal_bench_lock;
+static volatile uint32_t osal_bench_holders;
+static uint32_t osal_bench_taken;
+static uint32_t osal_bench_errors;
+
+static void *osal_bench_stress_task(void *args)
+{
+    unsigned int seed = (unsigned int)(uintptr_t)args;
+    for (uint32_t i = 0; i < OSAL_BENCH_STRESS_ITERATIONS; i++)
+    {
+        uint32_t timeout = (uint32_t)(rand_r(&seed) % 4);
+        uint32_t start = osal_bench_time_us();
+        if (OSAL_counter_semaphore_take(&osal_bench_tokens, timeout) == OSAL_OK)
+        {
+            __atomic_fetch_add(&osal_bench_taken, 1, __ATOMIC_RELAXED);
+        }
+        else if (osal_bench_time_us() - start < timeout * 1000)
+        {
+            __atomic_fetch_add(&osal_bench_errors, 1, __ATOMIC_RELAXED);
+        }
+
+        timeout = (uint32_t)(rand_r(&seed) % 3);
+        start = osal_bench_time_us();
+        if (OSAL_mutex_take(&osal_bench_lock, timeout) == OSAL_OK)
+        {
+            if (__atomic_add_fetch(&osal_bench_holders, 1, __ATOMIC_ACQ_REL) != 1)
+            {
+                __atomic_fetch_add(&osal_bench_errors, 1, __ATOMIC_RELAXED);
+            }
+            if (rand_r(&seed) % 4 == 0)
+            {
+                OSAL_sleep(1);
+            }
+            __atomic_sub_fetch(&osal_bench_holders, 1, __ATOMIC_ACQ_REL);
+            OSAL_mutex_give(&osal_bench_lock);
+        }
+        else if (osal_bench_time_us() - start < timeout * 1000)
+        {
+            __atomic_fetch_add(&osal_bench_errors, 1, __ATOMIC_RELAXED);
+        }
+    }
+    return NULL;
+}
+
+static bool osal_bench_random_timeouts(bool gate)
+{
+    OSAL_counter_semaphore_create((uint8_t *)"tokens", 0, 1000000, &osal_bench_tokens);
+    OSAL_mutex_create((uint8_t *)"lock", &osal_bench_lock);
+    osal_bench_taken = 0;
+    osal_bench_errors = 0;
+
+    OSAL_task_handle_t tasks[OSAL_BENCH_STRESS_TASKS];
+    for (uint32_t t = 0; t < OSAL_BENCH_STRESS_TASKS; t++)
+    {
+        tasks[t] = osal_bench_start(osal_bench_stress_task, "stress", (void *)(uintptr_t)(t + 1));
+    }
+    unsigned int seed = 42;
+    uint32_t given = 0;
+    for (uint32_t i = 0; i < OSAL_BENCH_STRESS_ITERATIONS * 2; i++)
+    {
+        uint32_t count = (uint32_t)(rand_r(&seed) % 4);
+        for (uint32_t c = 0; c < count; c++)
+        {
+            OSAL_counter_semaphore_give(&osal_bench_tokens);
+            given++;
+        }
+        if (rand_r(&seed) % 2 == 0)
+        {
+            OSAL_sleep(1);
+        }
+    }
+    // Let the tasks finish their iterations, then count the tokens left
+    OSAL_sleep(OSAL_BENCH_STRESS_ITERATIONS * 10);
+    uint32_t left = 0;
+    while (OSAL_counter_semaphore_take(&osal_bench_tokens, 0) == OSAL_OK)
+    {
+        left++;
+    }
+    for (uint32_t t = 0; t < OSAL_BENCH_STRESS_TASKS; t++)
+    {
+        OSAL_task_delete(&tasks[t]);
+    }
+    OSAL_mutex_delete(&osal_bench_lock);
+    OSAL_counter_semaphore_delete(&osal_bench_tokens);
+
+    uint32_t taken = __atomic_load_n(&osal_bench_taken, __ATOMIC_RELAXED);
+    uint32_t errors = __atomic_load_n(&osal_bench_errors, __ATOMIC_RELAXED);
+    printf("  given %lu  taken %lu  left %lu  errors %lu\n", (unsigned long)given, (unsigned long)taken, (unsigned long)left, (unsigned long)errors);
+    bool ok = osal_bench_check(gate, given == taken + left, "lost or duplicated semaphore gives");
+    return osal_bench_check(gate, errors == 0, "early timeout or mutual exclusion failure") && ok;
+}
+
+/*
+ * Timer jitter: 1000 one-shot timers started together, spread over both levels of the timer wheel, and a periodic
+ * timer. Measures the lateness of each callback. A timer must never expire early.
+ */
+
+static OSAL_timer_storage_t osal_bench_timer_storages[OSAL_BENCH_TIMERS];
+static OSAL_timer_handle_t osal_bench_timers[OSAL_BENCH_TIMERS];
+static uint32_t osal_bench_timer_deadlines[OSAL_BENCH_TIMERS];
+static uint32_t osal_bench_timer_fired;
+static uint32_t osal_bench_timer_early;
+static uint32_t osal_bench_periods;
+
+static void osal_bench_timer_callback(void *arg)
+{
+    uint32_t index = (uint32_t)(uintptr_t)arg;
+    int32_t lateness = (int32_t)(osal_bench_time_us() - osal_bench_timer_deadlines[index]);
+    if (lateness < 0)
+    {
+        osal_bench_timer_early++;
+        lateness = 0;
+    }
+    osal_bench_samples[osal_bench_timer_fired++] = (uint32_t)lateness;
+}
+
+static void osal_bench_periodic_callback(void *arg)
+{
+    osal_bench_periods++;
+}
+
+static bool osal_bench_timer_jitter(bool gate)
+{
+    osal_bench_timer_fired = 0;
+    osal_bench_timer_early = 0;
+    osal_bench_periods = 0;
+    for (uint32_t i = 0; i < OSAL_BENCH_TIMERS; i++)
+    {
+        OSAL_timer_create_static((uint8_t *)"jitter", osal_bench_timer_callback, (void *)(uintptr_t)i, &osal_bench_timer_storages[i], &osal_bench_timers[i]);
+    }
+    OSAL_timer_storage_t periodic_storage;
+    OSAL_timer_handle_t periodic;
+    OSAL_timer_create_static((uint8_t *)"periodic", osal_bench_periodic_callback, NULL, &periodic_storage, &periodic);
+
+    OSAL_timer_start(&periodic, 10, 10);
+    uint32_t start = osal_bench_time_us();
+    for (uint32_t i = 0; i < OSAL_BENCH_TIMERS; i++)
+    {
+        // Spread the delays so that most of the wheel slots hold several timers
+        uint32_t delay = 1 + (i * 7) % OSAL_BENCH_TIMER_MAX_DELAY_MS;
+        osal_bench_timer_deadlines[i] = osal_bench_time_us() + delay * 1000;
+        OSAL_timer_start(&osal_bench_timers[i], delay, 0);
+    }
+    uint32_t start_duration = osal_bench_time_us() - start;
+    OSAL_sleep(OSAL_BENCH_TIMER_MAX_DELAY_MS + 100);
+    OSAL_timer_stop(&periodic);
+    uint32_t elapsed = osal_bench_time_us() - start;
+
+    for (uint32_t i = 0; i < OSAL_BENCH_TIMERS; i++)
+    {
+        OSAL_timer_delete(&osal_bench_timers[i]);
+    }
+    OSAL_timer_delete(&periodic);
+
+    uint32_t fired = osal_bench_timer_fired;
+    printf("  %u timers started in %lu us, fired %lu, early %lu, periods %lu in %lu ms\n", OSAL_BENCH_TIMERS,
+           (unsigned long)start_duration, (unsigned long)fired, (unsigned long)osal_bench_timer_early,
+           (unsigned long)osal_bench_periods, (unsigned long)(elapsed / 1000));
+    bool ok = osal_bench_check(gate, fired == OSAL_BENCH_TIMERS, "timers not fired");
+    ok = osal_bench_check(gate, osal_bench_timer_early == 0, "timer expired early") && ok;
+    // 10 ms period: at least one period lost per 100 ms would show a drifting periodic timer
+    ok = osal_bench_check(gate, osal_bench_periods + elapsed / 100000 >= elapsed / 10000 - 1, "periodic timer drifts") && ok;
+    if (fired > 0)
+    {
+        uint32_t p99 = osal_bench_report_latency("callback lateness", osal_bench_samples, fired);
+        ok = osal_bench_check(gate, p99 <= OSAL_BENCH_MAX_OVERSHOOT_US, "lateness p99 above OSAL_BENCH_MAX_OVERSHOOT_US") && ok;
+    }
+    return ok;
+}
+
+/*
+ * Queue select: several queues served by one task with OSAL_queue_select() against one task per queue. Measures the
+ * time from a post to one of the queues to the service of the message, and compares the RAM of the task stacks.
+ */
+
+static OSAL_queue_handle_t osal_bench_select_queues[OSAL_BENCH_SELECT_QUEUES];
+static OSAL_binary_semaphore_handle_t osal_bench_served;
+
+static void *osal_bench_select_task(void *args)
+{
+    uint32_t index = 0;
+    void *msg = NULL;
+    while (OSAL_queue_select(osal_bench_select_queues, OSAL_BENCH_SELECT_QUEUES, &index, &msg, OSAL_INFINITE_TIME) == OSAL_OK && msg != NULL)
+    {
+        OSAL_binary_semaphore_give(&osal_bench_served);
+    }
+    return NULL;
+}
+
+static void *osal_bench_queue_task(void *args)
+{
+    OSAL_queue_handle_t *queue = (OSAL_queue_handle_t *)args;
+    void *msg = NULL;
+    while (OSAL_queue_fetch(queue, &msg, OSAL_INFINITE_TIME) == OSAL_OK && msg != NULL)
+    {
+        OSAL_binary_semaphore_give(&osal_bench_served);
+    }
+    return NULL;
+}
+
+// Posts to the queues in turn and measures the service latency. Returns the number of messages not served.
+static uint32_t osal_bench_serve(void)
+{
+    uint32_t lost = 0;
+    for (uint32_t i = 0; i < OSAL_BENCH_ROUND_TRIPS; i++)
+    {
+        uint32_t start = osal_bench_time_us();
+        OSAL_queue_post(&osal_bench_select_queues[i % OSAL_BENCH_SELECT_QUEUES], (void *)(uintptr_t)(i + 1));
+        if (OSAL_binary_semaphore_take(&osal_bench_served, 1000) != OSAL_OK)
+        {
+            lost++;
+        }
+        osal_bench_samples[i] = osal_bench_time_us() - start;
+    }
+    return lost;
+}
+
+static bool osal_bench_queue_select(bool gate)
+{
+    OSAL_binary_semaphore_create((uint8_t *)"served", 0, &osal_bench_served);
+    for (uint32_t q = 0; q < OSAL_BENCH_SELECT_QUEUES; q++)
+    {
+        OSAL_queue_create((uint8_t *)"select", 4, &osal_bench_select_queues[q]);
+    }
+
+    // One task serving all the queues
+    OSAL_task_handle_t select_task = osal_bench_start(osal_bench_select_task, "select", NULL);
+    uint32_t lost = osal_bench_serve();
+    OSAL_queue_post(&osal_bench_select_queues[0], NULL);
+    OSAL_task_delete(&select_task);
+    printf("  1 task:  stacks %6lu bytes\n", (unsigned long)OSAL_BENCH_TARGET_STACK_SIZE);
+    uint32_t select_p99 = osal_bench_report_latency("select service", osal_bench_samples, OSAL_BENCH_ROUND_TRIPS);
+
+    // One task per queue
+    OSAL_task_handle_t queue_tasks[OSAL_BENCH_SELECT_QUEUES];
+    for (uint32_t q = 0; q < OSAL_BENCH_SELECT_QUEUES; q++)
+    {
+        queue_tasks[q] = osal_bench_start(osal_bench_queue_task, "queue", &osal_bench_select_queues[q]);
+    }
+    lost += osal_bench_serve();
+    for (uint32_t q = 0; q < OSAL_BENCH_SELECT_QUEUES; q++)
+    {
+        OSAL_queue_post(&osal_bench_select_queues[q], NULL);
+        OSAL_task_delete(&queue_tasks[q]);
+    }
+    printf("  %u tasks: stacks %6lu bytes\n", OSAL_BENCH_SELECT_QUEUES, (unsigned long)(OSAL_BENCH_SELECT_QUEUES * OSAL_BENCH_TARGET_STACK_SIZE));
+    uint32_t tasks_p99 = osal_bench_report_latency("task per queue service", osal_bench_samples, OSAL_BENCH_ROUND_TRIPS);
+
+    for (uint32_t q = 0; q < OSAL_BENCH_SELECT_QUEUES; q++)
+    {
+        OSAL_queue_delete(&osal_bench_select_queues[q]);
+    }
+    OSAL_binary_semaphore_delete(&osal_bench_served);
+
+    bool ok = osal_bench_check(gate, lost == 0, "messages not served");
+    ok = osal_bench_check(gate, select_p99 <= OSAL_BENCH_MAX_P99_LATENCY_US, "select p99 above OSAL_BENCH_MAX_P99_LATENCY_US") && ok;
+    return osal_bench_check(gate, tasks_p99 <= OSAL_BENCH_MAX_P99_LATENCY_US, "task per queue p99 above OSAL_BENCH_MAX_P99_LATENCY_US") && ok;
+}
+
+/*
+ * Spin budget: tasks taking a mutex held for a given time, for several spin budgets. Spinning only pays off when the
+ * holder runs on another CPU and releases the mutex within the budget.
+ */
+
+static OSAL_mutex_handle_t osal_bench_spin_mutex;
+static uint32_t osal_bench_spin_hold_us;
+static uint32_t osal_bench_spin_inside;
+static uint32_t osal_bench_spin_errors;
+static uint64_t osal_bench_spin_wait_us;
+
+static void osal_bench_busy_wait(uint32_t duration_us)
+{
+    uint32_t start = osal_bench_time_us();
+    while (osal_bench_time_us() - start < duration_us)
+    {
+    }
+}
+
+static void *osal_bench_spin_task(void *args)
+{
+    uint64_t wait_us = 0;
+    for (uint32_t i = 0; i < OSAL_BENCH_SPIN_TAKES; i++)
+    {
+        uint32_t start = osal_bench_time_us();
+        if (OSAL_mutex_take(&osal_bench_spin_mutex, OSAL_INFINITE_TIME) != OSAL_OK)
+        {
+            __atomic_fetch_add(&osal_bench_spin_errors, 1, __ATOMIC_RELAXED);
+            continue;
+        }
+        wait_us += osal_bench_time_us() - start;
+        if (__atomic_add_fetch(&osal_bench_spin_inside, 1, __ATOMIC_ACQ_REL) != 1)
+        {
+            __atomic_fetch_add(&osal_bench_spin_errors, 1, __ATOMIC_RELAXED);
+        }
+        osal_bench_busy_wait(osal_bench_spin_hold_us);
+        __atomic_sub_fetch(&osal_bench_spin_inside, 1, __ATOMIC_ACQ_REL);
+        OSAL_mutex_give(&osal_bench_spin_mutex);
+        // Work outside of the mutex, as long as inside
+        osal_bench_busy_wait(osal_bench_spin_hold_us);
+    }
+    __atomic_fetch_add(&osal_bench_spin_wait_us, wait_us, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+static bool osal_bench_spin_budget(bool gate)
+{
+    static const uint32_t holds_us[] = {0, 2, 10, 50};
+    static const uint32_t budgets[] = {0, 64, 256, 1024};
+    printf("  %ld CPU(s), %u tasks, takes/s and average wait per take\n", sysconf(_SC_NPROCESSORS_ONLN), OSAL_BENCH_SPIN_TASKS);
+    printf("  hold   ");
+    for (uint32_t b = 0; b < sizeof(budgets) / sizeof(budgets[0]); b++)
+    {
+        printf("     budget %4lu     ", (unsigned long)budgets[b]);
+    }
+    printf("\n");
+
+    uint32_t errors = 0;
+    for (uint32_t h = 0; h < sizeof(holds_us) / sizeof(holds_us[0]); h++)
+    {
+        printf("  %3lu us ", (unsigned long)holds_us[h]);
+        for (uint32_t b = 0; b < sizeof(budgets) / sizeof(budgets[0]); b++)
+        {
+            OSAL_mutex_create((uint8_t *)"spin", &osal_bench_spin_mutex);
+            OSAL_mutex_set_spin_budget(&osal_bench_spin_mutex, budgets[b]);
+            osal_bench_spin_hold_us = holds_us[h];
+            osal_bench_spin_inside = 0;
+            osal_bench_spin_errors = 0;
+            osal_bench_spin_wait_us = 0;
+
+            OSAL_task_handle_t tasks[OSAL_BENCH_SPIN_TASKS];
+            uint32_t start = osal_bench_time_us();
+            for (uint32_t t = 0; t < OSAL_BENCH_SPIN_TASKS; t++)
+            {
+                tasks[t] = osal_bench_start(osal_bench_spin_task, "spin", NULL);
+            }
+            for (uint32_t t = 0; t < OSAL_BENCH_SPIN_TASKS; t++)
+            {
+                OSAL_task_delete(&tasks[t]);
+            }
+            uint32_t elapsed = osal_bench_time_us() - start;
+            OSAL_mutex_delete(&osal_bench_spin_mutex);
+
+            uint32_t takes = OSAL_BENCH_SPIN_TASKS * OSAL_BENCH_SPIN_TAKES;
+            printf(" %8lu/s %6lu us", (unsigned long)(((uint64_t)takes * 1000000) / (elapsed == 0 ? 1 : elapsed)),
+                   (unsigned long)(osal_bench_spin_wait_us / takes));
+            errors += osal_bench_spin_errors;
+        }
+        printf("\n");
+    }
+    return osal_bench_check(gate, errors == 0, "mutex take failure or mutual exclusion failure");
+}
+
+static const osal_bench_t osal_benchmarks[] = {
+    {"queue_ping_pong", osal_bench_queue_ping_pong},
+    {"queue_producers", osal_bench_queue_producers},
+    {"semaphore_handoff", osal_bench_semaphore_handoff},
+    {"timed_wait", osal_bench_timed_wait},
+    {"random_timeouts", osal_bench_random_timeouts},
+    {"timer_jitter", osal_bench_timer_jitter},
+    {"queue_select", osal_bench_queue_select},
+    {"spin_budget", osal_bench_spin_budget},
+};
+
+int main(int argc, char **argv)
+{
+    return osal_bench_main(argc, argv, osal_benchmarks, sizeof(osal_benchmarks) / sizeof(osal_benchmarks[0]), osal_bench_stack, OSAL_BENCH_PRIORITY);
+}
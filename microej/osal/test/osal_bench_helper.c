@@ -0,0 +1,134 @@
+/*
+ * C
+ *
+ * Copyright 2019 IS2T. All rights reserved
+ * This library is provided in source code for use, modification and test, subject to license terms
+ * Any modification of the source code will break IS2T warranties on the whole library
+ */
+
+/**
+ * @file
+ * @brief Helpers shared by the host benchmarks of the OSAL and of the libraries built on it
+ * @author MicroEJ Developer Team
+ * @version 0.1.0
+ * @date 17 October 2026
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "osal.h"
+#include "osal_bench_helper.h"
+
+static int osal_bench_argc;
+static char **osal_bench_argv;
+static const osal_bench_t *osal_bench_benchmarks;
+static size_t osal_bench_count;
+static int osal_bench_failures;
+static OSAL_binary_semaphore_handle_t osal_bench_go;
+static OSAL_binary_semaphore_handle_t osal_bench_done;
+
+uint32_t osal_bench_time_us(void)
+{
+    uint32_t now = 0;
+    OSAL_get_time_us(&now);
+    return now;
+}
+
+static int osal_bench_compare(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+uint32_t osal_bench_report_latency(const char *name, uint32_t *samples, uint32_t count)
+{
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        sum += samples[i];
+    }
+    qsort(samples, count, sizeof(uint32_t), osal_bench_compare);
+    uint32_t p99 = samples[(count * 99) / 100];
+    printf("  %-28s avg %6lu us  p50 %6lu us  p99 %6lu us  max %6lu us\n", name, (unsigned long)(sum / count),
+           (unsigned long)samples[count / 2], (unsigned long)p99, (unsigned long)samples[count - 1]);
+    return p99;
+}
+
+bool osal_bench_check(bool gate, bool ok, const char *what)
+{
+    if (gate && !ok)
+    {
+        printf("  FAIL: %s\n", what);
+    }
+    return !gate || ok;
+}
+
+// Runs the selected benchmarks.
+static void *osal_bench_main_task(void *args)
+{
+    // Wait for the end of the task creation: a real-time task would otherwise run to completion first
+    OSAL_binary_semaphore_take(&osal_bench_go, OSAL_INFINITE_TIME);
+    bool gate = false;
+    int first = 1;
+    if (osal_bench_argc > 1 && strcmp(osal_bench_argv[1], "-g") == 0)
+    {
+        gate = true;
+        first = 2;
+    }
+
+    for (size_t b = 0; b < osal_bench_count; b++)
+    {
+        bool selected = (first == osal_bench_argc);
+        for (int a = first; a < osal_bench_argc; a++)
+        {
+            selected = selected || (strcmp(osal_bench_argv[a], osal_bench_benchmarks[b].name) == 0);
+        }
+        if (selected)
+        {
+            printf("%s\n", osal_bench_benchmarks[b].name);
+            fflush(stdout);
+            if (!osal_bench_benchmarks[b].function(gate))
+            {
+                osal_bench_failures++;
+            }
+        }
+    }
+    if (gate)
+    {
+        if (osal_bench_failures == 0)
+        {
+            printf("PASS\n");
+        }
+        else
+        {
+            printf("FAIL: %d benchmark(s)\n", osal_bench_failures);
+        }
+    }
+    OSAL_binary_semaphore_give(&osal_bench_done);
+    return NULL;
+}
+
+int osal_bench_main(int argc, char **argv, const osal_bench_t *benchmarks, size_t count, OSAL_task_stack_t stack, int32_t priority)
+{
+    osal_bench_argc = argc;
+    osal_bench_argv = argv;
+    osal_bench_benchmarks = benchmarks;
+    osal_bench_count = count;
+    osal_bench_failures = 0;
+    OSAL_task_handle_t task = NULL;
+    if (OSAL_binary_semaphore_create((uint8_t *)"go", 0, &osal_bench_go) != OSAL_OK ||
+        OSAL_binary_semaphore_create((uint8_t *)"done", 0, &osal_bench_done) != OSAL_OK ||
+        OSAL_task_create(osal_bench_main_task, (uint8_t *)"bench", stack, priority, NULL, &task) != OSAL_OK)
+    {
+        printf("cannot create task bench\n");
+        return 2;
+    }
+    OSAL_binary_semaphore_give(&osal_bench_go);
+    OSAL_binary_semaphore_take(&osal_bench_done, OSAL_INFINITE_TIME);
+    return osal_bench_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,99 @@
+/*
+ * C
+ *
+ * Copyright 2019 IS2T. All rights reserved
+ * This library is provided in source code for use, modification and test, subject to license terms
+ * Any modification of the source code will break IS2T warranties on the whole library
+ */
+
+/**
+ * @file
+ * @brief Helpers shared by the host benchmarks of the OSAL and of the libraries built on it
+ * @author MicroEJ Developer Team
+ * @version 0.1.0
+ * @date 17 October 2026
+ *
+ * A benchmark program declares a table of benchmarks and calls osal_bench_main() from main(). The usage of the
+ * program is then: program [-g] [benchmark...]. Without benchmark name, all the benchmarks are run. With -g, each
+ * benchmark compares its results to its thresholds and the program exits with a non-zero status if one of them is
+ * exceeded (regression gate).
+ */
+
+#ifndef OSAL_BENCH_HELPER_H
+#define OSAL_BENCH_HELPER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "osal.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * @brief Runs a benchmark.
+ *
+ * @param[in] gate true to check the results against the thresholds of the benchmark.
+ *
+ * @return false if the gate is enabled and a threshold is exceeded, true otherwise.
+ */
+typedef bool (*osal_bench_function_t)(bool gate);
+
+typedef struct
+{
+    const char *name;
+    osal_bench_function_t function;
+} osal_bench_t;
+
+/**
+ * @brief Returns the current OSAL time in microseconds.
+ */
+uint32_t osal_bench_time_us(void);
+
+/**
+ * @brief Sorts the samples, prints their distribution and returns their 99th percentile.
+ *
+ * @param[in] name the name printed before the distribution.
+ * @param[in,out] samples the samples in microseconds, sorted on return.
+ * @param[in] count the number of samples, not 0.
+ *
+ * @return the 99th percentile of the samples.
+ */
+uint32_t osal_bench_report_latency(const char *name, uint32_t *samples, uint32_t count);
+
+/**
+ * @brief Checks a result of a benchmark. Prints a failure when the gate is enabled and the result is wrong.
+ *
+ * @param[in] gate true if the regression gate is enabled.
+ * @param[in] ok the result of the check.
+ * @param[in] what the description of the failure.
+ *
+ * @return false if the gate is enabled and the result is wrong, true otherwise.
+ */
+bool osal_bench_check(bool gate, bool ok, const char *what);
+
+/**
+ * @brief Runs the benchmarks selected by the command line on a task created with the given stack and priority, then
+ * prints the result of the gate.
+ *
+ * The benchmarks run on a task rather than on the main thread: with real-time scheduling, the main thread would be
+ * starved by the benchmark tasks that yield in a loop.
+ *
+ * @param[in] argc the argument count of main().
+ * @param[in] argv the arguments of main().
+ * @param[in] benchmarks the benchmarks of the program.
+ * @param[in] count the number of benchmarks.
+ * @param[in] stack the stack of the task, declared with OSAL_task_stack_declare().
+ * @param[in] priority the priority of the task, usually the priority of the benchmark tasks.
+ *
+ * @return the exit status of the program: 0 on success, 1 if a benchmark failed its gate, 2 on error.
+ */
+int osal_bench_main(int argc, char **argv, const osal_bench_t *benchmarks, size_t count, OSAL_task_stack_t stack, int32_t priority);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OSAL_BENCH_HELPER_H
@@ -17,12 +17,12 @@
 #include <string.h>
 #include <time.h>
 #include <pthread.h>
-#include <semaphore.h>
 #include <arch/board/board.h>
 #include <arch/chip/pin.h>
 
 #include "LLDISPLAY_impl.h"
 #include "LLDISPLAY_EXTRA_impl.h"
+#include "osal.h"
 
 struct fb_videoinfo_s vinfo;
 struct lcd_planeinfo_s pinfo;
@@ -33,11 +33,16 @@ struct lcd_dev_s *dev;
 #define LCD_BPP 16
 uint8_t DISPLAY_BUFFER[LCD_WIDTH * LCD_HEIGHT * LCD_BPP / 8];
 
+// Events of the flush task
+#define DISPLAY_EVENT_FLUSH_REQUEST (1 << 0)
+#define DISPLAY_EVENT_FLUSH_DONE (1 << 1)
+#define DISPLAY_EVENT_SHUTDOWN (1 << 2)
+
 volatile uint8_t microui_is_running = 0;
 static volatile int y_min, y_max;
 
-sem_t flush_sem;
-sem_t sync_sem;
+static OSAL_event_group_storage_declare(display_events_storage);
+static OSAL_event_group_handle_t display_events;
 
 // There is no place to call finalize currently
 void lcd_finalize()
@@ -45,10 +50,8 @@ void lcd_finalize()
     if (microui_is_running)
     {
         microui_is_running = 0;
-        sem_post(&flush_sem);
-        int result = sem_destroy(&flush_sem);
-        result = sem_destroy(&sync_sem) || result;
-        if (result != 0)
+        // the flush task exits on this event, the event group is kept for its last wait
+        if (OSAL_OK != OSAL_event_group_set(&display_events, DISPLAY_EVENT_SHUTDOWN))
         {
             puts("Error during lcd_finalize");
         }
@@ -62,33 +65,24 @@ static void lcd_flush(void)
     {
         pinfo.putrun(i, 0, DISPLAY_BUFFER + (i * LCD_WIDTH) * (LCD_BPP / 8), LCD_WIDTH);
     }
-    int value;
-    sem_getvalue(&sync_sem, &value);
-    if (value <= 0)
-    {
-        sem_post(&sync_sem);
-    }
+    OSAL_event_group_set(&display_events, DISPLAY_EVENT_FLUSH_DONE);
 }
 
 static void lcd_memcpy_func(void)
 {
-    while (microui_is_running)
+    while (1)
     {
-        while (sem_wait(&flush_sem) != 0)
+        // woken up once per flush request or on shutdown
+        uint32_t events;
+        if (OSAL_OK == OSAL_event_group_wait(&display_events, DISPLAY_EVENT_FLUSH_REQUEST | DISPLAY_EVENT_SHUTDOWN,
+                                             OSAL_EVENT_GROUP_WAIT_ANY | OSAL_EVENT_GROUP_CLEAR_ON_EXIT, &events, OSAL_INFINITE_TIME))
         {
-            if (errno == EINTR)
+            if (0 != (events & DISPLAY_EVENT_SHUTDOWN))
             {
-                errno = 0;
+                break;
             }
-        }
-        if (microui_is_running)
-        {
             lcd_flush();
         }
-        else
-        {
-            break;
-        }
     }
 }
 
@@ -108,10 +102,8 @@ void LLDISPLAY_IMPL_initialize()
     assert(LCD_HEIGHT == vinfo.yres);
     assert(LCD_BPP == pinfo.bpp);
 
-    result = sem_init(&flush_sem, 0, 0);
-    assert(result == 0);
-    result = sem_init(&sync_sem, 0, 0);
-    assert(result == 0);
+    result = OSAL_event_group_create_static((uint8_t *)"display", &display_events_storage, &display_events);
+    assert(result == OSAL_OK);
     microui_is_running = 1;
 
     task_create("flush_display", 100, 512, lcd_memcpy_func, NULL);
@@ -134,25 +126,14 @@ int32_t LLDISPLAY_IMPL_getGraphicsBufferAddress()
 
 void LLDISPLAY_IMPL_synchronize()
 {
-    while (sem_wait(&sync_sem) != 0)
-    {
-        if (errno == EINTR)
-        {
-            errno = 0;
-        }
-    }
+    OSAL_event_group_wait(&display_events, DISPLAY_EVENT_FLUSH_DONE, OSAL_EVENT_GROUP_CLEAR_ON_EXIT, NULL, OSAL_INFINITE_TIME);
 }
 
 int32_t LLDISPLAY_IMPL_flush(int32_t sourceAddr, int32_t xmin, int32_t ymin, int32_t xmax, int32_t ymax)
 {
     y_min = ymin;
     y_max = ymax;
-    int value;
-    sem_getvalue(&flush_sem, &value);
-    if (value <= 0)
-    {
-        sem_post(&flush_sem);
-    }
+    OSAL_event_group_set(&display_events, DISPLAY_EVENT_FLUSH_REQUEST);
 
     return sourceAddr;
 }